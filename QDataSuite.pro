@@ -1,7 +1,7 @@
 TEMPLATE = subdirs
 
 CONFIG += ordered
-SUBDIRS = QDataSuite QRestServer QPersistence examples
+SUBDIRS = QDataSuite QRestServer QPersistence examples tests
 
 QRestServer.subdir      = QRestServer
 QRestServer.depends     = QDataSuite
@@ -9,3 +9,5 @@ QPersistence.subdir     = QPersistence
 QPersistence.depends    = QDataSuite
 examples.subdir     = examples
 examples.depends    = QDataSuite QRestServer QPersistence
+tests.subdir        = tests
+tests.depends       = QDataSuite QRestServer QPersistence
@@ -0,0 +1 @@
+#include "../../src/cachepolicy.h"
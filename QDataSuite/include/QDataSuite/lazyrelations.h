@@ -0,0 +1 @@
+#include "../../src/lazyrelations.h"
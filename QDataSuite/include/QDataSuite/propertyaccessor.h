@@ -0,0 +1 @@
+#include "../../src/propertyaccessor.h"
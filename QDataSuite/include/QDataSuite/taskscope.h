@@ -0,0 +1 @@
+#include "../../src/taskscope.h"
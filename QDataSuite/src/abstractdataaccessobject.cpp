@@ -1,19 +1,145 @@
 #include "abstractdataaccessobject.h"
 
 #include "error.h"
+#include "metaobject.h"
+#include "metaproperty.h"
+#include "taskscope.h"
+
+#include <QMutex>
+#include <QRunnable>
+#include <QSet>
+#include <QSharedPointer>
+#include <QThreadPool>
+#include <QThreadStorage>
+#include <QWaitCondition>
+
+#include <algorithm>
 
 namespace QDataSuite {
 
+static bool keyLessThan(const QVariant &left, const QVariant &right)
+{
+    bool leftIsNumber = false;
+    bool rightIsNumber = false;
+    qlonglong leftNumber = left.toLongLong(&leftIsNumber);
+    qlonglong rightNumber = right.toLongLong(&rightIsNumber);
+
+    if(leftIsNumber && rightIsNumber)
+        return leftNumber < rightNumber;
+
+    return left.toString() < right.toString();
+}
+
+static QList<QObject *> readObjectsByKeys(const AbstractDataAccessObject *dataAccessObject, const QList<QVariant> &keys)
+{
+    QList<QObject *> result;
+    foreach(const QVariant &key, keys) {
+        QObject *object = dataAccessObject->readObject(key);
+        if(!object)
+            return QList<QObject *>();
+
+        result.append(object);
+    }
+
+    return result;
+}
+
+// The asynchronous calls of one data access object.
+// Calls, which are still queued, when the data access object is gone, share this state.
+class AsyncCalls
+{
+public:
+    AsyncCalls() :
+        pending(0),
+        finishing(false)
+    {}
+
+    QMutex mutex;
+    QWaitCondition finished;
+    int pending;
+    bool finishing;
+};
+
+class AsyncCall : public QRunnable
+{
+public:
+    AsyncCall(const QSharedPointer<AsyncCalls> &calls,
+              const std::function<void ()> &call,
+              const std::function<void ()> &cancel) :
+        calls(calls),
+        call(call),
+        cancel(cancel)
+    {}
+
+    void run() Q_DECL_OVERRIDE
+    {
+        bool canceled = false;
+        {
+            QMutexLocker locker(&calls->mutex);
+            canceled = calls->finishing;
+        }
+
+        if(canceled) {
+            cancel();
+        }
+        else {
+            TaskScope scope;
+            call();
+        }
+
+        QMutexLocker locker(&calls->mutex);
+        if(--calls->pending == 0)
+            calls->finished.wakeAll();
+    }
+
+private:
+    QSharedPointer<AsyncCalls> calls;
+    std::function<void ()> call;
+    std::function<void ()> cancel;
+};
+
 class AbstractDataAccessObjectPrivate : public QSharedData
 {
 public:
     AbstractDataAccessObjectPrivate() :
-        QSharedData()
+        QSharedData(),
+        asyncCalls(new AsyncCalls)
     {}
 
-    mutable Error lastError;
+    // Each thread has its own error, so that concurrent callers (e.g. the workers
+    // of a server) never see the errors of each other
+    mutable QThreadStorage<Error> lastError;
+
+    QSharedPointer<AsyncCalls> asyncCalls;
 };
 
+static void moveObjectGraphToThread(QObject *object, QThread *thread, QSet<QObject *> &visited)
+{
+    if(!object || visited.contains(object))
+        return;
+
+    visited.insert(object);
+
+    // Objects can only be pushed away from their current thread.
+    // Objects, which already live elsewhere (e.g. cached ones), are left alone.
+    if(object->thread() != QThread::currentThread())
+        return;
+
+    object->moveToThread(thread);
+
+    // Lazy relations, which have not been read yet, are read later by the receiving thread
+    foreach(const MetaProperty property, MetaObject::metaObject(object).relationProperties()) {
+        if(property.isToOneRelationProperty()) {
+            moveObjectGraphToThread(property.peekObject(object), thread, visited);
+        }
+        else if(property.isToManyRelationProperty()) {
+            foreach(QObject *relatedObject, property.peekObjects(object)) {
+                moveObjectGraphToThread(relatedObject, thread, visited);
+            }
+        }
+    }
+}
+
 AbstractDataAccessObject::AbstractDataAccessObject(QObject *parent) :
     QObject(parent),
     d(new AbstractDataAccessObjectPrivate)
@@ -22,16 +148,130 @@ AbstractDataAccessObject::AbstractDataAccessObject(QObject *parent) :
 
 AbstractDataAccessObject::~AbstractDataAccessObject()
 {
+    finishAsyncCalls();
+}
+
+void AbstractDataAccessObject::finishAsyncCalls()
+{
+    QMutexLocker locker(&d->asyncCalls->mutex);
+    d->asyncCalls->finishing = true;
+    while(d->asyncCalls->pending > 0)
+        d->asyncCalls->finished.wait(&d->asyncCalls->mutex);
+}
+
+std::function<void ()> AbstractDataAccessObject::wrapAsyncCall(const std::function<void ()> &call) const
+{
+    return call;
+}
+
+void AbstractDataAccessObject::startAsyncCall(const std::function<void ()> &call,
+                                              const std::function<void ()> &cancel) const
+{
+    {
+        QMutexLocker locker(&d->asyncCalls->mutex);
+        if(d->asyncCalls->finishing) {
+            locker.unlock();
+            cancel();
+            return;
+        }
+
+        ++d->asyncCalls->pending;
+    }
+
+    threadPool()->start(new AsyncCall(d->asyncCalls, wrapAsyncCall(call), cancel));
+}
+
+QList<QObject *> AbstractDataAccessObject::readObjects(int offset, int limit) const
+{
+    // Data access objects, which can not select pages themselves, read the page key by key
+    QList<QVariant> keys = allKeys();
+    std::sort(keys.begin(), keys.end(), keyLessThan);
+
+    return readObjectsByKeys(this, keys.mid(qMax(0, offset), limit));
+}
+
+QList<QObject *> AbstractDataAccessObject::readObjectsAfter(const QVariant &key, int limit) const
+{
+    QList<QVariant> keys = allKeys();
+    std::sort(keys.begin(), keys.end(), keyLessThan);
+
+    QList<QVariant>::const_iterator it = std::upper_bound(keys.constBegin(), keys.constEnd(), key, keyLessThan);
+    return readObjectsByKeys(this, keys.mid(it - keys.constBegin(), limit));
+}
+
+QFuture<int> AbstractDataAccessObject::countAsync() const
+{
+    return runAsync<int>([this]() { return count(); });
+}
+
+QFuture<QList<QVariant> > AbstractDataAccessObject::allKeysAsync() const
+{
+    return runAsync<QList<QVariant> >([this]() { return allKeys(); });
+}
+
+QFuture<QList<QObject *> > AbstractDataAccessObject::readAllObjectsAsync() const
+{
+    return runAsync<QList<QObject *> >([this]() { return readAllObjects(); });
+}
+
+QFuture<QList<QObject *> > AbstractDataAccessObject::readObjectsAsync(int offset, int limit) const
+{
+    return runAsync<QList<QObject *> >([this, offset, limit]() { return readObjects(offset, limit); });
+}
+
+QFuture<QList<QObject *> > AbstractDataAccessObject::readObjectsAfterAsync(const QVariant &key, int limit) const
+{
+    return runAsync<QList<QObject *> >([this, key, limit]() { return readObjectsAfter(key, limit); });
+}
+
+QFuture<QObject *> AbstractDataAccessObject::readObjectAsync(const QVariant &key) const
+{
+    return runAsync<QObject *>([this, key]() { return readObject(key); });
+}
+
+QFuture<bool> AbstractDataAccessObject::insertObjectAsync(QObject *const object)
+{
+    return runAsync<bool>([this, object]() { return const_cast<AbstractDataAccessObject *>(this)->insertObject(object); });
+}
+
+QFuture<bool> AbstractDataAccessObject::updateObjectAsync(QObject *const object)
+{
+    return runAsync<bool>([this, object]() { return const_cast<AbstractDataAccessObject *>(this)->updateObject(object); });
+}
+
+QFuture<bool> AbstractDataAccessObject::removeObjectAsync(QObject *const object)
+{
+    return runAsync<bool>([this, object]() { return const_cast<AbstractDataAccessObject *>(this)->removeObject(object); });
+}
+
+QThreadPool *AbstractDataAccessObject::threadPool()
+{
+    static QThreadPool *pool = 0;
+    static QMutex poolMutex;
+
+    QMutexLocker locker(&poolMutex);
+    if(!pool) {
+        pool = new QThreadPool;
+        pool->setMaxThreadCount(1);
+    }
+
+    return pool;
+}
+
+void AbstractDataAccessObject::moveResultToThread(QObject *object, QThread *thread)
+{
+    QSet<QObject *> visited;
+    moveObjectGraphToThread(object, thread, visited);
 }
 
 Error AbstractDataAccessObject::lastError() const
 {
-    return d->lastError;
+    return d->lastError.localData();
 }
 
 void AbstractDataAccessObject::setLastError(const Error &error) const
 {
-    d->lastError = error;
+    d->lastError.setLocalData(error);
 }
 
 void AbstractDataAccessObject::resetLastError() const
@@ -3,7 +3,14 @@
 
 #include <QtCore/QObject>
 
-#include <QtCore/QSharedDataPointer>
+#include <QtCore/QExplicitlySharedDataPointer>
+#include <QtCore/QFuture>
+#include <QtCore/QFutureInterface>
+#include <QtCore/QThread>
+
+#include <functional>
+
+class QThreadPool;
 
 uint qHash(const QVariant & var);
 
@@ -30,6 +37,30 @@ public:
     virtual bool updateObject(QObject *const object) = 0;
     virtual bool removeObject(QObject *const object) = 0;
 
+    // Pages of objects ordered by their primary key
+    virtual QList<QObject *> readObjects(int offset, int limit) const;
+    virtual QList<QObject *> readObjectsAfter(const QVariant &key, int limit) const;
+
+    // Asynchronous variants, which run on the threadPool().
+    // Read objects are moved to the calling thread before the future finishes.
+    // Objects passed to a write are read and changed (e.g. their primary key) by the pool's thread.
+    // The caller keeps owning them, but must neither change nor delete them until the future has finished.
+    // Calls, which have not started, when the data access object is destroyed, are canceled.
+    QFuture<int> countAsync() const;
+    QFuture<QList<QVariant> > allKeysAsync() const;
+    QFuture<QList<QObject *> > readAllObjectsAsync() const;
+    QFuture<QList<QObject *> > readObjectsAsync(int offset, int limit) const;
+    QFuture<QList<QObject *> > readObjectsAfterAsync(const QVariant &key, int limit) const;
+    QFuture<QObject *> readObjectAsync(const QVariant &key) const;
+    QFuture<bool> insertObjectAsync(QObject *const object);
+    QFuture<bool> updateObjectAsync(QObject *const object);
+    QFuture<bool> removeObjectAsync(QObject *const object);
+
+    // The pool has a single thread by default, because SQLite serializes writers anyway
+    static QThreadPool *threadPool();
+
+    // The error of the last call in the current thread. Asynchronous calls set the error
+    // of the pool's thread, so their callers check the result of the future instead.
     QDataSuite::Error lastError() const;
 
 Q_SIGNALS:
@@ -42,9 +73,48 @@ protected:
     void setLastError(const QDataSuite::Error &error) const;
     void resetLastError() const;
 
+    // Waits for the running asynchronous calls and cancels the queued ones. Subclasses, which
+    // implement the virtual methods, call this first in their destructor.
+    void finishAsyncCalls();
+
+    // Lets subclasses run an asynchronous call in the context of the calling thread (e.g. its session).
+    // This is called in the calling thread.
+    virtual std::function<void ()> wrapAsyncCall(const std::function<void ()> &call) const;
+
+    template<class R, class Function>
+    QFuture<R> runAsync(Function function) const
+    {
+        QFutureInterface<R> future;
+        future.reportStarted();
+
+        QThread *callerThread = QThread::currentThread();
+        startAsyncCall([future, function, callerThread]() mutable {
+            R result = function();
+            AbstractDataAccessObject::moveResultToThread(result, callerThread);
+            future.reportResult(result);
+            future.reportFinished();
+        }, [future]() mutable {
+            future.reportResult(R());
+            future.reportCanceled();
+            future.reportFinished();
+        });
+
+        return future.future();
+    }
+
+    template<class V>
+    static void moveResultToThread(const V &, QThread *) {}
+    template<class O>
+    static void moveResultToThread(O *object, QThread *thread) { moveResultToThread(static_cast<QObject *>(object), thread); }
+    template<class O>
+    static void moveResultToThread(const QList<O *> &objects, QThread *thread) { Q_FOREACH(O *object, objects) moveResultToThread(object, thread); }
+    static void moveResultToThread(QObject *object, QThread *thread);
+
 private:
+    void startAsyncCall(const std::function<void ()> &call, const std::function<void ()> &cancel) const;
+
     Q_DISABLE_COPY(AbstractDataAccessObject)
-    QSharedDataPointer<AbstractDataAccessObjectPrivate> d;
+    QExplicitlySharedDataPointer<AbstractDataAccessObjectPrivate> d;
 };
 
 } // namespace QDataSuite
@@ -11,34 +11,68 @@ namespace QDataSuite {
 template<class T>
 CachedDataAccessObject<T>::CachedDataAccessObject(AbstractDataAccessObject *source, QObject *parent) :
     AbstractDataAccessObject(parent),
+    m_mutex(QMutex::Recursive),
     m_source(source),
     m_cachedCount(-1),
-    m_cachedAll(false)
-{}
+    m_cachedAll(false),
+    m_maximumCount(0),
+    m_maximumSize(0),
+    m_policy(new LruCachePolicy),
+    m_cachedSize(0),
+    m_orphans(new CacheOrphans),
+    m_hits(0),
+    m_misses(0),
+    m_evictions(0)
+{
+    QString className = QLatin1String(T::staticMetaObject.className());
+    Q_FOREACH(const MetaProperty &property, dataSuiteMetaObject().relationProperties()) {
+        if(property.reverseClassName() == className)
+            m_selfRelations.append(property);
+    }
+}
+
+template<class T>
+CachedDataAccessObject<T>::~CachedDataAccessObject()
+{
+    finishAsyncCalls();
+
+    QMutexLocker locker(&m_mutex);
+    QHashIterator<QVariant, T *> it(m_cache);
+    while(it.hasNext()) {
+        it.next();
+        deleteObject(it.key(), it.value());
+    }
+}
 
 template<class T>
 T *CachedDataAccessObject<T>::getFromCache(const QVariant &key) const
 {
-    if(m_cache.contains(key)) {
-        QSharedPointer<T> p = m_cache.value(key);
-        if(p) {
-            return p.data();
-        }
-        else {
-            m_cache.remove(key);
-        }
+    T *object = m_cache.value(key);
+    if(object) {
+        ++m_hits;
+        m_policy->accessed(key);
+
+        // Lazy relations might have been read since the object has been cached
+        trackReferences(key, object);
+        return object;
     }
 
-    return nullptr;
+    ++m_misses;
+    return 0;
 }
 
 template<class T>
-void CachedDataAccessObject<T>::insertIntoCache(const QVariant &key, T *object) const
+T *CachedDataAccessObject<T>::insertIntoCache(const QVariant &key, T *object) const
 {
     Q_ASSERT(!m_cache.contains(key));
 
-    QSharedPointer<T> p(object);
-    m_cache.insert(key, p);
+    m_cache.insert(key, object);
+
+    qint64 size = estimatedSize(object);
+    m_sizes.insert(key, size);
+    m_cachedSize += size;
+    m_policy->inserted(key);
+    trackReferences(key, object);
 
     if(!m_cachedAll) {
         int c = m_cache.size();
@@ -47,6 +81,182 @@ void CachedDataAccessObject<T>::insertIntoCache(const QVariant &key, T *object)
             m_cachedCount = c;
         }
     }
+
+    return object;
+}
+
+template<class T>
+T *CachedDataAccessObject<T>::cacheReadObject(QObject *object) const
+{
+    T *typedObject = static_cast<T *>(object);
+    QVariant key = dataSuiteMetaObject().primaryKeyProperty().read(typedObject);
+
+    // Objects, which are cached already, keep their identity
+    T *cachedObject = getFromCache(key);
+    if(cachedObject) {
+        if(cachedObject != typedObject)
+            CacheOrphans::dispose(typedObject);
+        return cachedObject;
+    }
+
+    return insertIntoCache(key, typedObject);
+}
+
+template<class T>
+QList<QObject *> CachedDataAccessObject<T>::cacheReadObjects(const QList<QObject *> &objects) const
+{
+    QList<QObject *> result;
+    result.reserve(objects.size());
+    Q_FOREACH(QObject *object, objects) {
+        result.append(cacheReadObject(object));
+    }
+    return result;
+}
+
+template<class T>
+void CachedDataAccessObject<T>::removeFromCache(const QVariant &key) const
+{
+    m_cache.remove(key);
+    m_cachedSize -= m_sizes.take(key);
+    untrackReferences(key);
+}
+
+template<class T>
+void CachedDataAccessObject<T>::deleteObject(const QVariant &key, T *object) const
+{
+    // Someone, who still holds the object through readShared(), deletes it instead
+    QWeakPointer<T> shared = m_shared.take(key);
+    if(m_orphans->adopt(object, shared))
+        return;
+
+    CacheOrphans::dispose(object);
+}
+
+template<class T>
+QList<QObject *> CachedDataAccessObject<T>::relatedObjects(const MetaProperty &property, const QObject *object)
+{
+    // Looking for references must not read a lazy relation
+    if(property.isToOneRelationProperty())
+        return QList<QObject *>() << property.peekObject(object);
+
+    return property.peekObjects(object);
+}
+
+template<class T>
+void CachedDataAccessObject<T>::trackReferences(const QVariant &key, const T *object) const
+{
+    if(m_selfRelations.isEmpty())
+        return;
+
+    QList<const QObject *> references;
+    Q_FOREACH(const MetaProperty &property, m_selfRelations) {
+        Q_FOREACH(QObject *relatedObject, relatedObjects(property, object)) {
+            if(relatedObject && relatedObject != object)
+                references.append(relatedObject);
+        }
+    }
+
+    untrackReferences(key);
+    Q_FOREACH(const QObject *reference, references) {
+        ++m_referenceCounts[reference];
+    }
+
+    if(!references.isEmpty())
+        m_references.insert(key, references);
+}
+
+template<class T>
+void CachedDataAccessObject<T>::untrackReferences(const QVariant &key) const
+{
+    Q_FOREACH(const QObject *reference, m_references.take(key)) {
+        QHash<const QObject *, int>::iterator it = m_referenceCounts.find(reference);
+        if(it != m_referenceCounts.end() && --it.value() <= 0)
+            m_referenceCounts.erase(it);
+    }
+}
+
+template<class T>
+bool CachedDataAccessObject<T>::isReferenced(const QVariant &key, T *object) const
+{
+    if(m_pinned.contains(key)
+            || !m_shared.value(key).isNull()
+            || m_referenceCounts.contains(object)) {
+        return true;
+    }
+
+    // Related objects, which point back to the object, would be left with a dangling pointer
+    Q_FOREACH(const MetaProperty &property, dataSuiteMetaObject().relationProperties()) {
+        if(property.reverseRelationName().isEmpty())
+            continue;
+
+        MetaProperty reverse = property.reverseRelation();
+        Q_FOREACH(QObject *relatedObject, relatedObjects(property, object)) {
+            if(relatedObject
+                    && relatedObjects(reverse, relatedObject).contains(object)) {
+                return true;
+            }
+        }
+    }
+
+    return false;
+}
+
+template<class T>
+void CachedDataAccessObject<T>::evict() const
+{
+    if(m_maximumCount <= 0 && m_maximumSize <= 0)
+        return;
+
+    QSet<QVariant> keptKeys;
+
+    while((m_maximumCount > 0 && m_cache.size() > m_maximumCount)
+          || (m_maximumSize > 0 && m_cachedSize > m_maximumSize)) {
+        QVariant key = m_policy->victim(keptKeys);
+
+        // Everything left is referenced
+        if(!key.isValid())
+            break;
+
+        T *object = m_cache.value(key);
+        if(isReferenced(key, object)) {
+            keptKeys.insert(key);
+            continue;
+        }
+
+        removeFromCache(key);
+        m_policy->evicted(key);
+        deleteObject(key, object);
+        m_cachedAll = false;
+        ++m_evictions;
+    }
+}
+
+template<class T>
+qint64 CachedDataAccessObject<T>::estimatedSize(const T *object) const
+{
+    qint64 size = sizeof(T);
+
+    Q_FOREACH(const MetaProperty &property, dataSuiteMetaObject().simpleProperties()) {
+        QVariant value = property.read(object);
+
+        switch(value.type()) {
+        case QVariant::String:
+            size += sizeof(QVariant) + value.toString().size() * sizeof(QChar);
+            break;
+        case QVariant::ByteArray:
+            size += sizeof(QVariant) + value.toByteArray().size();
+            break;
+        case QVariant::StringList:
+            size += sizeof(QVariant);
+            Q_FOREACH(const QString &string, value.toStringList()) size += string.size() * sizeof(QChar);
+            break;
+        default:
+            size += sizeof(QVariant);
+            break;
+        }
+    }
+
+    return size;
 }
 
 template<class T>
@@ -58,6 +268,7 @@ MetaObject CachedDataAccessObject<T>::dataSuiteMetaObject() const
 template<class T>
 int CachedDataAccessObject<T>::count() const
 {
+    QMutexLocker locker(&m_mutex);
     if(m_cachedCount >= 0)
         return m_cachedCount;
 
@@ -71,6 +282,7 @@ QList<QVariant> CachedDataAccessObject<T>::allKeys() const
 {
     resetLastError();
 
+    QMutexLocker locker(&m_mutex);
     if(m_cachedAll)
         return m_cache.keys();
 
@@ -82,23 +294,28 @@ QList<T *> CachedDataAccessObject<T>::readAll() const
 {
     resetLastError();
 
+    QMutexLocker locker(&m_mutex);
+    evict();
+
     QList<T *> result;
 
     if(m_cachedAll) {
-        Q_FOREACH(QSharedPointer<T> t, m_cache.values()) {
-            result.append(t.data());
+        m_hits += m_cache.size();
+        QHashIterator<QVariant, T *> it(m_cache);
+        while(it.hasNext()) {
+            it.next();
+            m_policy->accessed(it.key());
+            result.append(it.value());
         }
     }
     else {
-        Q_FOREACH(QVariant key, allKeys()) {
-            T *t = getFromCache(key);
+        // One bulk read of the source. Objects, which are cached already, keep their identity.
+        QList<QObject *> objects = m_source->readAllObjects();
+        if(m_source->lastError().isValid())
+            setLastError(m_source->lastError());
 
-            if(!t) {
-                t = static_cast<T *>(m_source->readObject(key));
-                insertIntoCache(key, t);
-            }
-
-            result.append(t);
+        Q_FOREACH(QObject *object, cacheReadObjects(objects)) {
+            result.append(static_cast<T *>(object));
         }
     }
 
@@ -131,14 +348,43 @@ T *CachedDataAccessObject<T>::read(const QVariant &key) const
 {
     resetLastError();
 
-    T *t = getFromCache(key);
+    QMutexLocker locker(&m_mutex);
+    evict();
+
+    T *object = getFromCache(key);
+
+    if(!object) {
+        object = static_cast<T *>(m_source->readObject(key));
+        if(!object) {
+            setLastError(m_source->lastError());
+            return 0;
+        }
+        insertIntoCache(key, object);
+    }
+
+    return object;
+}
 
-    if(!t) {
-        t = static_cast<T *>(m_source->readObject(key));
-        insertIntoCache(key, t);
+template<class T>
+QSharedPointer<T> CachedDataAccessObject<T>::readShared(const QVariant &key) const
+{
+    QMutexLocker locker(&m_mutex);
+    T *object = read(key);
+    if(!object)
+        return QSharedPointer<T>();
+
+    QSharedPointer<T> shared = m_shared.value(key).toStrongRef();
+    if(!shared) {
+        // The last holder deletes the object, if the cache has given it up in the meantime
+        QSharedPointer<CacheOrphans> orphans = m_orphans;
+        shared = QSharedPointer<T>(object, [orphans](T *object) {
+            if(orphans->release(object))
+                CacheOrphans::dispose(object);
+        });
+        m_shared.insert(key, shared);
     }
 
-    return t;
+    return shared;
 }
 
 template<class T>
@@ -148,18 +394,54 @@ QObject *CachedDataAccessObject<T>::readObject(const QVariant &key) const
 }
 
 template<class T>
-bool CachedDataAccessObject<T>::insert(T * const object)
+QList<QObject *> CachedDataAccessObject<T>::readObjects(int offset, int limit) const
 {
     resetLastError();
 
-    if(!m_source->insertObject(object)) {
+    QMutexLocker locker(&m_mutex);
+    evict();
+
+    // The source reads the page at once, the cache only keeps the objects
+    QList<QObject *> objects = m_source->readObjects(offset, limit);
+    if(m_source->lastError().isValid())
         setLastError(m_source->lastError());
-        return false;
-    }
 
-    QVariant key = dataSuiteMetaObject().primaryKeyProperty().read(object);
-    ++m_cachedCount;
-    insertIntoCache(key, object);
+    return cacheReadObjects(objects);
+}
+
+template<class T>
+QList<QObject *> CachedDataAccessObject<T>::readObjectsAfter(const QVariant &key, int limit) const
+{
+    resetLastError();
+
+    QMutexLocker locker(&m_mutex);
+    evict();
+
+    QList<QObject *> objects = m_source->readObjectsAfter(key, limit);
+    if(m_source->lastError().isValid())
+        setLastError(m_source->lastError());
+
+    return cacheReadObjects(objects);
+}
+
+template<class T>
+bool CachedDataAccessObject<T>::insert(T * const object)
+{
+    resetLastError();
+
+    {
+        QMutexLocker locker(&m_mutex);
+        evict();
+
+        if(!m_source->insertObject(object)) {
+            setLastError(m_source->lastError());
+            return false;
+        }
+
+        QVariant key = dataSuiteMetaObject().primaryKeyProperty().read(object);
+        ++m_cachedCount;
+        insertIntoCache(key, object);
+    }
 
     emit objectInserted(object);
     return true;
@@ -178,12 +460,22 @@ bool CachedDataAccessObject<T>::update(T *const object)
 {
     resetLastError();
 
-    QVariant key = dataSuiteMetaObject().primaryKeyProperty().read(object);
-    Q_ASSERT(m_cache.contains(key));
+    bool disposeObject = false;
+    {
+        QMutexLocker locker(&m_mutex);
+        QVariant key = dataSuiteMetaObject().primaryKeyProperty().read(object);
 
-    if(!m_source->updateObject(object)) {
-        setLastError(m_source->lastError());
-        return false;
+        if(!m_source->updateObject(object)) {
+            setLastError(m_source->lastError());
+            return false;
+        }
+
+        if(m_sizes.contains(key)) {
+            qint64 size = estimatedSize(object);
+            m_cachedSize += size - m_sizes.value(key);
+            m_sizes.insert(key, size);
+            trackReferences(key, object);
+        }
     }
 
     emit objectUpdated(object);
@@ -202,18 +494,35 @@ template<class T>
 bool CachedDataAccessObject<T>::remove(T *const object)
 {
     resetLastError();
-    QVariant key = dataSuiteMetaObject().primaryKeyProperty().read(object);
-    Q_ASSERT(m_cache.contains(key));
 
-    if(!m_source->removeObject(object)) {
-        setLastError(m_source->lastError());
-        return false;
+    bool disposeObject = false;
+    {
+        QMutexLocker locker(&m_mutex);
+        QVariant key = dataSuiteMetaObject().primaryKeyProperty().read(object);
+
+        if(!m_source->removeObject(object)) {
+            setLastError(m_source->lastError());
+            return false;
+        }
+
+        --m_cachedCount;
+        m_pinCounts.remove(key);
+        m_pinned.remove(key);
+        if(m_cache.value(key) == object) {
+            removeFromCache(key);
+            m_policy->removed(key);
+
+            // Someone, who still holds the object through readShared(), deletes it instead
+            QWeakPointer<T> shared = m_shared.take(key);
+            disposeObject = !m_orphans->adopt(object, shared);
+        }
     }
 
-    --m_cachedCount;
+    // Receivers might lock themselves, so they are called without the lock. They still see the object.
     emit objectRemoved(object);
 
-    m_cache.remove(key);
+    if(disposeObject)
+        CacheOrphans::dispose(object);
     return true;
 }
 
@@ -225,4 +534,125 @@ bool CachedDataAccessObject<T>::removeObject(QObject *const object)
     return remove(t);
 }
 
+template<class T>
+int CachedDataAccessObject<T>::maximumCount() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_maximumCount;
+}
+
+template<class T>
+void CachedDataAccessObject<T>::setMaximumCount(int count)
+{
+    QMutexLocker locker(&m_mutex);
+    m_maximumCount = count;
+    evict();
+}
+
+template<class T>
+qint64 CachedDataAccessObject<T>::maximumSize() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_maximumSize;
+}
+
+template<class T>
+void CachedDataAccessObject<T>::setMaximumSize(qint64 bytes)
+{
+    QMutexLocker locker(&m_mutex);
+    m_maximumSize = bytes;
+    evict();
+}
+
+template<class T>
+CachePolicy *CachedDataAccessObject<T>::cachePolicy() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_policy.data();
+}
+
+template<class T>
+void CachedDataAccessObject<T>::setCachePolicy(CachePolicy *policy)
+{
+    Q_ASSERT(policy);
+
+    QMutexLocker locker(&m_mutex);
+    m_policy.reset(policy);
+    Q_FOREACH(const QVariant &key, m_cache.keys()) {
+        m_policy->inserted(key);
+    }
+}
+
+template<class T>
+void CachedDataAccessObject<T>::pin(const QVariant &key)
+{
+    QMutexLocker locker(&m_mutex);
+    ++m_pinCounts[key];
+    m_pinned.insert(key);
+}
+
+template<class T>
+void CachedDataAccessObject<T>::unpin(const QVariant &key)
+{
+    QMutexLocker locker(&m_mutex);
+    if(!m_pinCounts.contains(key))
+        return;
+
+    if(--m_pinCounts[key] <= 0) {
+        m_pinCounts.remove(key);
+        m_pinned.remove(key);
+    }
+}
+
+template<class T>
+bool CachedDataAccessObject<T>::isPinned(const QVariant &key) const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_pinned.contains(key);
+}
+
+template<class T>
+int CachedDataAccessObject<T>::cachedCount() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_cache.size();
+}
+
+template<class T>
+qint64 CachedDataAccessObject<T>::cachedSize() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_cachedSize;
+}
+
+template<class T>
+int CachedDataAccessObject<T>::hits() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_hits;
+}
+
+template<class T>
+int CachedDataAccessObject<T>::misses() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_misses;
+}
+
+template<class T>
+int CachedDataAccessObject<T>::evictions() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_evictions;
+}
+
+template<class T>
+void CachedDataAccessObject<T>::resetStatistics()
+{
+    QMutexLocker locker(&m_mutex);
+    m_hits = 0;
+    m_misses = 0;
+    m_evictions = 0;
+}
+
 } // namespace QDataSuite
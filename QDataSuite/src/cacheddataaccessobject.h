@@ -2,16 +2,74 @@
 #define QDATASUITE_CACHEDDATAACCESSOBJECT_H
 
 #include <QDataSuite/abstractdataaccessobject.h>
+#include <QDataSuite/cachepolicy.h>
 
+#include <QMutex>
+#include <QScopedPointer>
+#include <QSet>
+#include <QThread>
 #include <QWeakPointer>
 
 namespace QDataSuite {
 
+class MetaProperty;
+
+// Objects, which are still shared through readShared(), when the cache wants to delete them,
+// are deleted by their last holder instead. The orphans outlive the cache for this reason.
+class CacheOrphans
+{
+public:
+    // Returns false, if nobody shares the object anymore, so that the caller has to delete it
+    template<class T>
+    bool adopt(T *object, const QWeakPointer<T> &shared)
+    {
+        QMutexLocker locker(&m_mutex);
+        if(shared.isNull())
+            return false;
+
+        m_objects.insert(object);
+        return true;
+    }
+
+    // Returns true, if the object has been adopted and has to be deleted by the last holder
+    bool release(QObject *object)
+    {
+        QMutexLocker locker(&m_mutex);
+        return m_objects.remove(object);
+    }
+
+    // Pointers, which have been returned by read(), stay valid until the event loop runs again
+    static void dispose(QObject *object)
+    {
+        if(object->thread() != QThread::currentThread()
+                || QThread::currentThread()->loopLevel() > 0) {
+            object->deleteLater();
+        }
+        else {
+            delete object;
+        }
+    }
+
+private:
+    QMutex m_mutex;
+    QSet<QObject *> m_objects;
+};
+
+// By default the cache keeps every object it has read. With a maximum count or size,
+// objects are evicted (and deleted), when nothing refers to them anymore. An object is referenced, while
+// - it is pinned,
+// - someone holds it through readShared(), or
+// - another cached object or one of its related objects refers to it through a relation.
+// Pointers returned by read(), readAll() and the pages stay valid, until the object is evicted,
+// i.e. possibly until the next call of any thread. Use pin() or readShared() to keep objects.
+// Evicted objects are deleted later, if their thread runs an event loop.
+// The cache may be used by several threads at once.
 template<class T>
 class CachedDataAccessObject : public AbstractDataAccessObject
 {
 public:
     explicit CachedDataAccessObject(AbstractDataAccessObject *source, QObject *parent = 0);
+    ~CachedDataAccessObject();
 
     QDataSuite::MetaObject dataSuiteMetaObject() const Q_DECL_OVERRIDE;
 
@@ -20,6 +78,8 @@ public:
     QList<QObject *> readAllObjects() const Q_DECL_OVERRIDE;
     QObject *createObject() const Q_DECL_OVERRIDE;
     QObject *readObject(const QVariant &key) const Q_DECL_OVERRIDE;
+    QList<QObject *> readObjects(int offset, int limit) const Q_DECL_OVERRIDE;
+    QList<QObject *> readObjectsAfter(const QVariant &key, int limit) const Q_DECL_OVERRIDE;
     bool insertObject(QObject *const object) Q_DECL_OVERRIDE;
     bool updateObject(QObject *const object) Q_DECL_OVERRIDE;
     bool removeObject(QObject *const object) Q_DECL_OVERRIDE;
@@ -27,21 +87,80 @@ public:
     QList<T *> readAll() const;
     T *create() const;
     T *read(const QVariant &key) const;
+    QSharedPointer<T> readShared(const QVariant &key) const;
     bool insert(T *const object);
     bool update(T *const object);
     bool remove(T *const object);
 
     void cacheAll();
 
+    int maximumCount() const;
+    void setMaximumCount(int count);
+    qint64 maximumSize() const;
+    void setMaximumSize(qint64 bytes);
+
+    CachePolicy *cachePolicy() const;
+    void setCachePolicy(CachePolicy *policy);
+
+    void pin(const QVariant &key);
+    void unpin(const QVariant &key);
+    bool isPinned(const QVariant &key) const;
+
+    int cachedCount() const;
+    qint64 cachedSize() const;
+
+    int hits() const;
+    int misses() const;
+    int evictions() const;
+    void resetStatistics();
+
+protected:
+    virtual qint64 estimatedSize(const T *object) const;
+
 private:
-    mutable QHash<QVariant, QSharedPointer<T> > m_cache;
+    // Guards everything below. Calls of the source happen while it is locked, too.
+    mutable QMutex m_mutex;
+
+    mutable QHash<QVariant, T *> m_cache;
     AbstractDataAccessObject *m_source;
 
     mutable int m_cachedCount;
     mutable bool m_cachedAll;
 
+    int m_maximumCount;
+    qint64 m_maximumSize;
+    QScopedPointer<CachePolicy> m_policy;
+
+    mutable QHash<QVariant, qint64> m_sizes;
+    mutable qint64 m_cachedSize;
+    QHash<QVariant, int> m_pinCounts;
+    QSet<QVariant> m_pinned;
+
+    // The pointers handed out by readShared(), as long as someone holds them
+    mutable QHash<QVariant, QWeakPointer<T> > m_shared;
+    QSharedPointer<CacheOrphans> m_orphans;
+
+    // The relations of the class to itself. Cached objects, which other cached objects
+    // refer to through them, are counted here, whenever a referring object is cached or updated.
+    QList<MetaProperty> m_selfRelations;
+    mutable QHash<const QObject *, int> m_referenceCounts;
+    mutable QHash<QVariant, QList<const QObject *> > m_references;
+
+    mutable int m_hits;
+    mutable int m_misses;
+    mutable int m_evictions;
+
     T *getFromCache(const QVariant &key) const;
-    void insertIntoCache(const QVariant &key, T *object) const;
+    T *insertIntoCache(const QVariant &key, T *object) const;
+    T *cacheReadObject(QObject *object) const;
+    QList<QObject *> cacheReadObjects(const QList<QObject *> &objects) const;
+    void removeFromCache(const QVariant &key) const;
+    void deleteObject(const QVariant &key, T *object) const;
+    void trackReferences(const QVariant &key, const T *object) const;
+    void untrackReferences(const QVariant &key) const;
+    bool isReferenced(const QVariant &key, T *object) const;
+    static QList<QObject *> relatedObjects(const MetaProperty &property, const QObject *object);
+    void evict() const;
 };
 
 } // namespace QDataSuite
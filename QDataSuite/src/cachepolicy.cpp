@@ -0,0 +1,236 @@
+#include "cachepolicy.h"
+
+#include <QHash>
+#include <QLinkedList>
+
+namespace QDataSuite {
+
+// A list of keys ordered from least to most recently used,
+// which can move single keys in constant time.
+class CacheKeyList
+{
+public:
+    int size() const { return m_keys.size(); }
+    bool contains(const QVariant &key) const { return m_positions.contains(key); }
+
+    void append(const QVariant &key)
+    {
+        remove(key);
+        m_positions.insert(key, m_keys.insert(m_keys.end(), key));
+    }
+
+    void remove(const QVariant &key)
+    {
+        QHash<QVariant, QLinkedList<QVariant>::iterator>::iterator it = m_positions.find(key);
+        if(it == m_positions.end())
+            return;
+
+        m_keys.erase(it.value());
+        m_positions.erase(it);
+    }
+
+    void removeFirst()
+    {
+        if(m_keys.isEmpty())
+            return;
+
+        m_positions.remove(m_keys.first());
+        m_keys.removeFirst();
+    }
+
+    void clear()
+    {
+        m_keys.clear();
+        m_positions.clear();
+    }
+
+    QVariant first(const QSet<QVariant> &excludedKeys) const
+    {
+        foreach(const QVariant &key, m_keys) {
+            if(!excludedKeys.contains(key))
+                return key;
+        }
+
+        return QVariant();
+    }
+
+private:
+    QLinkedList<QVariant> m_keys;
+    QHash<QVariant, QLinkedList<QVariant>::iterator> m_positions;
+};
+
+CachePolicy::~CachePolicy()
+{
+}
+
+class LruCachePolicyPrivate : public QSharedData
+{
+public:
+    LruCachePolicyPrivate() :
+        QSharedData()
+    {}
+
+    CacheKeyList keys;
+};
+
+LruCachePolicy::LruCachePolicy() :
+    d(new LruCachePolicyPrivate)
+{
+}
+
+LruCachePolicy::~LruCachePolicy()
+{
+}
+
+void LruCachePolicy::inserted(const QVariant &key)
+{
+    d->keys.append(key);
+}
+
+void LruCachePolicy::accessed(const QVariant &key)
+{
+    d->keys.append(key);
+}
+
+void LruCachePolicy::evicted(const QVariant &key)
+{
+    d->keys.remove(key);
+}
+
+void LruCachePolicy::removed(const QVariant &key)
+{
+    d->keys.remove(key);
+}
+
+void LruCachePolicy::clear()
+{
+    d->keys.clear();
+}
+
+QVariant LruCachePolicy::victim(const QSet<QVariant> &pinnedKeys) const
+{
+    return d->keys.first(pinnedKeys);
+}
+
+class ArcCachePolicyPrivate : public QSharedData
+{
+public:
+    ArcCachePolicyPrivate() :
+        QSharedData(),
+        target(0)
+    {}
+
+    // Keys, which have been used once (t1) or more often (t2)
+    CacheKeyList t1;
+    CacheKeyList t2;
+
+    // Recently evicted keys from t1 and t2
+    CacheKeyList b1;
+    CacheKeyList b2;
+
+    // The size t1 should have
+    int target;
+
+    int capacity() const;
+    void trimGhosts();
+};
+
+int ArcCachePolicyPrivate::capacity() const
+{
+    // The cache limits itself by count or by size. We take the current number
+    // of cached keys as the capacity, which is what the cache holds, once it is full.
+    return qMax(1, t1.size() + t2.size());
+}
+
+void ArcCachePolicyPrivate::trimGhosts()
+{
+    int c = capacity();
+
+    while(b1.size() > c)
+        b1.removeFirst();
+    while(b2.size() > c)
+        b2.removeFirst();
+
+    target = qMin(target, c);
+}
+
+ArcCachePolicy::ArcCachePolicy() :
+    d(new ArcCachePolicyPrivate)
+{
+}
+
+ArcCachePolicy::~ArcCachePolicy()
+{
+}
+
+void ArcCachePolicy::inserted(const QVariant &key)
+{
+    if(d->b1.contains(key)) {
+        // Recently evicted after a single use: t1 should have been larger
+        d->target = qMin(d->capacity(), d->target + qMax(d->b2.size() / d->b1.size(), 1));
+        d->b1.remove(key);
+        d->t2.append(key);
+    }
+    else if(d->b2.contains(key)) {
+        // Recently evicted after repeated use: t2 should have been larger
+        d->target = qMax(0, d->target - qMax(d->b1.size() / d->b2.size(), 1));
+        d->b2.remove(key);
+        d->t2.append(key);
+    }
+    else {
+        d->t1.append(key);
+    }
+
+    d->trimGhosts();
+}
+
+void ArcCachePolicy::accessed(const QVariant &key)
+{
+    d->t1.remove(key);
+    d->t2.append(key);
+}
+
+void ArcCachePolicy::evicted(const QVariant &key)
+{
+    if(d->t1.contains(key)) {
+        d->t1.remove(key);
+        d->b1.append(key);
+    }
+    else if(d->t2.contains(key)) {
+        d->t2.remove(key);
+        d->b2.append(key);
+    }
+
+    d->trimGhosts();
+}
+
+void ArcCachePolicy::removed(const QVariant &key)
+{
+    d->t1.remove(key);
+    d->t2.remove(key);
+    d->b1.remove(key);
+    d->b2.remove(key);
+}
+
+void ArcCachePolicy::clear()
+{
+    d->t1.clear();
+    d->t2.clear();
+    d->b1.clear();
+    d->b2.clear();
+    d->target = 0;
+}
+
+QVariant ArcCachePolicy::victim(const QSet<QVariant> &pinnedKeys) const
+{
+    bool preferT1 = d->t1.size() > 0
+            && (d->t1.size() > d->target || d->t2.size() == 0);
+
+    QVariant key = preferT1 ? d->t1.first(pinnedKeys) : d->t2.first(pinnedKeys);
+    if(!key.isValid())
+        key = preferT1 ? d->t2.first(pinnedKeys) : d->t1.first(pinnedKeys);
+
+    return key;
+}
+
+} // namespace QDataSuite
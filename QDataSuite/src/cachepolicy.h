@@ -0,0 +1,73 @@
+#ifndef QDATASUITE_CACHEPOLICY_H
+#define QDATASUITE_CACHEPOLICY_H
+
+#include <QDataSuite/abstractdataaccessobject.h>
+
+#include <QtCore/QSet>
+#include <QtCore/QSharedDataPointer>
+#include <QtCore/QVariant>
+
+namespace QDataSuite {
+
+class CachePolicy
+{
+public:
+    virtual ~CachePolicy();
+
+    // A key has been read from the source and is now in the cache
+    virtual void inserted(const QVariant &key) = 0;
+    // A key has been found in the cache
+    virtual void accessed(const QVariant &key) = 0;
+    // A key has been dropped from the cache to make room
+    virtual void evicted(const QVariant &key) = 0;
+    // A key has been removed from the cache, because its object has been removed
+    virtual void removed(const QVariant &key) = 0;
+    virtual void clear() = 0;
+
+    // Returns the key, which should be evicted next, or an invalid QVariant, if there is none.
+    virtual QVariant victim(const QSet<QVariant> &pinnedKeys) const = 0;
+};
+
+class LruCachePolicyPrivate;
+class LruCachePolicy : public CachePolicy
+{
+public:
+    LruCachePolicy();
+    ~LruCachePolicy();
+
+    void inserted(const QVariant &key) Q_DECL_OVERRIDE;
+    void accessed(const QVariant &key) Q_DECL_OVERRIDE;
+    void evicted(const QVariant &key) Q_DECL_OVERRIDE;
+    void removed(const QVariant &key) Q_DECL_OVERRIDE;
+    void clear() Q_DECL_OVERRIDE;
+
+    QVariant victim(const QSet<QVariant> &pinnedKeys) const Q_DECL_OVERRIDE;
+
+private:
+    QSharedDataPointer<LruCachePolicyPrivate> d;
+    Q_DISABLE_COPY(LruCachePolicy)
+};
+
+class ArcCachePolicyPrivate;
+class ArcCachePolicy : public CachePolicy
+{
+public:
+    ArcCachePolicy();
+    ~ArcCachePolicy();
+
+    void inserted(const QVariant &key) Q_DECL_OVERRIDE;
+    void accessed(const QVariant &key) Q_DECL_OVERRIDE;
+    void evicted(const QVariant &key) Q_DECL_OVERRIDE;
+    void removed(const QVariant &key) Q_DECL_OVERRIDE;
+    void clear() Q_DECL_OVERRIDE;
+
+    QVariant victim(const QSet<QVariant> &pinnedKeys) const Q_DECL_OVERRIDE;
+
+private:
+    QSharedDataPointer<ArcCachePolicyPrivate> d;
+    Q_DISABLE_COPY(ArcCachePolicy)
+};
+
+} // namespace QDataSuite
+
+#endif // QDATASUITE_CACHEPOLICY_H
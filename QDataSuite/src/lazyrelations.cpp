@@ -0,0 +1,155 @@
+#include "lazyrelations.h"
+
+#include "metaobject.h"
+#include "metaproperty.h"
+
+#include <QHash>
+#include <QMutex>
+#include <QObject>
+
+namespace QDataSuite {
+
+class PendingRelation
+{
+public:
+    PendingRelation() : resolving(false) {}
+
+    QVariant key;
+    LazyRelations::Resolver resolver;
+    bool resolving;
+};
+
+// The pending relations of one object. They are stored as user data of the object,
+// so that objects without lazy relations cost nothing and the data dies with the object.
+class PendingRelations : public QObjectUserData
+{
+public:
+    // Objects are read and used by several threads
+    QMutex mutex;
+    QHash<QString, PendingRelation> relations;
+
+    static uint userDataId();
+    static PendingRelations *of(const QObject *object);
+};
+
+uint PendingRelations::userDataId()
+{
+    static const uint id = QObject::registerUserData();
+    return id;
+}
+
+PendingRelations *PendingRelations::of(const QObject *object)
+{
+    return static_cast<PendingRelations *>(object->userData(userDataId()));
+}
+
+void LazyRelations::defer(QObject *object,
+                          const MetaProperty &property,
+                          const QVariant &key,
+                          const Resolver &resolver)
+{
+    PendingRelation relation;
+    relation.key = key;
+    relation.resolver = resolver;
+
+    // The thread, which reads the object, defers its relations before anyone else sees the object
+    PendingRelations *relations = PendingRelations::of(object);
+    if(!relations) {
+        relations = new PendingRelations;
+        object->setUserData(PendingRelations::userDataId(), relations);
+    }
+
+    QMutexLocker locker(&relations->mutex);
+    relations->relations.insert(QLatin1String(property.name()), relation);
+}
+
+bool LazyRelations::isPending(const QObject *object, const MetaProperty &property)
+{
+    PendingRelations *relations = PendingRelations::of(object);
+    if(!relations)
+        return false;
+
+    QMutexLocker locker(&relations->mutex);
+    return relations->relations.contains(QLatin1String(property.name()));
+}
+
+QVariant LazyRelations::pendingKey(const QObject *object, const MetaProperty &property)
+{
+    PendingRelations *relations = PendingRelations::of(object);
+    if(!relations)
+        return QVariant();
+
+    QMutexLocker locker(&relations->mutex);
+    return relations->relations.value(QLatin1String(property.name())).key;
+}
+
+bool LazyRelations::resolve(QObject *object, const MetaProperty &property)
+{
+    PendingRelations *relations = PendingRelations::of(object);
+    if(!relations)
+        return true;
+
+    QString name = QLatin1String(property.name());
+    Resolver resolver;
+    {
+        QMutexLocker locker(&relations->mutex);
+        QHash<QString, PendingRelation>::iterator it = relations->relations.find(name);
+
+        // Reading the relation while it is being resolved must not resolve it twice
+        if(it == relations->relations.end() || it->resolving)
+            return true;
+
+        it->resolving = true;
+        resolver = it->resolver;
+    }
+
+    bool ok = resolver(object);
+
+    // Only a resolved relation stops being pending. A failed one is tried again on the next access.
+    QMutexLocker locker(&relations->mutex);
+    QHash<QString, PendingRelation>::iterator it = relations->relations.find(name);
+    if(it != relations->relations.end() && it->resolving) {
+        if(ok)
+            relations->relations.erase(it);
+        else
+            it->resolving = false;
+    }
+
+    return ok;
+}
+
+bool LazyRelations::resolveAll(QObject *object)
+{
+    if(!PendingRelations::of(object))
+        return true;
+
+    bool ok = true;
+    foreach(const MetaProperty property, MetaObject::metaObject(object).relationProperties()) {
+        if(property.isLazy())
+            ok &= resolve(object, property);
+    }
+
+    return ok;
+}
+
+void LazyRelations::discard(const QObject *object, const MetaProperty &property)
+{
+    PendingRelations *relations = PendingRelations::of(object);
+    if(!relations)
+        return;
+
+    QMutexLocker locker(&relations->mutex);
+    relations->relations.remove(QLatin1String(property.name()));
+}
+
+void LazyRelations::discardAll(const QObject *object)
+{
+    PendingRelations *relations = PendingRelations::of(object);
+    if(!relations)
+        return;
+
+    QMutexLocker locker(&relations->mutex);
+    relations->relations.clear();
+}
+
+} // namespace QDataSuite
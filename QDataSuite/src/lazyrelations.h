@@ -0,0 +1,46 @@
+#ifndef QDATASUITE_LAZYRELATIONS_H
+#define QDATASUITE_LAZYRELATIONS_H
+
+#include <QtCore/QVariant>
+
+#include <functional>
+
+class QObject;
+
+namespace QDataSuite {
+
+class MetaProperty;
+
+// Keeps the relations of objects, which are only read on first access.
+// A data access object defers a relation with the key it needs to read it later.
+// MetaProperty::read() resolves a pending relation, before it reads the property.
+// Relations, which are set through MetaProperty::write(), are not pending anymore.
+//
+// Typed getters know nothing about this and return an empty relation, until it has been
+// resolved. Only mark relations as lazy, which are read through MetaProperty, or call
+// resolve() before using the getter.
+class LazyRelations
+{
+public:
+    // Reads the relation and writes it into the object
+    typedef std::function<bool (QObject *object)> Resolver;
+
+    static void defer(QObject *object, const MetaProperty &property, const QVariant &key, const Resolver &resolver);
+    static bool isPending(const QObject *object, const MetaProperty &property);
+    static QVariant pendingKey(const QObject *object, const MetaProperty &property);
+
+    // Returns false, if the relation could not be read. It stays pending then.
+    // Does nothing for relations, which are not pending.
+    static bool resolve(QObject *object, const MetaProperty &property);
+    static bool resolveAll(QObject *object);
+    static void discard(const QObject *object, const MetaProperty &property);
+    // Data access objects call this, before they read a row into an object (again)
+    static void discardAll(const QObject *object);
+
+private:
+    LazyRelations();
+};
+
+} // namespace QDataSuite
+
+#endif // QDATASUITE_LAZYRELATIONS_H
@@ -21,18 +21,71 @@ public:
     static QHash<int, ConverterBase *> convertersByUserType;
     static QHash<QString, ConverterBase *> convertersByClassName;
 
+    // Keyed by "className::propertyName". Accessors live as long as the application,
+    // even when they are replaced.
+    static QHash<QString, PropertyAccessorBase *> propertyAccessors;
+
     static QHash<QString, QHash<QString, AbstractDataAccessObject *> > daoPerConnectionAndMetaObject;
 
-    void parseClassInfo();
+    // These are computed once, when the meta object is registered
+    QString tableName;
+    QString collectionName;
+    QString primaryKeyPropertyName;
+    QList<MetaProperty> simpleProperties;
+    QList<MetaProperty> relationProperties;
+    QHash<QString, MetaProperty> propertiesByName;
+
+    void parseClassInfo(const MetaObject &metaObject);
+    static void resolveRelations();
 };
 
 QHash<QString, MetaObject> MetaObjectPrivate::metaObjects;
+QHash<QString, PropertyAccessorBase *> MetaObjectPrivate::propertyAccessors;
 QHash<int, ConverterBase *> MetaObjectPrivate::convertersByUserType;
 QHash<QString, ConverterBase *> MetaObjectPrivate::convertersByClassName;
 QHash<QString, QHash<QString, AbstractDataAccessObject *> > MetaObjectPrivate::daoPerConnectionAndMetaObject;
 
-void MetaObjectPrivate::parseClassInfo()
+void MetaObjectPrivate::parseClassInfo(const MetaObject &metaObject)
 {
+    tableName = metaObject.classInformation(QDATASUITE_SQL_TABLENAME, QLatin1String(metaObject.className()));
+    collectionName = metaObject.classInformation(QDATASUITE_REST_COLLECTIONNAME, QLatin1String(metaObject.className()));
+    primaryKeyPropertyName = metaObject.classInformation(QDATASUITE_PRIMARYKEY, QString());
+
+    int count = metaObject.propertyCount();
+    for (int i=0; i < count; ++i) {
+        QDataSuite::MetaProperty metaProperty(metaObject.property(i), metaObject);
+        propertiesByName.insert(QLatin1String(metaProperty.name()), metaProperty);
+
+        if(i == 0) // skip "objectName"
+            continue;
+
+        if(!metaProperty.isStored())
+            continue;
+
+        if(metaProperty.isRelationProperty())
+            relationProperties.append(metaProperty);
+        else
+            simpleProperties.append(metaProperty);
+    }
+}
+
+void MetaObjectPrivate::resolveRelations()
+{
+    // Resolve all relations, whose related class is known by now.
+    // Relations to classes, which are registered later, are resolved by their registration.
+    // This way the relation information is never written while the meta objects are in use.
+    foreach(const MetaObject metaObject, metaObjects) {
+        foreach(const MetaProperty property, metaObject.relationProperties()) {
+            if(!metaObjects.contains(property.reverseClassName()))
+                continue;
+
+            if(!property.reverseRelationName().isEmpty()
+                    && !metaObjects.value(property.reverseClassName()).hasMetaProperty(property.reverseRelationName()))
+                continue;
+
+            property.resolveRelation();
+        }
+    }
 }
 
 void MetaObject::registerMetaObject(const QMetaObject &metaObject)
@@ -43,6 +96,7 @@ void MetaObject::registerMetaObject(const QMetaObject &metaObject)
 
     MetaObjectPrivate::metaObjects.insert(QLatin1String(metaObject.className()),
                                           MetaObject(metaObject));
+    MetaObjectPrivate::resolveRelations();
 }
 
 MetaObject MetaObject::metaObject(const QMetaObject *metaObject)
@@ -86,7 +140,8 @@ void MetaObject::registerDataAccessObject(AbstractDataAccessObject *dao, const Q
 
 AbstractDataAccessObject *MetaObject::dataAccessObject(const MetaObject &mo, const QString &connection)
 {
-    return MetaObjectPrivate::daoPerConnectionAndMetaObject[connection][mo.className()];
+    // Called by all threads, so this must not insert anything
+    return MetaObjectPrivate::daoPerConnectionAndMetaObject.value(connection).value(QLatin1String(mo.className()));
 }
 
 QList<MetaObject> MetaObject::registeredMetaObjects()
@@ -100,6 +155,39 @@ void MetaObject::registerConverter(int variantType, ConverterBase *converter)
     MetaObjectPrivate::convertersByClassName.insert(converter->className(), converter);
 }
 
+void MetaObject::registerPropertyAccessor(const QMetaObject &metaObject,
+                                          const char *propertyName,
+                                          PropertyAccessorBase *accessor)
+{
+    int index = metaObject.indexOfProperty(propertyName);
+    Q_ASSERT_X(index >= 0,
+               Q_FUNC_INFO,
+               QString("No such property %1::%2.").arg(metaObject.className()).arg(propertyName).toLatin1());
+    Q_ASSERT_X(metaObject.property(index).userType() == accessor->userType(),
+               Q_FUNC_INFO,
+               QString("The accessor of %1::%2 has the wrong type.").arg(metaObject.className()).arg(propertyName).toLatin1());
+    Q_UNUSED(index);
+
+    // Replaced accessors are never deleted, because copies of the meta property might still use them
+    QString key = QString("%1::%2").arg(metaObject.className()).arg(propertyName);
+    MetaObjectPrivate::propertyAccessors.insert(key, accessor);
+
+    // Properties of a registered meta object share their data with all copies,
+    // which are handed out, so they all use the new accessor from now on.
+    // Properties created later look the accessor up themselves.
+    QString className = QLatin1String(metaObject.className());
+    if(MetaObjectPrivate::metaObjects.contains(className)) {
+        MetaObjectPrivate::metaObjects.value(className)
+                .metaProperty(QLatin1String(propertyName))
+                .setAccessor(accessor);
+    }
+}
+
+PropertyAccessorBase *MetaObject::propertyAccessor(const QString &className, const QString &propertyName)
+{
+    return MetaObjectPrivate::propertyAccessors.value(QString("%1::%2").arg(className).arg(propertyName));
+}
+
 QObject *MetaObject::objectCast(const QVariant &variant)
 {
     Q_ASSERT(MetaObjectPrivate::convertersByUserType.contains(variant.userType()));
@@ -135,7 +223,7 @@ MetaObject::MetaObject(const QMetaObject &metaObject) :
     QMetaObject(metaObject),
     d(new MetaObjectPrivate)
 {
-    d->parseClassInfo();
+    d->parseClassInfo(*this);
 }
 
 MetaObject::MetaObject() :
@@ -167,36 +255,39 @@ MetaObject &MetaObject::operator =(const MetaObject &other)
 
 bool MetaObject::hasMetaProperty(const QString &name) const
 {
-    int index = indexOfProperty(name.toLatin1());
-    return index >= 0;
+    return d->propertiesByName.contains(name);
 }
 
 MetaProperty MetaObject::metaProperty(const QString &name) const
 {
-    int index = indexOfProperty(name.toLatin1());
-
-    Q_ASSERT_X(index >= 0,
+    Q_ASSERT_X(d->propertiesByName.contains(name),
                Q_FUNC_INFO,
                qPrintable(QString("The %1 class has no property %2.")
                           .arg(className())
                           .arg(name)));
 
-    return MetaProperty(property(index), *this);
+    return d->propertiesByName.value(name);
 }
 
 QString MetaObject::tableName() const
 {
-    return MetaObject::classInformation(QDATASUITE_SQL_TABLENAME, QLatin1String(className()));
+    return d->tableName;
 }
 
 QString MetaObject::collectionName() const
 {
-    return MetaObject::classInformation(QDATASUITE_REST_COLLECTIONNAME, QLatin1String(className()));
+    return d->collectionName;
 }
 
 QString MetaObject::primaryKeyPropertyName() const
 {
-    return MetaObject::classInformation(QDATASUITE_PRIMARYKEY, true);
+    Q_ASSERT_X(!d->primaryKeyPropertyName.isEmpty(),
+               Q_FUNC_INFO,
+               qPrintable(QString("The %1 class does not define a %2.")
+                          .arg(className())
+                          .arg(QDATASUITE_PRIMARYKEY)));
+
+    return d->primaryKeyPropertyName;
 }
 
 MetaProperty MetaObject::primaryKeyProperty() const
@@ -206,36 +297,12 @@ MetaProperty MetaObject::primaryKeyProperty() const
 
 QList<MetaProperty> MetaObject::simpleProperties() const
 {
-    QList<MetaProperty> result;
-
-    int count = propertyCount();
-    for (int i=1; i < count; ++i) { // start at 1 because 0 is "objectName"
-        QDataSuite::MetaProperty metaProperty(property(i), *this);
-
-        if(metaProperty.isStored()
-                && !metaProperty.isRelationProperty()) {
-            result.append(metaProperty);
-        }
-    }
-
-    return result;
+    return d->simpleProperties;
 }
 
 QList<MetaProperty> MetaObject::relationProperties() const
 {
-    QList<MetaProperty> result;
-
-    int count = propertyCount();
-    for (int i=1; i < count; ++i) { // start at 1 because 0 is "objectName"
-        QDataSuite::MetaProperty metaProperty(property(i), *this);
-
-        if(metaProperty.isStored()
-                && metaProperty.isRelationProperty()) {
-            result.append(metaProperty);
-        }
-    }
-
-    return result;
+    return d->relationProperties;
 }
 
 QString MetaObject::classInformation(const QString &name, const QString &defaultValue) const
@@ -7,15 +7,23 @@
 #include <QtCore/QVariant>
 #include <QtCore/QSharedDataPointer>
 
+#include <QDataSuite/propertyaccessor.h>
+
 #define QDATASUITE_PRIMARYKEY "QDATASUITE_PRIMARYKEY"
 #define QDATASUITE_SQL_TABLENAME "QDATASUITE_SQL_TABLENAME"
 #define QDATASUITE_REST_COLLECTIONNAME "QDATASUITE_REST_COLLECTIONNAME"
+#define QDATASUITE_REST_VERSIONPROPERTY "QDATASUITE_REST_VERSIONPROPERTY"
+
+#define QDATASUITE_SQL_INDEX "QDATASUITE_SQL_INDEX"
+#define QDATASUITE_SQL_INDEX_COLUMNS "columns"
+#define QDATASUITE_SQL_INDEX_UNIQUE "unique"
 
 #define QDATASUITE_PROPERTYMETADATA "QDATASUITE_PROPERTYMETADATA"
 #define QDATASUITE_PROPERTYMETADATA_REVERSERELATION "reverserelation"
 #define QDATASUITE_PROPERTYMETADATA_AUTOINCREMENTED "autoincremented"
 #define QDATASUITE_PROPERTYMETADATA_READONLY "readonly"
 #define QDATASUITE_PROPERTYMETADATA_SQL_COLUMNNAME "columnname"
+#define QDATASUITE_PROPERTYMETADATA_LAZY "lazy"
 
 #define QDATASUITE_TRUE "true"
 #define QDATASUITE_FALSE "false"
@@ -52,9 +60,14 @@ public:
     QList<MetaProperty> relationProperties() const;
 
 
+    // Register all classes, before their meta objects are used by other threads.
+    // Relations are resolved here, as soon as both of their classes are registered.
     static void registerMetaObject(const QMetaObject &metaObject);
     static QList<MetaObject> registeredMetaObjects();
     static void registerConverter(int variantType, ConverterBase *converter);
+    // Accessors are owned by the meta object system and are registered at startup, too
+    static void registerPropertyAccessor(const QMetaObject &metaObject, const char *propertyName, PropertyAccessorBase *accessor);
+    static PropertyAccessorBase *propertyAccessor(const QString &className, const QString &propertyName);
     static QObject *objectCast(const QVariant &variant);
     static QList<QObject *> objectListCast(const QVariant &variant);
     static QVariant variantCast(QObject *object, const QString &className = QString());
@@ -65,6 +78,7 @@ public:
     static MetaObject metaObject(const QString &className);
     static MetaObject metaObject(const QObject *object);
 
+    // Register data access objects at startup, before other threads look them up
     static void registerDataAccessObject(AbstractDataAccessObject *dao, const QString &connection);
     static AbstractDataAccessObject *dataAccessObject(const MetaObject &mo, const QString &connection);
 
@@ -123,8 +137,36 @@ public:
 
 };
 
+// Registers typed accessors for the properties of a class, e.g.
+// registerMetaObject<Series>()
+//         .property("title", &Series::title, &Series::setTitle)
+//         .property("seasons", &Series::seasons, &Series::setSeasons);
+// Properties without an accessor are read and written through QMetaProperty.
+// MetaProperty::read() and write() use the accessors. Values still cross QSqlQuery and the
+// serializers as QVariant, but without a metacall and without converting values of the right type.
 template<class T>
-void registerMetaObject()
+class MetaObjectBuilder
+{
+public:
+    template<typename V, typename S>
+    MetaObjectBuilder &property(const char *name, V (T::*getter)() const, void (T::*setter)(S))
+    {
+        MetaObject::registerPropertyAccessor(T::staticMetaObject, name,
+                                             new PropertyAccessor<T, V, S>(getter, setter));
+        return *this;
+    }
+
+    template<typename V>
+    MetaObjectBuilder &property(const char *name, V (T::*getter)() const)
+    {
+        MetaObject::registerPropertyAccessor(T::staticMetaObject, name,
+                                             new PropertyAccessor<T, V>(getter));
+        return *this;
+    }
+};
+
+template<class T>
+MetaObjectBuilder<T> registerMetaObject()
 {
     static QObject guard;
     MetaObject::registerMetaObject(T::staticMetaObject);
@@ -135,6 +177,8 @@ void registerMetaObject()
 
     v = QVariant::fromValue<QList<T *> >(QList<T *>());
     MetaObject::registerConverter(v.userType(), converter);
+
+    return MetaObjectBuilder<T>();
 }
 
 template<class T>
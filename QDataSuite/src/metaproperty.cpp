@@ -1,9 +1,9 @@
 #include "metaproperty.h"
 
 #include "metaobject.h"
+#include "lazyrelations.h"
 
 #include <QMetaClassInfo>
-#include <QRegularExpression>
 #include <QStringList>
 #include <QDebug>
 
@@ -13,50 +13,195 @@ class MetaPropertyPrivate : public QSharedData
 {
 public:
     MetaPropertyPrivate() :
-        QSharedData()
+        QSharedData(),
+        isAutoIncremented(false),
+        isReadOnly(false),
+        isPrimaryKey(false),
+        isToOneRelation(false),
+        isToManyRelation(false),
+        isLazy(false),
+        relationResolved(false),
+        accessor(0)
     {}
 
     MetaObject metaObject;
     QHash<QString, QString> attributes;
 
-    MetaProperty *q;
-
-    void parseClassInfo();
+    // Everything, which only depends on the property itself,
+    // is computed once, when the property is created.
+    QString columnName;
+    bool isAutoIncremented;
+    bool isReadOnly;
+    bool isPrimaryKey;
+    bool isToOneRelation;
+    bool isToManyRelation;
+    bool isLazy;
+    QString reverseClassName;
+
+    // Relation information depends on the related class, which might not be registered
+    // yet, when this property is created. It is resolved by MetaObject::registerMetaObject(),
+    // as soon as the related class is registered, and never changes afterwards.
+    class Relation
+    {
+    public:
+        Relation() : cardinality(MetaProperty::NoCardinality) {}
+
+        MetaProperty::Cardinality cardinality;
+        QString columnName;
+        MetaObject reverseMetaObject;
+    };
+
+    bool relationResolved;
+    Relation relation;
+
+    // Looked up when the property is created. Accessors registered later are set by
+    // MetaObject::registerPropertyAccessor(), before the meta object is used.
+    PropertyAccessorBase *accessor;
+
+    void parseClassInfo(const QMetaProperty &property);
+    Relation computeRelation(const MetaProperty &property) const;
 };
 
-void MetaPropertyPrivate::parseClassInfo()
+void MetaPropertyPrivate::parseClassInfo(const QMetaProperty &property)
 {
-    QString classInfoName = QString(QDATASUITE_PROPERTYMETADATA).append(":").append(q->name());
-    QString classInfoRawValue = metaObject.classInformation(classInfoName.toLatin1(), QString());
+    if(!property.isValid())
+        return;
+
+    QString classInfoName = QString(QDATASUITE_PROPERTYMETADATA).append(":").append(property.name());
+    QString classInfoRawValue = metaObject.classInformation(classInfoName, QString());
 
     // First parse the attributes
-    QRegularExpression reg("(\\w+)=(\\w+)");
-    QStringList attributesList = classInfoRawValue.split(';');
+    QStringList attributesList = classInfoRawValue.split(';', QString::SkipEmptyParts);
     foreach(const QString attribute, attributesList) {
-        QRegularExpressionMatch match = reg.match(attribute);
-        if(!match.hasMatch())
+        int index = attribute.indexOf('=');
+        if(index <= 0)
             continue;
 
-        attributes.insert( match.captured(1), match.captured(2) );
+        attributes.insert(attribute.left(index).trimmed(), attribute.mid(index + 1).trimmed());
+    }
+
+    isAutoIncremented = attributes.value(QDATASUITE_PROPERTYMETADATA_AUTOINCREMENTED) == QLatin1String(QDATASUITE_TRUE);
+    isReadOnly = attributes.value(QDATASUITE_PROPERTYMETADATA_READONLY) == QLatin1String(QDATASUITE_TRUE);
+    isPrimaryKey = metaObject.classInformation(QDATASUITE_PRIMARYKEY, QString()) == QLatin1String(property.name());
+
+    // Then the relation type
+    QString typeName(property.typeName());
+    if(typeName.startsWith(QLatin1String("QList<"))
+            && typeName.endsWith(QLatin1String("*>"))) {
+        isToManyRelation = true;
+        reverseClassName = typeName.mid(6, typeName.length() - 8);
     }
+    else if(typeName.endsWith('*')) {
+        isToOneRelation = true;
+        reverseClassName = typeName.left(typeName.length() - 1);
+    }
+
+    isLazy = (isToOneRelation || isToManyRelation)
+            && attributes.value(QDATASUITE_PROPERTYMETADATA_LAZY) == QLatin1String(QDATASUITE_TRUE);
+
+    if(attributes.contains(QDATASUITE_PROPERTYMETADATA_SQL_COLUMNNAME))
+        columnName = attributes.value(QDATASUITE_PROPERTYMETADATA_SQL_COLUMNNAME);
+    else
+        columnName = QString(property.name());
+
+    accessor = MetaObject::propertyAccessor(QLatin1String(metaObject.className()),
+                                            QLatin1String(property.name()));
+}
+
+MetaPropertyPrivate::Relation MetaPropertyPrivate::computeRelation(const MetaProperty &property) const
+{
+    Relation relation;
+    MetaProperty::Cardinality &cardinality = relation.cardinality;
+    QString &relationColumnName = relation.columnName;
+    MetaObject &reverseMetaObject = relation.reverseMetaObject;
+
+    reverseMetaObject = MetaObject::metaObject(reverseClassName);
+    QString reverseName = attributes.value(QDATASUITE_PROPERTYMETADATA_REVERSERELATION);
+
+    // Cardinality
+    if(reverseName.isEmpty()) {
+        if(isToOneRelation)
+            cardinality = MetaProperty::ToOneCardinality;
+        else if(isToManyRelation)
+            cardinality = MetaProperty::ToManyCardinality;
+    }
+    else {
+        MetaProperty reverse = reverseMetaObject.metaProperty(reverseName);
+
+        if(isToOneRelation) {
+            if(!reverse.isValid() ||
+                    QString(reverse.typeName()).isEmpty()) {
+                cardinality = MetaProperty::ToOneCardinality;
+            }
+            else if(reverse.isToOneRelationProperty()) {
+                cardinality = MetaProperty::OneToOneCardinality;
+            }
+            else if(reverse.isToManyRelationProperty()) {
+                cardinality = MetaProperty::ManyToOneCardinality;
+            }
+        }
+        else if(isToManyRelation) {
+            if(!reverse.isValid() ||
+                    QString(reverse.typeName()).isEmpty()) {
+                cardinality = MetaProperty::ToManyCardinality;
+            }
+            else if(reverse.isToManyRelationProperty()) {
+                cardinality = MetaProperty::ManyToManyCardinality;
+            }
+            else if(reverse.isToOneRelationProperty()) {
+                cardinality = MetaProperty::OneToManyCardinality;
+            }
+        }
+    }
+
+    Q_ASSERT_X(cardinality != MetaProperty::NoCardinality, Q_FUNC_INFO,
+               QString("The relation %1 has no cardinality. This is an internal error and should never happen.")
+               .arg(property.name())
+               .toLatin1());
+
+    // Column name
+    if(attributes.contains(QDATASUITE_PROPERTYMETADATA_SQL_COLUMNNAME)) {
+        relationColumnName = attributes.value(QDATASUITE_PROPERTYMETADATA_SQL_COLUMNNAME);
+    }
+    else if(isToManyRelation) {
+        relationColumnName = QString(property.name());
+
+        MetaProperty reverse(property.reverseRelation());
+        if(reverse.isValid()) {
+            relationColumnName = QString(reverse.name());
+        }
+
+        relationColumnName.append("_fk_").append(reverseMetaObject.primaryKeyPropertyName());
+    }
+    else {
+        relationColumnName = QString(property.name())
+                .append("_fk_")
+                .append(reverseMetaObject.primaryKeyPropertyName());
+    }
+
+    return relation;
+}
+
+MetaProperty::MetaProperty() :
+    QMetaProperty(),
+    d(new MetaPropertyPrivate)
+{
 }
 
 MetaProperty::MetaProperty(const QString &propertyName, const MetaObject &metaObject) :
     QMetaProperty(metaObject.property(metaObject.indexOfProperty(propertyName.toLatin1()))),
     d(new MetaPropertyPrivate)
 {
-    d->q = this;
     d->metaObject = metaObject;
-    d->parseClassInfo();
+    d->parseClassInfo(*this);
 }
 
 MetaProperty::MetaProperty(const QMetaProperty &property, const MetaObject &metaObject) :
     QMetaProperty(property),
     d(new MetaPropertyPrivate)
 {
-    d->q = this;
     d->metaObject = metaObject;
-    d->parseClassInfo();
+    d->parseClassInfo(*this);
 }
 
 MetaProperty::~MetaProperty()
@@ -86,119 +231,90 @@ MetaObject MetaProperty::metaObject() const
 
 bool MetaProperty::isAutoIncremented() const
 {
-    return d->attributes.value(QDATASUITE_PROPERTYMETADATA_AUTOINCREMENTED) == QLatin1String(QDATASUITE_TRUE);
+    return d->isAutoIncremented;
 }
 
 QString MetaProperty::columnName() const
 {
-    if(d->attributes.contains(QDATASUITE_PROPERTYMETADATA_SQL_COLUMNNAME))
-        return d->attributes.value(QDATASUITE_PROPERTYMETADATA_SQL_COLUMNNAME);
-
-    if(isToManyRelationProperty()) {
-        QString result = QString(name());
+    if(isRelationProperty()) {
+        if(!d->relationResolved)
+            return d->computeRelation(*this).columnName;
 
-        MetaProperty reverse(reverseRelation());
-        if(reverse.isValid()) {
-            result = QString(reverse.name());
-        }
-
-        result.append("_fk_").append(reverseMetaObject().primaryKeyPropertyName());
-        return result;
-    }
-    else if(isToOneRelationProperty()) {
-        return QString(name())
-                .append("_fk_")
-                .append(reverseMetaObject().primaryKeyPropertyName());
+        return d->relation.columnName;
     }
 
-    return QString(name());
+    return d->columnName;
 }
 
 bool MetaProperty::isReadOnly() const
 {
-    return d->attributes.value(QDATASUITE_PROPERTYMETADATA_READONLY) == QLatin1String(QDATASUITE_TRUE);
+    return d->isReadOnly;
 }
 
 bool MetaProperty::isPrimaryKey() const
 {
-    return d->metaObject.primaryKeyPropertyName() == QLatin1String(name());
+    return d->isPrimaryKey;
 }
 
 bool MetaProperty::isRelationProperty() const
 {
-    return isToOneRelationProperty() || isToManyRelationProperty();
+    return d->isToOneRelation || d->isToManyRelation;
 }
 
 bool MetaProperty::isToOneRelationProperty() const
 {
-    return QString(typeName()).endsWith('*');
+    return d->isToOneRelation;
 }
 
 bool MetaProperty::isToManyRelationProperty() const
 {
-    static QRegularExpression regExp("QList<(\\w+)\\*>");
-    return regExp.match(QLatin1String(typeName())).hasMatch();
+    return d->isToManyRelation;
+}
+
+bool MetaProperty::isLazy() const
+{
+    return d->isLazy;
 }
 
 MetaProperty::Cardinality MetaProperty::cardinality() const
 {
-    QString reverseName = reverseRelationName();
-    if(reverseName.isEmpty()) {
-        if(isToOneRelationProperty())
-            return ToOneCardinality;
-        else if(isToManyRelationProperty())
-            return ToManyCardinality;
-    }
-    else {
-        MetaProperty reverse = reverseMetaObject().metaProperty(reverseName);
+    if(!isRelationProperty())
+        return NoCardinality;
 
-        if(isToOneRelationProperty()) {
-            if(!reverse.isValid() ||
-                    QString(reverse.typeName()).isEmpty()) {
-                return ToOneCardinality;
-            }
-            else if(reverse.isToOneRelationProperty()) {
-                return OneToOneCardinality;
-            }
-            else if(reverse.isToManyRelationProperty()) {
-                return ManyToOneCardinality;
-            }
-        }
-        else if(isToManyRelationProperty()) {
-            if(!reverse.isValid() ||
-                    QString(reverse.typeName()).isEmpty()) {
-                return ToManyCardinality;
-            }
-            else if(reverse.isToManyRelationProperty()) {
-                return ManyToManyCardinality;
-            }
-            else if(reverse.isToOneRelationProperty()) {
-                return OneToManyCardinality;
-            }
-        }
-    }
+    if(!d->relationResolved)
+        return d->computeRelation(*this).cardinality;
 
-    Q_ASSERT_X(false, Q_FUNC_INFO,
-               QString("The relation %1 has no cardinality. This is an internal error and should never happen.")
-               .arg(name())
-               .toLatin1());
-    return NoCardinality;
+    return d->relation.cardinality;
 }
 
 QString MetaProperty::reverseClassName() const
 {
-    QString name(typeName());
-    if(isToOneRelationProperty()) {
-        return name.left(name.length() - 1);
-    }
-
-    static QRegularExpression regExp("QList\\<(\\w*)\\*\\>");
-    return regExp.match(name).captured(1);
+    return d->reverseClassName;
 }
 
 MetaObject MetaProperty::reverseMetaObject() const
 {
-    return MetaObject::metaObject(reverseClassName());
+    if(!d->relationResolved)
+        return d->computeRelation(*this).reverseMetaObject;
+
+    return d->relation.reverseMetaObject;
+}
+
+void MetaProperty::resolveRelation() const
+{
+    if(!isRelationProperty() || d->relationResolved)
+        return;
+
+    // The private is shared by all copies of this property, so they all see the resolved relation
+    MetaPropertyPrivate *data = const_cast<MetaPropertyPrivate *>(d.constData());
+    data->relation = d->computeRelation(*this);
+    data->relationResolved = true;
+}
+
+void MetaProperty::setAccessor(PropertyAccessorBase *accessor) const
+{
+    // Like the relation, the accessor is shared by all copies of this property
+    const_cast<MetaPropertyPrivate *>(d.constData())->accessor = accessor;
 }
 
 QString MetaProperty::reverseRelationName() const
@@ -208,7 +324,7 @@ QString MetaProperty::reverseRelationName() const
 
 MetaProperty MetaProperty::reverseRelation() const
 {
-    return reverseMetaObject().metaProperty(reverseRelationName());
+    return MetaObject::metaObject(reverseClassName()).metaProperty(reverseRelationName());
 }
 
 QString MetaProperty::tableName() const
@@ -273,11 +389,34 @@ QVariant::Type MetaProperty::foreignKeyType() const
     return QVariant::Invalid;
 }
 
+QVariant MetaProperty::read(const QObject *obj) const
+{
+    // Reading a lazy relation is not supposed to change the object from the outside
+    if (d->isLazy)
+        LazyRelations::resolve(const_cast<QObject *>(obj), *this);
+
+    return peek(obj);
+}
+
+QVariant MetaProperty::peek(const QObject *obj) const
+{
+    if (d->accessor)
+        return d->accessor->read(obj);
+
+    return QMetaProperty::read(obj);
+}
+
 bool MetaProperty::write(QObject *obj, const QVariant &value) const
 {
     if (!isWritable())
         return false;
 
+    if (d->isLazy)
+        LazyRelations::discard(obj, *this);
+
+    if (d->accessor)
+        return d->accessor->write(obj, value);
+
     QVariant::Type t = type();
     if (value.canConvert(t)) {
         QVariant v(value);
@@ -288,4 +427,72 @@ bool MetaProperty::write(QObject *obj, const QVariant &value) const
     return QMetaProperty::write( obj, value );
 }
 
+QObject *MetaProperty::readObject(const QObject *obj) const
+{
+    if (d->isLazy)
+        LazyRelations::resolve(const_cast<QObject *>(obj), *this);
+
+    return peekObject(obj);
+}
+
+QList<QObject *> MetaProperty::readObjects(const QObject *obj) const
+{
+    if (d->isLazy)
+        LazyRelations::resolve(const_cast<QObject *>(obj), *this);
+
+    return peekObjects(obj);
+}
+
+QObject *MetaProperty::peekObject(const QObject *obj) const
+{
+    Q_ASSERT(d->isToOneRelation);
+
+    if (d->accessor)
+        return d->accessor->readObject(obj);
+
+    return MetaObject::objectCast(QMetaProperty::read(obj));
+}
+
+QList<QObject *> MetaProperty::peekObjects(const QObject *obj) const
+{
+    Q_ASSERT(d->isToManyRelation);
+
+    if (d->accessor)
+        return d->accessor->readObjects(obj);
+
+    return MetaObject::objectListCast(QMetaProperty::read(obj));
+}
+
+bool MetaProperty::writeObject(QObject *obj, QObject *relatedObject) const
+{
+    Q_ASSERT(d->isToOneRelation);
+
+    if (!isWritable())
+        return false;
+
+    if (d->isLazy)
+        LazyRelations::discard(obj, *this);
+
+    if (d->accessor)
+        return d->accessor->writeObject(obj, relatedObject);
+
+    return QMetaProperty::write(obj, MetaObject::variantCast(relatedObject, d->reverseClassName));
+}
+
+bool MetaProperty::writeObjects(QObject *obj, const QList<QObject *> &relatedObjects) const
+{
+    Q_ASSERT(d->isToManyRelation);
+
+    if (!isWritable())
+        return false;
+
+    if (d->isLazy)
+        LazyRelations::discard(obj, *this);
+
+    if (d->accessor)
+        return d->accessor->writeObjects(obj, relatedObjects);
+
+    return QMetaProperty::write(obj, MetaObject::variantListCast(relatedObjects, d->reverseClassName));
+}
+
 } // namespace QDataSuite
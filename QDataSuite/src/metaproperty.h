@@ -10,6 +10,7 @@ struct QMetaObject;
 namespace QDataSuite {
 
 class MetaObject;
+class PropertyAccessorBase;
 
 class MetaPropertyPrivate;
 class MetaProperty : public QMetaProperty
@@ -25,6 +26,7 @@ public:
         ManyToManyCardinality
     };
 
+    MetaProperty();
     MetaProperty(const QString &propertyName, const MetaObject &metaObject);
     MetaProperty(const QMetaProperty &property, const MetaObject &metaObject);
     ~MetaProperty();
@@ -43,6 +45,8 @@ public:
     bool isToOneRelationProperty() const;
     bool isToManyRelationProperty() const;
     Cardinality cardinality() const;
+    // Lazy relations are read on first access (see LazyRelations)
+    bool isLazy() const;
 
     QString reverseClassName() const;
     MetaObject reverseMetaObject() const;
@@ -52,10 +56,28 @@ public:
     QString tableName() const;
     QVariant::Type foreignKeyType() const;
 
+    // Use the typed accessor of the property, if one has been registered.
+    // read() resolves a pending lazy relation, peek() does not.
+    QVariant read(const QObject *obj) const;
+    QVariant peek(const QObject *obj) const;
     bool write(QObject *obj, const QVariant &value) const;
 
+    // Typed access to relations, which skips the QVariant round trip.
+    // readObject() and readObjects() resolve pending lazy relations, the peek variants do not.
+    QObject *readObject(const QObject *obj) const;
+    QList<QObject *> readObjects(const QObject *obj) const;
+    QObject *peekObject(const QObject *obj) const;
+    QList<QObject *> peekObjects(const QObject *obj) const;
+    bool writeObject(QObject *obj, QObject *relatedObject) const;
+    bool writeObjects(QObject *obj, const QList<QObject *> &relatedObjects) const;
+
 private:
     QSharedDataPointer<MetaPropertyPrivate> d;
+
+    friend class MetaObject;
+    friend class MetaObjectPrivate;
+    void resolveRelation() const;
+    void setAccessor(PropertyAccessorBase *accessor) const;
 };
 
 } // namespace QDataSuite
@@ -0,0 +1,188 @@
+#ifndef QDATASUITE_PROPERTYACCESSOR_H
+#define QDATASUITE_PROPERTYACCESSOR_H
+
+#include <QtCore/QList>
+#include <QtCore/QObject>
+#include <QtCore/QVariant>
+
+#include <type_traits>
+
+namespace QDataSuite {
+
+// Converts the values of relation properties to and from plain QObjects.
+// Other values are no relations and convert to nothing.
+template<typename V>
+struct RelationTraits
+{
+    static QObject *toObject(const V &) { return 0; }
+    static QList<QObject *> toObjects(const V &) { return QList<QObject *>(); }
+    static bool fromObject(QObject *, V *) { return false; }
+    static bool fromObjects(const QList<QObject *> &, V *) { return false; }
+};
+
+template<class O>
+struct RelationTraits<O *>
+{
+    static QObject *toObject(O *value) { return value; }
+    static QList<QObject *> toObjects(O *) { return QList<QObject *>(); }
+
+    static bool fromObject(QObject *object, O **result)
+    {
+        O *typedObject = qobject_cast<O *>(object);
+        if(object && !typedObject)
+            return false;
+
+        *result = typedObject;
+        return true;
+    }
+
+    static bool fromObjects(const QList<QObject *> &, O **) { return false; }
+};
+
+template<class O>
+struct RelationTraits<QList<O *> >
+{
+    static QObject *toObject(const QList<O *> &) { return 0; }
+
+    static QList<QObject *> toObjects(const QList<O *> &value)
+    {
+        QList<QObject *> result;
+        result.reserve(value.size());
+        Q_FOREACH(O *object, value) result.append(object);
+        return result;
+    }
+
+    static bool fromObject(QObject *, QList<O *> *) { return false; }
+
+    static bool fromObjects(const QList<QObject *> &objects, QList<O *> *result)
+    {
+        result->clear();
+        result->reserve(objects.size());
+        Q_FOREACH(QObject *object, objects) {
+            O *typedObject = qobject_cast<O *>(object);
+            if(object && !typedObject)
+                return false;
+
+            result->append(typedObject);
+        }
+        return true;
+    }
+};
+
+// Reads and writes one property by calling its getter and setter directly,
+// instead of going through QMetaObject::metacall().
+class PropertyAccessorBase
+{
+public:
+    virtual ~PropertyAccessorBase() {}
+    virtual int userType() const = 0;
+    virtual bool isWritable() const = 0;
+    virtual QVariant read(const QObject *object) const = 0;
+    virtual bool write(QObject *object, const QVariant &value) const = 0;
+
+    // Relations are read and written as plain QObjects, without a QVariant
+    virtual QObject *readObject(const QObject *object) const = 0;
+    virtual QList<QObject *> readObjects(const QObject *object) const = 0;
+    virtual bool writeObject(QObject *object, QObject *relatedObject) const = 0;
+    virtual bool writeObjects(QObject *object, const QList<QObject *> &relatedObjects) const = 0;
+};
+
+template<class T, typename V, typename S = const typename std::decay<V>::type &>
+class PropertyAccessor : public PropertyAccessorBase
+{
+public:
+    typedef typename std::decay<V>::type Value;
+    typedef V (T::*Getter)() const;
+    typedef void (T::*Setter)(S);
+
+    PropertyAccessor(Getter getter, Setter setter = 0) :
+        m_getter(getter),
+        m_setter(setter)
+    {}
+
+    int userType() const
+    {
+        return qMetaTypeId<Value>();
+    }
+
+    bool isWritable() const
+    {
+        return m_setter != 0;
+    }
+
+    QVariant read(const QObject *object) const
+    {
+        return QVariant::fromValue<Value>((static_cast<const T *>(object)->*m_getter)());
+    }
+
+    bool write(QObject *object, const QVariant &value) const
+    {
+        if(!m_setter)
+            return false;
+
+        T *typedObject = static_cast<T *>(object);
+
+        // Values, which already have the right type, are passed without a conversion
+        if(value.userType() == qMetaTypeId<Value>()) {
+            (typedObject->*m_setter)(*static_cast<const Value *>(value.constData()));
+            return true;
+        }
+
+        // Invalid values write the default value, like QMetaProperty::write() does
+        if(value.isValid() && !value.canConvert<Value>())
+            return false;
+
+        (typedObject->*m_setter)(value.value<Value>());
+        return true;
+    }
+
+    QObject *readObject(const QObject *object) const
+    {
+        return RelationTraits<Value>::toObject(value(static_cast<const T *>(object)));
+    }
+
+    QList<QObject *> readObjects(const QObject *object) const
+    {
+        return RelationTraits<Value>::toObjects(value(static_cast<const T *>(object)));
+    }
+
+    bool writeObject(QObject *object, QObject *relatedObject) const
+    {
+        Value v = Value();
+        if(!m_setter || !RelationTraits<Value>::fromObject(relatedObject, &v))
+            return false;
+
+        (static_cast<T *>(object)->*m_setter)(v);
+        return true;
+    }
+
+    bool writeObjects(QObject *object, const QList<QObject *> &relatedObjects) const
+    {
+        Value v = Value();
+        if(!m_setter || !RelationTraits<Value>::fromObjects(relatedObjects, &v))
+            return false;
+
+        (static_cast<T *>(object)->*m_setter)(v);
+        return true;
+    }
+
+    // Typed access without any QVariant
+    Value value(const T *object) const
+    {
+        return (object->*m_getter)();
+    }
+
+    void setValue(T *object, const Value &value) const
+    {
+        Q_ASSERT(m_setter);
+        (object->*m_setter)(value);
+    }
+
+private:
+    Getter m_getter;
+    Setter m_setter;
+};
+
+} // namespace QDataSuite
+
+#endif // QDATASUITE_PROPERTYACCESSOR_H
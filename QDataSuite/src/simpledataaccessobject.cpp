@@ -14,6 +14,12 @@ SimpleDataAccessObject<T>::SimpleDataAccessObject(QObject *parent) :
     m_metaObject(MetaObject::metaObject(T::staticMetaObject))
 {}
 
+template<class T>
+SimpleDataAccessObject<T>::~SimpleDataAccessObject()
+{
+    finishAsyncCalls();
+}
+
 template<class T>
 MetaObject SimpleDataAccessObject<T>::dataSuiteMetaObject() const
 {
@@ -14,6 +14,7 @@ class SimpleDataAccessObject : public AbstractDataAccessObject
 {
 public:
     SimpleDataAccessObject(QObject *parent = 0);
+    ~SimpleDataAccessObject();
 
     QDataSuite::MetaObject dataSuiteMetaObject() const Q_DECL_OVERRIDE;
 
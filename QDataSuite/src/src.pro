@@ -6,7 +6,7 @@ include($$QDATASUITE_PATH/QDataSuite.pri)
 TARGET          = $$QDATASUITE_TARGET
 VERSION         = $$QDATASUITE_VERSION
 TEMPLATE        = lib
-QT              += sql
+QT              += sql concurrent
 QT              -= gui
 CONFIG          += static c++11
 QMAKE_CXXFLAGS  += $$QDATASUITE_COMMON_QMAKE_CXXFLAGS
@@ -20,11 +20,18 @@ HEADERS += \
     metaobject.h \
     abstractdataaccessobject.h \
     simpledataaccessobject.h \
-    cacheddataaccessobject.h
+    cacheddataaccessobject.h \
+    cachepolicy.h \
+    propertyaccessor.h \
+    lazyrelations.h \
+    taskscope.h
 SOURCES += \
     metaproperty.cpp \
     error.cpp \
     metaobject.cpp \
     abstractdataaccessobject.cpp \
     simpledataaccessobject.cpp \
-    cacheddataaccessobject.cpp
+    cacheddataaccessobject.cpp \
+    cachepolicy.cpp \
+    lazyrelations.cpp \
+    taskscope.cpp
@@ -0,0 +1,73 @@
+#include "taskscope.h"
+
+#include <QAtomicInt>
+#include <QList>
+#include <QMutex>
+#include <QPair>
+#include <QSharedData>
+
+namespace QDataSuite {
+
+class TaskScopePrivate : public QSharedData
+{
+public:
+    TaskScopePrivate() :
+        QSharedData()
+    {}
+
+    // The end hooks of the hooks, which were registered, when the scope began
+    QList<TaskScope::Hook> endHooks;
+
+    static QMutex hooksMutex;
+    static QList<QPair<TaskScope::Hook, TaskScope::Hook> > hooks;
+    static QAtomicInt reservedThreads;
+};
+
+QMutex TaskScopePrivate::hooksMutex;
+QList<QPair<TaskScope::Hook, TaskScope::Hook> > TaskScopePrivate::hooks;
+QAtomicInt TaskScopePrivate::reservedThreads(0);
+
+TaskScope::TaskScope() :
+    d(new TaskScopePrivate)
+{
+    typedef QPair<TaskScope::Hook, TaskScope::Hook> Hooks;
+
+    QList<Hooks> hooks;
+    {
+        QMutexLocker locker(&TaskScopePrivate::hooksMutex);
+        hooks = TaskScopePrivate::hooks;
+    }
+
+    foreach(const Hooks &hook, hooks) {
+        if(hook.first)
+            hook.first();
+
+        if(hook.second)
+            d->endHooks.prepend(hook.second);
+    }
+}
+
+TaskScope::~TaskScope()
+{
+    foreach(const Hook &hook, d->endHooks) {
+        hook();
+    }
+}
+
+void TaskScope::registerHooks(const Hook &begin, const Hook &end)
+{
+    QMutexLocker locker(&TaskScopePrivate::hooksMutex);
+    TaskScopePrivate::hooks.append(qMakePair(begin, end));
+}
+
+void TaskScope::reserveThreads(int count)
+{
+    TaskScopePrivate::reservedThreads.fetchAndAddOrdered(count);
+}
+
+int TaskScope::reservedThreads()
+{
+    return TaskScopePrivate::reservedThreads.load();
+}
+
+} // namespace QDataSuite
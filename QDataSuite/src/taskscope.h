@@ -0,0 +1,39 @@
+#ifndef QDATASUITE_TASKSCOPE_H
+#define QDATASUITE_TASKSCOPE_H
+
+#include <QtCore/QExplicitlySharedDataPointer>
+
+#include <functional>
+
+namespace QDataSuite {
+
+// Brackets one task (e.g. one request) on a pooled thread, which outlives its tasks.
+// Storage backends register hooks, which set up and tear down their per task state,
+// e.g. give the database connection of the thread back to its pool.
+// Create one on the stack for the duration of the task.
+class TaskScopePrivate;
+class TaskScope
+{
+public:
+    typedef std::function<void ()> Hook;
+
+    TaskScope();
+    ~TaskScope();
+
+    // The end hooks run in the reverse order of their registration
+    static void registerHooks(const Hook &begin, const Hook &end);
+
+    // Owners of thread pools (e.g. servers) reserve their threads, so that backends
+    // can size their resources (e.g. connection pools) for all concurrent tasks
+    static void reserveThreads(int count);
+    static int reservedThreads();
+
+private:
+    QExplicitlySharedDataPointer<TaskScopePrivate> d;
+
+    Q_DISABLE_COPY(TaskScope)
+};
+
+} // namespace QDataSuite
+
+#endif // QDATASUITE_TASKSCOPE_H
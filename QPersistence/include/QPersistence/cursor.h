@@ -0,0 +1 @@
+#include "../../src/cursor.h"
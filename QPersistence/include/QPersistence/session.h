@@ -0,0 +1 @@
+#include "../../src/session.h"
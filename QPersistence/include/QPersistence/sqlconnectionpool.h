@@ -0,0 +1 @@
+#include "../../src/sqlconnectionpool.h"
@@ -0,0 +1 @@
+#include "../../src/sqlquerylog.h"
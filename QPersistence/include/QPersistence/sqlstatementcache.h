@@ -0,0 +1 @@
+#include "../../src/sqlstatementcache.h"
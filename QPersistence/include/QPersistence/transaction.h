@@ -0,0 +1 @@
+#include "../../src/transaction.h"
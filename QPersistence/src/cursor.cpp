@@ -0,0 +1,177 @@
+#include "cursor.h"
+
+#include "persistentdataaccessobject.h"
+#include "sqldataaccessobjecthelper.h"
+#include "sqlquery.h"
+
+#include <QDataSuite/error.h>
+
+namespace QPersistence {
+
+class CursorBasePrivate : public QSharedData
+{
+public:
+    CursorBasePrivate() :
+        QSharedData(),
+        dataAccessObject(0),
+        chunkSize(100),
+        recycle(false),
+        opened(false),
+        atEnd(false)
+    {}
+
+    ~CursorBasePrivate()
+    {
+        qDeleteAll(recycledObjects);
+        qDeleteAll(relatedObjects);
+        if(recycle)
+            qDeleteAll(chunk);
+        else
+            qDeleteAll(pending);
+    }
+
+    const PersistentDataAccessObjectBase *dataAccessObject;
+    SqlQuery query;
+    int chunkSize;
+    bool recycle;
+    bool opened;
+    bool atEnd;
+    QDataSuite::Error lastError;
+
+    // The objects of the current chunk, which have not been returned by nextObject() yet
+    QList<QObject *> pending;
+
+    // Only used when recycling
+    QList<QObject *> chunk;
+    QList<QObject *> recycledObjects;
+    QList<QObject *> relatedObjects;
+
+    QList<QObject *> readChunk();
+};
+
+QList<QObject *> CursorBasePrivate::readChunk()
+{
+    QList<QObject *> result;
+    if(atEnd || lastError.isValid())
+        return result;
+
+    SqlDataAccessObjectHelper *helper = dataAccessObject->sqlDataAccessObjectHelper();
+    QDataSuite::MetaObject metaObject = dataAccessObject->dataSuiteMetaObject();
+
+    if(!opened) {
+        opened = true;
+        if(!helper->openCursor(metaObject, &query)) {
+            lastError = helper->lastError();
+            atEnd = true;
+            return result;
+        }
+    }
+
+    // The previous chunk is overwritten by the next one
+    if(recycle) {
+        recycledObjects.append(chunk);
+        chunk.clear();
+    }
+
+    QList<QObject *> newRelatedObjects;
+    if(!helper->readNextObjects(metaObject, dataAccessObject, query, chunkSize,
+                                recycledObjects, result,
+                                recycle ? &newRelatedObjects : 0)) {
+        lastError = helper->lastError();
+        atEnd = true;
+        return result;
+    }
+
+    // The recycled objects do not refer to the old related objects anymore
+    if(recycle) {
+        qDeleteAll(relatedObjects);
+        relatedObjects = newRelatedObjects;
+        chunk = result;
+    }
+
+    if(result.size() < chunkSize)
+        atEnd = true;
+
+    return result;
+}
+
+CursorBase::CursorBase(const PersistentDataAccessObjectBase *dataAccessObject) :
+    d(new CursorBasePrivate)
+{
+    Q_ASSERT(dataAccessObject);
+    d->dataAccessObject = dataAccessObject;
+}
+
+CursorBase::CursorBase(const CursorBase &other) :
+    d(other.d)
+{
+}
+
+CursorBase &CursorBase::operator=(const CursorBase &other)
+{
+    if (this != &other)
+        d.operator=(other.d);
+
+    return *this;
+}
+
+CursorBase::~CursorBase()
+{
+}
+
+int CursorBase::chunkSize() const
+{
+    return d->chunkSize;
+}
+
+void CursorBase::setChunkSize(int chunkSize)
+{
+    Q_ASSERT(!d->opened);
+    d->chunkSize = qMax(1, chunkSize);
+}
+
+bool CursorBase::isRecyclingObjects() const
+{
+    return d->recycle;
+}
+
+void CursorBase::setRecyclingObjects(bool recycle)
+{
+    Q_ASSERT(!d->opened);
+    d->recycle = recycle;
+}
+
+bool CursorBase::atEnd() const
+{
+    return d->pending.isEmpty() && d->atEnd;
+}
+
+QObject *CursorBase::nextObject()
+{
+    if(d->pending.isEmpty())
+        d->pending = d->readChunk();
+
+    if(d->pending.isEmpty())
+        return 0;
+
+    return d->pending.takeFirst();
+}
+
+QList<QObject *> CursorBase::nextObjects()
+{
+    // Objects left over from nextObject() are returned first
+    if(!d->pending.isEmpty()) {
+        QList<QObject *> result = d->pending;
+        d->pending.clear();
+        return result;
+    }
+
+    return d->readChunk();
+}
+
+QDataSuite::Error CursorBase::lastError() const
+{
+    return d->lastError;
+}
+
+} // namespace QPersistence
@@ -0,0 +1,76 @@
+#ifndef QPERSISTENCE_CURSOR_H
+#define QPERSISTENCE_CURSOR_H
+
+#include <QtCore/QExplicitlySharedDataPointer>
+#include <QtCore/QList>
+
+namespace QDataSuite {
+class Error;
+}
+
+class QObject;
+
+namespace QPersistence {
+
+class PersistentDataAccessObjectBase;
+
+// Walks through all objects of a table once, without reading the whole table into memory.
+// The rows are read in chunks from one forward-only query. The relations of the objects
+// are read together for each chunk. Lazy relations are read right away, too, because the cursor
+// has to know all related objects to re-use or delete them.
+// Without recycling, the caller owns the returned objects.
+// With recycling, the cursor owns them and re-uses them for the next chunk. The objects
+// (and their related objects) are only valid until the cursor reads the next chunk.
+// A cursor has to be used by the thread, which has created it.
+// Copies of a cursor share its position.
+class CursorBasePrivate;
+class CursorBase
+{
+public:
+    CursorBase(const CursorBase &other);
+    CursorBase &operator=(const CursorBase &other);
+    ~CursorBase();
+
+    int chunkSize() const;
+    void setChunkSize(int chunkSize);
+
+    bool isRecyclingObjects() const;
+    void setRecyclingObjects(bool recycle);
+
+    bool atEnd() const;
+
+    // Returns 0 at the end or on errors
+    QObject *nextObject();
+    // Returns the next chunk of at most chunkSize() objects, which is empty at the end or on errors
+    QList<QObject *> nextObjects();
+
+    QDataSuite::Error lastError() const;
+
+protected:
+    explicit CursorBase(const PersistentDataAccessObjectBase *dataAccessObject);
+
+private:
+    QExplicitlySharedDataPointer<CursorBasePrivate> d;
+};
+
+template<class T>
+class Cursor : public CursorBase
+{
+public:
+    explicit Cursor(const PersistentDataAccessObjectBase *dataAccessObject) :
+        CursorBase(dataAccessObject)
+    {
+    }
+
+    T *next() { return static_cast<T *>(nextObject()); }
+    QList<T *> nextChunk()
+    {
+        QList<T *> result;
+        Q_FOREACH(QObject *object, nextObjects()) result.append(static_cast<T *>(object));
+        return result;
+    }
+};
+
+} // namespace QPersistence
+
+#endif // QPERSISTENCE_CURSOR_H
@@ -12,9 +12,21 @@
 #include <QStringList>
 #include <QDebug>
 #include <QSqlRecord>
+#include <QMetaClassInfo>
+#include <QHash>
 
 namespace QPersistence {
 
+class SqlIndex
+{
+public:
+    SqlIndex() : unique(false) {}
+
+    QString name;
+    QStringList columns;
+    bool unique;
+};
+
 class DatabaseSchemaPrivate : public QSharedData
 {
 public:
@@ -27,6 +39,10 @@ public:
     SqlQuery query;
 
     QString metaPropertyToColumnDefinition(const QDataSuite::MetaProperty &property);
+    QList<SqlIndex> indexesOfMetaObject(const QDataSuite::MetaObject &meta) const;
+    QList<SqlIndex> indexesInDatabase(const QString &tableName) const;
+
+    static QString indexNamePrefix(const QString &tableName);
 };
 
 DatabaseSchema::DatabaseSchema(const QSqlDatabase &database, QObject *parent) :
@@ -76,13 +92,10 @@ void DatabaseSchema::createTable(const QMetaObject *metaObject)
     d->query.clear();
     d->query.setTable(meta.tableName());
 
-    int count = metaObject->propertyCount();
-    for (int i=1; i < count; ++i) { // start at 1 because 0 is "objectName"
-        QDataSuite::MetaProperty metaProperty(metaObject->property(i), meta);
-
-        if (!metaProperty.isStored())
-            continue;
+    QList<QDataSuite::MetaProperty> properties = meta.simpleProperties();
+    properties.append(meta.relationProperties());
 
+    foreach(const QDataSuite::MetaProperty metaProperty, properties) {
         if(!metaProperty.isRelationProperty()) {
             QString columnName = metaProperty.columnName();
             QString columnType = DatabaseSchema::variantTypeToSqlType(metaProperty.type());
@@ -119,7 +132,10 @@ void DatabaseSchema::createTable(const QMetaObject *metaObject)
     if ( !d->query.exec()
          || d->query.lastError().isValid()) {
         setLastError(d->query);
+        return;
     }
+
+    createIndexes(metaObject);
 }
 
 bool DatabaseSchema::addMissingColumns(const QMetaObject *metaObject)
@@ -127,13 +143,10 @@ bool DatabaseSchema::addMissingColumns(const QMetaObject *metaObject)
     QDataSuite::MetaObject meta = QDataSuite::MetaObject::metaObject(metaObject);
     QSqlRecord record = d->database.record(meta.tableName());;
 
-    int count = metaObject->propertyCount();
-    for (int i = 1; i < count; ++i) {
-        QDataSuite::MetaProperty metaProperty(metaObject->property(i), meta);
-
-        if (!metaProperty.isStored())
-            continue;
+    QList<QDataSuite::MetaProperty> properties = meta.simpleProperties();
+    properties.append(meta.relationProperties());
 
+    foreach(const QDataSuite::MetaProperty metaProperty, properties) {
         if (record.indexOf(metaProperty.columnName()) != -1)
             continue;
 
@@ -180,6 +193,59 @@ void DatabaseSchema::addColumn(const QDataSuite::MetaProperty &metaProperty)
     }
 }
 
+void DatabaseSchema::createIndexes(const QMetaObject *metaObject)
+{
+    QDataSuite::MetaObject meta = QDataSuite::MetaObject::metaObject(metaObject);
+
+    foreach(const SqlIndex index, d->indexesOfMetaObject(meta)) {
+        d->query.clear();
+        d->query.setTable(meta.tableName());
+        d->query.prepareCreateIndex(index.name, index.columns, index.unique);
+
+        if ( !d->query.exec()
+             || d->query.lastError().isValid()) {
+            setLastError(d->query);
+            return;
+        }
+    }
+}
+
+bool DatabaseSchema::adjustIndexes(const QMetaObject *metaObject)
+{
+    QDataSuite::MetaObject meta = QDataSuite::MetaObject::metaObject(metaObject);
+
+    QHash<QString, SqlIndex> declaredIndexes;
+    foreach(const SqlIndex index, d->indexesOfMetaObject(meta)) {
+        declaredIndexes.insert(index.name, index);
+    }
+
+    // Only indexes, which have been created by us, are dropped.
+    // Indexes added manually to the table are left alone.
+    QString prefix = DatabaseSchemaPrivate::indexNamePrefix(meta.tableName());
+    foreach(const SqlIndex existingIndex, d->indexesInDatabase(meta.tableName())) {
+        if(!existingIndex.name.startsWith(prefix))
+            continue;
+
+        SqlIndex declaredIndex = declaredIndexes.value(existingIndex.name);
+        if(declaredIndex.columns == existingIndex.columns
+                && declaredIndex.unique == existingIndex.unique)
+            continue;
+
+        d->query.clear();
+        d->query.prepareDropIndex(existingIndex.name);
+
+        if ( !d->query.exec()
+             || d->query.lastError().isValid()) {
+            setLastError(d->query);
+            return false;
+        }
+    }
+
+    // Missing and changed indexes are created again
+    createIndexes(metaObject);
+    return !lastError().isValid();
+}
+
 void DatabaseSchema::createCleanSchema()
 {
     foreach(const QDataSuite::MetaObject metaObject, QDataSuite::MetaObject::registeredMetaObjects()) {
@@ -194,6 +260,7 @@ void DatabaseSchema::adjustSchema()
     foreach(const QDataSuite::MetaObject metaObject, QDataSuite::MetaObject::registeredMetaObjects()) {
         createTableIfNotExists(&metaObject);
         addMissingColumns(&metaObject);
+        adjustIndexes(&metaObject);
     }
 }
 
@@ -236,6 +303,89 @@ void DatabaseSchema::setLastError(const QSqlQuery &query) const
     setLastError(QDataSuite::Error(query.lastError().text().append(": ").append(query.executedQuery()), QDataSuite::Error::SqlError));
 }
 
+QString DatabaseSchemaPrivate::indexNamePrefix(const QString &tableName)
+{
+    return QString("index_%1_").arg(tableName);
+}
+
+QList<SqlIndex> DatabaseSchemaPrivate::indexesOfMetaObject(const QDataSuite::MetaObject &meta) const
+{
+    QList<SqlIndex> result;
+    QString prefix = indexNamePrefix(meta.tableName());
+
+    // Every foreign key column in this table gets an index,
+    // because related objects are always selected by their foreign key.
+    foreach(const QDataSuite::MetaProperty metaProperty, meta.relationProperties()) {
+        if(metaProperty.tableName() != meta.tableName()
+                || !metaProperty.reverseRelation().isValid())
+            continue;
+
+        SqlIndex index;
+        index.name = QString(prefix).append(metaProperty.columnName());
+        index.columns.append(metaProperty.columnName());
+        result.append(index);
+    }
+
+    // Q_CLASSINFO("QDATASUITE_SQL_INDEX:name", "columns=property1,property2;unique=true")
+    QString classInfoPrefix = QString(QDATASUITE_SQL_INDEX).append(":");
+    for(int i = 0; i < meta.classInfoCount(); ++i) {
+        QString classInfoName = QLatin1String(meta.classInfo(i).name());
+        if(!classInfoName.startsWith(classInfoPrefix))
+            continue;
+
+        QHash<QString, QString> attributes;
+        QString classInfoValue = QLatin1String(meta.classInfo(i).value());
+        foreach(const QString attribute, classInfoValue.split(';', QString::SkipEmptyParts)) {
+            QStringList keyValue = attribute.split('=');
+            attributes.insert(keyValue.first().trimmed(), keyValue.last().trimmed());
+        }
+
+        SqlIndex index;
+        index.name = QString(prefix).append(classInfoName.mid(classInfoPrefix.length()));
+        index.unique = attributes.value(QDATASUITE_SQL_INDEX_UNIQUE) == QLatin1String(QDATASUITE_TRUE);
+
+        foreach(QString column, attributes.value(QDATASUITE_SQL_INDEX_COLUMNS).split(',', QString::SkipEmptyParts)) {
+            column = column.trimmed();
+            if(meta.hasMetaProperty(column))
+                column = meta.metaProperty(column).columnName();
+            index.columns.append(column);
+        }
+
+        Q_ASSERT_X(!index.columns.isEmpty(),
+                   Q_FUNC_INFO,
+                   qPrintable(QString("The index %1 of the %2 class has no columns.")
+                              .arg(classInfoName)
+                              .arg(meta.className())));
+
+        result.append(index);
+    }
+
+    return result;
+}
+
+QList<SqlIndex> DatabaseSchemaPrivate::indexesInDatabase(const QString &tableName) const
+{
+    QList<SqlIndex> result;
+
+    QSqlQuery indexList(database);
+    indexList.exec(QString("PRAGMA index_list(\"%1\");").arg(tableName));
+    while(indexList.next()) {
+        SqlIndex index;
+        index.name = indexList.value("name").toString();
+        index.unique = indexList.value("unique").toBool();
+
+        QSqlQuery indexInfo(database);
+        indexInfo.exec(QString("PRAGMA index_info(\"%1\");").arg(index.name));
+        while(indexInfo.next()) {
+            index.columns.append(indexInfo.value("name").toString());
+        }
+
+        result.append(index);
+    }
+
+    return result;
+}
+
 QString DatabaseSchemaPrivate::metaPropertyToColumnDefinition(const QDataSuite::MetaProperty &metaProperty)
 {
     QString name;
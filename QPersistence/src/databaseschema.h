@@ -30,12 +30,16 @@ public:
     void dropTable(const QMetaObject *metaObject);
     bool addMissingColumns(const QMetaObject *metaObject);
     void addColumn(const QDataSuite::MetaProperty &metaProperty);
+    void createIndexes(const QMetaObject *metaObject);
+    bool adjustIndexes(const QMetaObject *metaObject);
 
     template<class O> bool existsTable() { return existsTable(&O::staticMetaObject); }
     template<class O> void createTable() { createTable(&O::staticMetaObject); }
     template<class O> void createTableIfNotExists() { createTableIfNotExists(&O::staticMetaObject); }
     template<class O> void dropTable() { dropTable(&O::staticMetaObject); }
     template<class O> void addMissingColumns() { addMissingColumns(&O::staticMetaObject); }
+    template<class O> void createIndexes() { createIndexes(&O::staticMetaObject); }
+    template<class O> bool adjustIndexes() { return adjustIndexes(&O::staticMetaObject); }
 
     void createCleanSchema();
     void adjustSchema();
@@ -1,5 +1,6 @@
 #include <QPersistence/persistentdataaccessobject.h>
 
+#include <QPersistence/session.h>
 #include <QDataSuite/error.h>
 #include <QtCore/QVariant>
 
@@ -20,10 +21,14 @@ PersistentDataAccessObjectBase::PersistentDataAccessObjectBase(const QMetaObject
 {
     d->sqlDataAccessObjectHelper = SqlDataAccessObjectHelper::forDatabase(database);
     d->metaObject = QDataSuite::MetaObject::metaObject(metaObject);
+
+    // Each task (e.g. each request of a server) reads into its own session
+    Session::registerTaskHooks();
 }
 
 PersistentDataAccessObjectBase::~PersistentDataAccessObjectBase()
 {
+    finishAsyncCalls();
 }
 
 SqlDataAccessObjectHelper *PersistentDataAccessObjectBase::sqlDataAccessObjectHelper() const
@@ -36,13 +41,27 @@ QDataSuite::MetaObject PersistentDataAccessObjectBase::dataSuiteMetaObject() con
     return d->metaObject;
 }
 
+std::function<void ()> PersistentDataAccessObjectBase::wrapAsyncCall(const std::function<void ()> &call) const
+{
+    return Session::bindToCurrent(call);
+}
+
 int PersistentDataAccessObjectBase::count() const
 {
-    return d->sqlDataAccessObjectHelper->count(d->metaObject);
+    resetLastError();
+
+    int result = d->sqlDataAccessObjectHelper->count(d->metaObject);
+
+    if(d->sqlDataAccessObjectHelper->lastError().isValid())
+        setLastError(d->sqlDataAccessObjectHelper->lastError());
+
+    return result;
 }
 
 QList<QVariant> PersistentDataAccessObjectBase::allKeys() const
 {
+    resetLastError();
+
     QList<QVariant> result = d->sqlDataAccessObjectHelper->allKeys(d->metaObject);
 
     if(d->sqlDataAccessObjectHelper->lastError().isValid())
@@ -53,13 +72,60 @@ QList<QVariant> PersistentDataAccessObjectBase::allKeys() const
 
 QList<QObject *> PersistentDataAccessObjectBase::readAllObjects() const
 {
+    resetLastError();
+
+    QList<QObject *> result;
+
+    if(!d->sqlDataAccessObjectHelper->readAllObjects(d->metaObject, this, result))
+        setLastError(d->sqlDataAccessObjectHelper->lastError());
+
+    return result;
+}
+
+QList<QObject *> PersistentDataAccessObjectBase::readObjects(int offset, int limit) const
+{
+    resetLastError();
+
     QList<QObject *> result;
-    Q_FOREACH(const QVariant key, allKeys()) result.append(readObject(key));
+
+    if(!d->sqlDataAccessObjectHelper->readObjects(d->metaObject, this, offset, limit, result))
+        setLastError(d->sqlDataAccessObjectHelper->lastError());
+
+    return result;
+}
+
+QList<QObject *> PersistentDataAccessObjectBase::readObjectsAfter(const QVariant &key, int limit) const
+{
+    resetLastError();
+
+    QList<QObject *> result;
+
+    if(!d->sqlDataAccessObjectHelper->readObjectsAfter(d->metaObject, this, key, limit, result))
+        setLastError(d->sqlDataAccessObjectHelper->lastError());
+
     return result;
 }
 
 QObject *PersistentDataAccessObjectBase::readObject(const QVariant &key) const
 {
+    resetLastError();
+
+    QVariant sessionKey = key;
+    if(!sessionKey.convert(d->metaObject.primaryKeyProperty().type())) {
+        setLastError(QDataSuite::Error(QString("The key %1 is not a valid %2 key.")
+                                       .arg(key.toString())
+                                       .arg(d->metaObject.className()),
+                                       QDataSuite::Error::StorageError));
+        return 0;
+    }
+
+    // The session of the current thread might already know the object
+    if(Session *session = Session::current()) {
+        QObject *object = session->object(QLatin1String(d->metaObject.className()), sessionKey);
+        if(object)
+            return object;
+    }
+
     QObject *object = createObject();
 
     if(!d->sqlDataAccessObjectHelper->readObject(d->metaObject, key, object)) {
@@ -73,6 +139,8 @@ QObject *PersistentDataAccessObjectBase::readObject(const QVariant &key) const
 
 bool PersistentDataAccessObjectBase::insertObject(QObject * const object)
 {
+    resetLastError();
+
     if(!d->sqlDataAccessObjectHelper->insertObject(d->metaObject, object)) {
         setLastError(d->sqlDataAccessObjectHelper->lastError());
         return false;
@@ -82,8 +150,26 @@ bool PersistentDataAccessObjectBase::insertObject(QObject * const object)
     return true;
 }
 
+bool PersistentDataAccessObjectBase::insertObjects(const QList<QObject *> &objects)
+{
+    resetLastError();
+
+    if(!d->sqlDataAccessObjectHelper->insertObjects(d->metaObject, objects)) {
+        setLastError(d->sqlDataAccessObjectHelper->lastError());
+        return false;
+    }
+
+    foreach(QObject *object, objects) {
+        emit objectInserted(object);
+    }
+
+    return true;
+}
+
 bool PersistentDataAccessObjectBase::updateObject(QObject *const object)
 {
+    resetLastError();
+
     if(!d->sqlDataAccessObjectHelper->updateObject(d->metaObject, object)) {
         setLastError(d->sqlDataAccessObjectHelper->lastError());
         return false;
@@ -95,6 +181,8 @@ bool PersistentDataAccessObjectBase::updateObject(QObject *const object)
 
 bool PersistentDataAccessObjectBase::removeObject(QObject *const object)
 {
+    resetLastError();
+
     if(!d->sqlDataAccessObjectHelper->removeObject(d->metaObject, object)) {
         setLastError(d->sqlDataAccessObjectHelper->lastError());
         return false;
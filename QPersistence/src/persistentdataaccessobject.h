@@ -4,6 +4,7 @@
 #include <QDataSuite/abstractdataaccessobject.h>
 
 #include <QPersistence/sqldataaccessobjecthelper.h>
+#include <QPersistence/cursor.h>
 #include <QDataSuite/metaobject.h>
 #include <QtCore/QSharedDataPointer>
 #include <QtSql/QSqlDatabase>
@@ -34,11 +35,18 @@ public:
     int count() const Q_DECL_OVERRIDE;
     QList<QVariant> allKeys() const Q_DECL_OVERRIDE;
     QList<QObject *> readAllObjects() const Q_DECL_OVERRIDE;
+    QList<QObject *> readObjects(int offset, int limit) const Q_DECL_OVERRIDE;
+    QList<QObject *> readObjectsAfter(const QVariant &key, int limit) const Q_DECL_OVERRIDE;
     QObject *readObject(const QVariant &key) const Q_DECL_OVERRIDE;
     bool insertObject(QObject *const object) Q_DECL_OVERRIDE;
+    bool insertObjects(const QList<QObject *> &objects);
     bool updateObject(QObject *const object) Q_DECL_OVERRIDE;
     bool removeObject(QObject *const object) Q_DECL_OVERRIDE;
 
+protected:
+    // Asynchronous calls read into the session of the calling thread
+    std::function<void ()> wrapAsyncCall(const std::function<void ()> &call) const Q_DECL_OVERRIDE;
+
 private:
     QSharedDataPointer<PersistentDataAccessObjectBasePrivate> d;
 
@@ -54,6 +62,12 @@ public:
     {
     }
 
+    ~PersistentDataAccessObject()
+    {
+        // Running calls might still create objects
+        finishAsyncCalls();
+    }
+
     QList<T *> readAll() const
     {
         QList<T *> result;
@@ -65,8 +79,29 @@ public:
     T *create() const { return static_cast<T *>(createObject()); }
     T *read(const QVariant &key) const { return static_cast<T *>(readObject(key)); }
     bool insert(T *const object) { return insertObject(object); }
+    bool insertAll(const QList<T *> &objects)
+    {
+        QList<QObject *> list;
+        Q_FOREACH(T *object, objects) list.append(object);
+        return insertObjects(list);
+    }
     bool update(T *const object) { return updateObject(object); }
     bool remove(T *const object) { return removeObject(object); }
+
+    QFuture<QList<T *> > readAllAsync() const { return runAsync<QList<T *> >([this]() { return readAll(); }); }
+    QFuture<T *> readAsync(const QVariant &key) const { return runAsync<T *>([this, key]() { return read(key); }); }
+    QFuture<bool> insertAsync(T *const object) { return insertObjectAsync(object); }
+    QFuture<bool> updateAsync(T *const object) { return updateObjectAsync(object); }
+    QFuture<bool> removeAsync(T *const object) { return removeObjectAsync(object); }
+
+    // Iterates over all objects without reading them all at once
+    Cursor<T> cursor(int chunkSize = 100, bool recycleObjects = false) const
+    {
+        Cursor<T> result(this);
+        result.setChunkSize(chunkSize);
+        result.setRecyclingObjects(recycleObjects);
+        return result;
+    }
 };
 
 } // namespace QPersistence
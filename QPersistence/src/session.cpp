@@ -0,0 +1,171 @@
+#include "session.h"
+
+#include <QDataSuite/taskscope.h>
+
+#include <QHash>
+#include <QMutex>
+#include <QObject>
+#include <QSharedData>
+#include <QThreadStorage>
+
+namespace QPersistence {
+
+class SessionPrivate : public QSharedData
+{
+public:
+    SessionPrivate() :
+        QSharedData()
+    {}
+
+    // Objects may be destroyed in another thread, after they have been moved there
+    mutable QMutex mutex;
+    QHash<QString, QHash<QVariant, QObject *> > objectsPerClass;
+
+    // Disconnects the destroyed() signals of all objects, when the session is gone
+    QObject guard;
+
+    // The stack of sessions of each thread. The innermost session is the last one.
+    static QThreadStorage<QList<Session *> > sessions;
+
+    // The sessions, which have been opened for the tasks of each thread
+    static QThreadStorage<QList<Session *> > taskSessions;
+};
+
+QThreadStorage<QList<Session *> > SessionPrivate::sessions;
+QThreadStorage<QList<Session *> > SessionPrivate::taskSessions;
+
+Session::Session() :
+    d(new SessionPrivate)
+{
+    SessionPrivate::sessions.localData().append(this);
+}
+
+Session::Session(const QExplicitlySharedDataPointer<SessionPrivate> &data) :
+    d(data)
+{
+    SessionPrivate::sessions.localData().append(this);
+}
+
+Session::~Session()
+{
+    SessionPrivate::sessions.localData().removeOne(this);
+}
+
+Session *Session::current()
+{
+    if(!SessionPrivate::sessions.hasLocalData())
+        return 0;
+
+    const QList<Session *> &sessions = SessionPrivate::sessions.localData();
+    if(sessions.isEmpty())
+        return 0;
+
+    return sessions.last();
+}
+
+std::function<void ()> Session::bindToCurrent(const std::function<void ()> &call)
+{
+    Session *session = current();
+    if(!session)
+        return call;
+
+    // The data outlives the session of the caller, if the call runs later
+    QExplicitlySharedDataPointer<SessionPrivate> data = session->d;
+    return [data, call]() {
+        Session joinedSession(data);
+        call();
+    };
+}
+
+void Session::registerTaskHooks()
+{
+    static const bool registered = (QDataSuite::TaskScope::registerHooks([]() {
+        SessionPrivate::taskSessions.localData().append(new Session);
+    }, []() {
+        QList<Session *> &sessions = SessionPrivate::taskSessions.localData();
+        if(!sessions.isEmpty())
+            delete sessions.takeLast();
+    }), true);
+    Q_UNUSED(registered);
+}
+
+QObject *Session::object(const QString &className, const QVariant &key) const
+{
+    QMutexLocker locker(&d->mutex);
+    return d->objectsPerClass.value(className).value(key);
+}
+
+void Session::insertObject(const QString &className, const QVariant &key, QObject *object)
+{
+    Q_ASSERT(object);
+
+    {
+        QMutexLocker locker(&d->mutex);
+        QHash<QVariant, QObject *> &objects = d->objectsPerClass[className];
+        if(objects.value(key) == object)
+            return;
+
+        objects.insert(key, object);
+    }
+
+    SessionPrivate *data = d.data();
+    QObject::connect(object, &QObject::destroyed, &d->guard, [data, className, key, object]() {
+        QMutexLocker locker(&data->mutex);
+        QHash<QString, QHash<QVariant, QObject *> >::iterator it = data->objectsPerClass.find(className);
+        if(it != data->objectsPerClass.end()
+                && it->value(key) == object) {
+            it->remove(key);
+        }
+    }, Qt::DirectConnection);
+}
+
+void Session::removeObject(const QString &className, const QVariant &key)
+{
+    QMutexLocker locker(&d->mutex);
+    QHash<QString, QHash<QVariant, QObject *> >::iterator it = d->objectsPerClass.find(className);
+    if(it == d->objectsPerClass.end())
+        return;
+
+    QObject *object = it->take(key);
+    if(object)
+        object->disconnect(&d->guard);
+}
+
+QList<QObject *> Session::objects() const
+{
+    typedef QHash<QVariant, QObject *> ObjectsByKey;
+
+    QMutexLocker locker(&d->mutex);
+    QList<QObject *> result;
+    foreach(const ObjectsByKey &objects, d->objectsPerClass) {
+        result.append(objects.values());
+    }
+    return result;
+}
+
+int Session::size() const
+{
+    typedef QHash<QVariant, QObject *> ObjectsByKey;
+
+    QMutexLocker locker(&d->mutex);
+    int result = 0;
+    foreach(const ObjectsByKey &objects, d->objectsPerClass) {
+        result += objects.size();
+    }
+    return result;
+}
+
+void Session::clear()
+{
+    typedef QHash<QVariant, QObject *> ObjectsByKey;
+
+    QMutexLocker locker(&d->mutex);
+    foreach(const ObjectsByKey &objects, d->objectsPerClass) {
+        foreach(QObject *object, objects) {
+            object->disconnect(&d->guard);
+        }
+    }
+    d->objectsPerClass.clear();
+}
+
+} // namespace QPersistence
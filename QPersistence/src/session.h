@@ -0,0 +1,58 @@
+#ifndef QPERSISTENCE_SESSION_H
+#define QPERSISTENCE_SESSION_H
+
+#include <QtCore/QExplicitlySharedDataPointer>
+#include <QtCore/QVariant>
+
+#include <functional>
+
+class QObject;
+
+namespace QPersistence {
+
+// An identity map for the reads of one thread.
+// While a session exists, all data access objects of its thread read at most one instance per class and key
+// and return the instance they have already read instead of reading it again.
+// Sessions are scoped: create one on the stack for the duration of a request or transaction.
+// Nested sessions hide the outer session until they are destroyed.
+// Data access objects open a session for each task (see QDataSuite::TaskScope), e.g. for each
+// request of a server, and a Transaction opens one for its duration.
+//
+// A session does not own its objects. Objects, which are destroyed, are removed from the session.
+class SessionPrivate;
+class Session
+{
+public:
+    Session();
+    ~Session();
+
+    // The innermost session of the current thread or 0
+    static Session *current();
+
+    // Returns a call, which runs in the current session of the calling thread,
+    // e.g. on the thread pool of asynchronous calls. The call keeps the session's objects known.
+    static std::function<void ()> bindToCurrent(const std::function<void ()> &call);
+
+    // Opens a session for each task. Data access objects call this once.
+    static void registerTaskHooks();
+
+    QObject *object(const QString &className, const QVariant &key) const;
+    void insertObject(const QString &className, const QVariant &key, QObject *object);
+    void removeObject(const QString &className, const QVariant &key);
+
+    QList<QObject *> objects() const;
+    int size() const;
+    void clear();
+
+private:
+    QExplicitlySharedDataPointer<SessionPrivate> d;
+
+    // Joins the data of another session
+    explicit Session(const QExplicitlySharedDataPointer<SessionPrivate> &data);
+
+    Q_DISABLE_COPY(Session)
+};
+
+} // namespace QPersistence
+
+#endif // QPERSISTENCE_SESSION_H
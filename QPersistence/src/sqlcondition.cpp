@@ -103,6 +103,15 @@ QString SqlCondition::toWhereClause(bool bindValues) const
 
     Q_ASSERT(!d->key.isEmpty());
 
+    if(d->comparisonOperator == In) {
+        int count = d->value.toList().size();
+        QString placeholders = QString("?, ").repeated(qMax(count - 1, 0));
+        if(count > 0)
+            placeholders.append("?");
+
+        return comparisonOperator().prepend(QString("\"%1\"").arg(d->key)).append(QString("(%1)").arg(placeholders));
+    }
+
     return comparisonOperator().prepend(QString("\"%1\"").arg(d->key)).append("?");
 }
 
@@ -114,8 +123,12 @@ QVariantList SqlCondition::bindValues() const
         result.append(condition.bindValues());
     }
 
-    if(!d->key.isEmpty())
-        result.append(d->value);
+    if(!d->key.isEmpty()) {
+        if(d->comparisonOperator == In)
+            result.append(d->value.toList());
+        else
+            result.append(d->value);
+    }
 
     return result;
 }
@@ -147,6 +160,8 @@ QString SqlCondition::comparisonOperator() const
         return " <= ";
     case NotEqualTo:
         return " <> ";
+    case In:
+        return " IN ";
     }
 }
 
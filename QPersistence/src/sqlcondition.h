@@ -26,7 +26,8 @@ public:
         LessThan,
         GreaterThanOrEqualTo,
         LessThanOrEqualTo,
-        NotEqualTo
+        NotEqualTo,
+        In // value has to be a QVariantList
     };
 
     SqlCondition();
@@ -0,0 +1,296 @@
+#include "sqlconnectionpool.h"
+
+#include "sqlstatementcache.h"
+
+#include <QDataSuite/abstractdataaccessobject.h>
+#include <QDataSuite/error.h>
+#include <QDataSuite/taskscope.h>
+
+#include <QElapsedTimer>
+#include <QHash>
+#include <QMutex>
+#include <QSqlError>
+#include <QSqlQuery>
+#include <QThread>
+#include <QThreadPool>
+#include <QThreadStorage>
+#include <QWaitCondition>
+
+namespace QPersistence {
+
+// The connection of one thread. It is removed, when the thread finishes.
+class SqlPooledConnection
+{
+public:
+    SqlPooledConnection(SqlConnectionPool *pool, const QString &connectionName) :
+        pool(pool),
+        connectionName(connectionName)
+    {}
+
+    ~SqlPooledConnection();
+
+    SqlConnectionPool *pool;
+    QString connectionName;
+};
+
+class SqlConnectionPoolPrivate : public QSharedData
+{
+public:
+    SqlConnectionPoolPrivate() :
+        QSharedData(),
+        maximumSize(qMax(2, QThread::idealThreadCount())),
+        acquireTimeout(30000),
+        size(1),
+        peakSize(1),
+        waits(0),
+        timeouts(0),
+        totalWaitTime(0),
+        connectionCount(0)
+    {}
+
+    QSqlDatabase database;
+    QThread *databaseThread;
+
+    mutable QMutex mutex;
+    QWaitCondition connectionReleased;
+    QThreadStorage<SqlPooledConnection *> connections;
+    QThreadStorage<QDataSuite::Error> lastError;
+
+    int maximumSize;
+    int acquireTimeout;
+
+    int size;
+    int peakSize;
+    int waits;
+    int timeouts;
+    qint64 totalWaitTime;
+
+    int connectionCount;
+
+    int effectiveMaximumSize() const;
+
+    static QMutex poolsMutex;
+    static QHash<QString, SqlConnectionPool *> poolsForConnection;
+};
+
+QMutex SqlConnectionPoolPrivate::poolsMutex;
+QHash<QString, SqlConnectionPool *> SqlConnectionPoolPrivate::poolsForConnection;
+
+int SqlConnectionPoolPrivate::effectiveMaximumSize() const
+{
+    // Every thread, which might run tasks concurrently, gets a connection:
+    // the thread of the pool, the reserved ones (e.g. server workers) and those of asynchronous calls
+    return qMax(maximumSize,
+                1 + QDataSuite::TaskScope::reservedThreads()
+                + QDataSuite::AbstractDataAccessObject::threadPool()->maxThreadCount());
+}
+
+SqlPooledConnection::~SqlPooledConnection()
+{
+    SqlStatementCache::removeDatabase(connectionName);
+    QSqlDatabase::removeDatabase(connectionName);
+
+    QMutexLocker locker(&pool->d->mutex);
+    --pool->d->size;
+    pool->d->connectionReleased.wakeOne();
+}
+
+SqlConnectionPool::SqlConnectionPool(const QSqlDatabase &database) :
+    d(new SqlConnectionPoolPrivate)
+{
+    d->database = database;
+    d->databaseThread = QThread::currentThread();
+}
+
+SqlConnectionPool::~SqlConnectionPool()
+{
+}
+
+SqlConnectionPool *SqlConnectionPool::forDatabase(const QSqlDatabase &database)
+{
+    QString connectionName = database.connectionName();
+
+    QMutexLocker locker(&SqlConnectionPoolPrivate::poolsMutex);
+
+    // Threads of a pool (e.g. the workers of a server) may outlive their tasks,
+    // so they give their connections back after each task
+    static bool hooksRegistered = false;
+    if(!hooksRegistered) {
+        QDataSuite::TaskScope::registerHooks(QDataSuite::TaskScope::Hook(), &SqlConnectionPool::releaseAll);
+        hooksRegistered = true;
+    }
+
+    if(!SqlConnectionPoolPrivate::poolsForConnection.contains(connectionName))
+        SqlConnectionPoolPrivate::poolsForConnection.insert(connectionName,
+                                                            new SqlConnectionPool(database));
+
+    return SqlConnectionPoolPrivate::poolsForConnection.value(connectionName);
+}
+
+QSqlDatabase SqlConnectionPool::database()
+{
+    d->lastError.setLocalData(QDataSuite::Error());
+
+    if(QThread::currentThread() == d->databaseThread)
+        return d->database;
+
+    if(d->connections.hasLocalData())
+        return QSqlDatabase::database(d->connections.localData()->connectionName);
+
+    // A clone of an in-memory database would be a new and empty database
+    QString databaseName = d->database.databaseName();
+    if(databaseName == QLatin1String(":memory:")
+            || databaseName.contains(QLatin1String("mode=memory"))) {
+        d->lastError.setLocalData(QDataSuite::Error(QString("The in-memory database '%1' can only be used by the thread, which has opened it.")
+                                                    .arg(d->database.connectionName()),
+                                                    QDataSuite::Error::SqlError));
+        return QSqlDatabase();
+    }
+
+    QString connectionName;
+    {
+        QMutexLocker locker(&d->mutex);
+
+        if(d->size >= d->effectiveMaximumSize()) {
+            ++d->waits;
+
+            QElapsedTimer timer;
+            timer.start();
+
+            while(d->size >= d->effectiveMaximumSize()) {
+                qint64 remaining = d->acquireTimeout - timer.elapsed();
+                if(remaining <= 0
+                        || !d->connectionReleased.wait(&d->mutex, remaining)) {
+                    if(d->size < d->effectiveMaximumSize())
+                        break;
+
+                    ++d->timeouts;
+                    d->totalWaitTime += timer.elapsed();
+                    d->lastError.setLocalData(QDataSuite::Error(QString("No connection to the database '%1' became free within %2 ms.")
+                                                                .arg(d->database.connectionName())
+                                                                .arg(d->acquireTimeout),
+                                                                QDataSuite::Error::SqlError));
+                    return QSqlDatabase();
+                }
+            }
+
+            d->totalWaitTime += timer.elapsed();
+        }
+
+        ++d->size;
+        d->peakSize = qMax(d->peakSize, d->size);
+        connectionName = QString("%1_pooled_%2")
+                .arg(d->database.connectionName())
+                .arg(++d->connectionCount);
+    }
+
+    QSqlDatabase database = QSqlDatabase::cloneDatabase(d->database, connectionName);
+    d->connections.setLocalData(new SqlPooledConnection(this, connectionName));
+
+    if(!database.open()) {
+        d->lastError.setLocalData(QDataSuite::Error(QString("Could not open a pooled connection to the database '%1': %2")
+                                                    .arg(d->database.connectionName())
+                                                    .arg(database.lastError().text()),
+                                                    QDataSuite::Error::SqlError));
+        database = QSqlDatabase();
+        release();
+        return QSqlDatabase();
+    }
+
+    QSqlQuery query(database);
+    query.exec("PRAGMA foreign_keys = 1;");
+    return database;
+}
+
+void SqlConnectionPool::release()
+{
+    // Deletes the current connection
+    if(d->connections.hasLocalData())
+        d->connections.setLocalData(0);
+}
+
+void SqlConnectionPool::releaseAll()
+{
+    QList<SqlConnectionPool *> pools;
+    {
+        QMutexLocker locker(&SqlConnectionPoolPrivate::poolsMutex);
+        pools = SqlConnectionPoolPrivate::poolsForConnection.values();
+    }
+
+    foreach(SqlConnectionPool *pool, pools) {
+        pool->release();
+    }
+}
+
+QDataSuite::Error SqlConnectionPool::lastError() const
+{
+    return d->lastError.localData();
+}
+
+int SqlConnectionPool::maximumSize() const
+{
+    QMutexLocker locker(&d->mutex);
+    return d->maximumSize;
+}
+
+void SqlConnectionPool::setMaximumSize(int size)
+{
+    Q_ASSERT(size > 0);
+
+    QMutexLocker locker(&d->mutex);
+    d->maximumSize = size;
+    d->connectionReleased.wakeAll();
+}
+
+int SqlConnectionPool::acquireTimeout() const
+{
+    QMutexLocker locker(&d->mutex);
+    return d->acquireTimeout;
+}
+
+void SqlConnectionPool::setAcquireTimeout(int msecs)
+{
+    QMutexLocker locker(&d->mutex);
+    d->acquireTimeout = msecs;
+}
+
+int SqlConnectionPool::size() const
+{
+    QMutexLocker locker(&d->mutex);
+    return d->size;
+}
+
+int SqlConnectionPool::peakSize() const
+{
+    QMutexLocker locker(&d->mutex);
+    return d->peakSize;
+}
+
+int SqlConnectionPool::waits() const
+{
+    QMutexLocker locker(&d->mutex);
+    return d->waits;
+}
+
+int SqlConnectionPool::timeouts() const
+{
+    QMutexLocker locker(&d->mutex);
+    return d->timeouts;
+}
+
+qint64 SqlConnectionPool::totalWaitTime() const
+{
+    QMutexLocker locker(&d->mutex);
+    return d->totalWaitTime;
+}
+
+void SqlConnectionPool::resetStatistics()
+{
+    QMutexLocker locker(&d->mutex);
+    d->peakSize = d->size;
+    d->waits = 0;
+    d->timeouts = 0;
+    d->totalWaitTime = 0;
+}
+
+} // namespace QPersistence
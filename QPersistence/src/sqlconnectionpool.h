@@ -0,0 +1,62 @@
+#ifndef QPERSISTENCE_SQLCONNECTIONPOOL_H
+#define QPERSISTENCE_SQLCONNECTIONPOOL_H
+
+#include <QtCore/QExplicitlySharedDataPointer>
+#include <QtSql/QSqlDatabase>
+
+namespace QDataSuite {
+class Error;
+}
+
+namespace QPersistence {
+
+// Hands out one clone of a database connection per thread, because a QSqlDatabase
+// may only be used by the thread, which has created it. The thread, which creates the pool,
+// keeps using the original connection.
+// In-memory databases can not be cloned, so they can only be used by their own thread.
+class SqlConnectionPoolPrivate;
+class SqlConnectionPool
+{
+public:
+    ~SqlConnectionPool();
+
+    static SqlConnectionPool *forDatabase(const QSqlDatabase &database = QSqlDatabase::database());
+
+    // Returns the connection of the current thread. If the thread has none yet and
+    // the pool is saturated, this waits for acquireTimeout() milliseconds.
+    // If no connection could be acquired, it returns an invalid QSqlDatabase and sets lastError().
+    QSqlDatabase database();
+    // Gives the connection of the current thread back to the pool.
+    // Connections are released, when their thread finishes or a QDataSuite::TaskScope ends.
+    void release();
+    static void releaseAll();
+
+    // The error of the last call to database() in the current thread
+    QDataSuite::Error lastError() const;
+
+    // The pool grows beyond this size, if more threads may run tasks concurrently
+    // (see QDataSuite::TaskScope::reserveThreads() and AbstractDataAccessObject::threadPool())
+    int maximumSize() const;
+    void setMaximumSize(int size);
+    int acquireTimeout() const;
+    void setAcquireTimeout(int msecs);
+
+    int size() const;
+    int peakSize() const;
+    int waits() const;
+    int timeouts() const;
+    qint64 totalWaitTime() const;
+    void resetStatistics();
+
+private:
+    QExplicitlySharedDataPointer<SqlConnectionPoolPrivate> d;
+
+    explicit SqlConnectionPool(const QSqlDatabase &database);
+    Q_DISABLE_COPY(SqlConnectionPool)
+
+    friend class SqlPooledConnection;
+};
+
+} // namespace QPersistence
+
+#endif // QPERSISTENCE_SQLCONNECTIONPOOL_H
@@ -3,23 +3,191 @@
 #include "databaseschema.h"
 #include "sqlquery.h"
 #include "sqlcondition.h"
+#include "sqlconnectionpool.h"
+#include "sqlquerylog.h"
 #include "persistentdataaccessobject.h"
+#include "session.h"
 
 #include <QDataSuite/metaproperty.h>
 #include <QDataSuite/error.h>
 #include <QDataSuite/metaobject.h>
+#include <QDataSuite/lazyrelations.h>
 
 #include <QDebug>
 #include <QMetaProperty>
+#include <QMutex>
 #include <QSqlDatabase>
 #include <QSqlError>
 #include <QSqlQuery>
 #include <QSqlRecord>
+#include <QSet>
 #include <QStringList>
+#include <QThreadStorage>
 #include <QVariant>
+#include <QVector>
 
 namespace QPersistence {
 
+// SQLite allows at most 999 bound values per statement
+static const int MaximumBoundValuesPerQuery = 500;
+
+// Values read from the database do not necessarily have the type of the property
+static QVariant normalizedKey(const QVariant &key, QVariant::Type type)
+{
+    if(key.isNull() || key.type() == type)
+        return key;
+
+    QVariant result(key);
+    result.convert(type);
+    return result;
+}
+
+// Makes the objects, which have been read or written, known to the session of the current thread
+static void rememberObjects(const QHash<QString, QHash<QVariant, QObject *> > &objectsPerClass)
+{
+    Session *session = Session::current();
+    if(!session)
+        return;
+
+    QHashIterator<QString, QHash<QVariant, QObject *> > it(objectsPerClass);
+    while(it.hasNext()) {
+        it.next();
+        QHashIterator<QVariant, QObject *> objectIt(it.value());
+        while(objectIt.hasNext()) {
+            objectIt.next();
+            session->insertObject(it.key(), objectIt.key(), objectIt.value());
+        }
+    }
+}
+
+static void rememberObject(const QDataSuite::MetaObject &metaObject, const QObject *object)
+{
+    Session *session = Session::current();
+    if(!session)
+        return;
+
+    // The session only hands the object out, it never changes it
+    session->insertObject(QLatin1String(metaObject.className()),
+                          metaObject.primaryKeyProperty().read(object),
+                          const_cast<QObject *>(object));
+}
+
+// Visits the values of all columns of an object, which reside in its own table.
+// Values are read through the typed accessors of the properties, if there are any.
+template<class Visitor>
+static void visitColumnValues(const QDataSuite::MetaObject &metaObject,
+                              const QObject *object,
+                              Visitor &visitor)
+{
+    // Add simple properties
+    foreach(const QDataSuite::MetaProperty property, metaObject.simpleProperties()) {
+        if(!property.isAutoIncremented()) {
+            visitor(property.columnName(), property.read(object));
+        }
+    }
+
+    // Add relation properties
+    foreach(const QDataSuite::MetaProperty property, metaObject.relationProperties()) {
+        QDataSuite::MetaProperty::Cardinality cardinality = property.cardinality();
+
+        // Only care for "XtoOne" relations, since only they have to be inserted into our table
+        if(cardinality == QDataSuite::MetaProperty::ToOneCardinality
+                || cardinality == QDataSuite::MetaProperty::ManyToOneCardinality) {
+            // A pending relation still knows its foreign key, there is no need to read it.
+            // Typed setters do not discard the pending relation, so the property might be set nevertheless.
+            QObject *relatedObject = property.peekObject(object);
+            if(!relatedObject) {
+                QVariant pendingKey = QDataSuite::LazyRelations::pendingKey(object, property);
+                if(pendingKey.isValid())
+                    visitor(property.columnName(), pendingKey);
+                continue;
+            }
+
+            visitor(property.columnName(), property.reverseMetaObject().primaryKeyProperty().read(relatedObject));
+        }
+        else if(cardinality == QDataSuite::MetaProperty::OneToOneCardinality) {
+            Q_ASSERT_X(false, Q_FUNC_INFO, "OneToOneCardinality relations are not supported yet.");
+        }
+    }
+}
+
+class ColumnValuesCollector
+{
+public:
+    void operator()(const QString &column, const QVariant &value) { values.insert(column, value); }
+    QHash<QString, QVariant> values;
+};
+
+// Binds the values straight into a query, without collecting them first
+class QueryFieldsFiller
+{
+public:
+    explicit QueryFieldsFiller(SqlQuery &query) : query(query) {}
+    void operator()(const QString &column, const QVariant &value) { query.addField(column, value); }
+    SqlQuery &query;
+};
+
+// The values of all columns of an object, which reside in its own table
+static QHash<QString, QVariant> columnValues(const QDataSuite::MetaObject &metaObject,
+                                             const QObject *object)
+{
+    ColumnValuesCollector collector;
+    visitColumnValues(metaObject, object, collector);
+    return collector.values;
+}
+
+// The state of an object, as it has last been read from or written to the database
+class ObjectSnapshot
+{
+public:
+    QHash<QString, QVariant> columns;
+
+    // The keys of the related objects of each "XtoMany" relation, which has been read
+    QHash<QString, QSet<QVariant> > relatedKeys;
+};
+
+static ObjectSnapshot snapshotOfObject(const QDataSuite::MetaObject &metaObject,
+                                       const QObject *object)
+{
+    ObjectSnapshot snapshot;
+    snapshot.columns = columnValues(metaObject, object);
+
+    foreach(const QDataSuite::MetaProperty property, metaObject.relationProperties()) {
+        QDataSuite::MetaProperty::Cardinality cardinality = property.cardinality();
+
+        if(cardinality == QDataSuite::MetaProperty::ToManyCardinality
+                || cardinality == QDataSuite::MetaProperty::OneToManyCardinality) {
+            // Taking a snapshot must not read a pending relation. It has not changed, until it is set.
+            QList<QObject *> relatedObjects = property.peekObjects(object);
+            if(relatedObjects.isEmpty() && QDataSuite::LazyRelations::isPending(object, property))
+                continue;
+
+            QDataSuite::MetaProperty reversePrimaryKey = property.reverseMetaObject().primaryKeyProperty();
+
+            QSet<QVariant> keys;
+            foreach(QObject *relatedObject, relatedObjects) {
+                if(relatedObject)
+                    keys.insert(reversePrimaryKey.read(relatedObject));
+            }
+            snapshot.relatedKeys.insert(QLatin1String(property.name()), keys);
+        }
+    }
+
+    return snapshot;
+}
+
+// Binds the columns of a result set to the properties of a class.
+// A plan depends on the class and the columns of the result, so it is built once for all results of that shape.
+class SqlReadPlan
+{
+public:
+    QVector<QPair<int, QDataSuite::MetaProperty> > properties;
+    QVector<QPair<int, QString> > foreignKeys;
+
+    // Columns, which are neither properties nor foreign keys, end up as dynamic properties
+    QVector<QPair<int, QByteArray> > dynamicProperties;
+};
+
 class SqlDataAccessObjectHelperPrivate : public QSharedData
 {
 public:
@@ -28,11 +196,24 @@ public:
     {}
 
     QSqlDatabase database;
-    mutable QDataSuite::Error lastError;
+    SqlConnectionPool *connectionPool;
 
+    // The helper is shared by all threads, so each of them has its own error
+    QThreadStorage<QDataSuite::Error> lastError;
+
+    // Updates only write what has changed since these snapshots
+    QMutex snapshotsMutex;
+    QHash<const QObject *, ObjectSnapshot> snapshots;
+
+    // Keyed by class name and the column names of the result
+    QMutex readPlansMutex;
+    QHash<QString, SqlReadPlan> readPlans;
+
+    static QMutex helpersMutex;
     static QHash<QString, SqlDataAccessObjectHelper *> helpersForConnection;
 };
 
+QMutex SqlDataAccessObjectHelperPrivate::helpersMutex;
 QHash<QString, SqlDataAccessObjectHelper *> SqlDataAccessObjectHelperPrivate::helpersForConnection;
 
 SqlDataAccessObjectHelper::SqlDataAccessObjectHelper(const QSqlDatabase &database, QObject *parent) :
@@ -40,6 +221,7 @@ SqlDataAccessObjectHelper::SqlDataAccessObjectHelper(const QSqlDatabase &databas
     d(new SqlDataAccessObjectHelperPrivate)
 {
     d->database = database;
+    d->connectionPool = SqlConnectionPool::forDatabase(database);
     SqlQuery query(database);
     query.prepare("PRAGMA foreign_keys = 1;");
     if ( !query.exec()
@@ -56,18 +238,26 @@ SqlDataAccessObjectHelper *SqlDataAccessObjectHelper::forDatabase(const QSqlData
 {
     static QObject guard;
 
-    SqlDataAccessObjectHelper* asd = new SqlDataAccessObjectHelper(database, &guard);
-
+    QMutexLocker locker(&SqlDataAccessObjectHelperPrivate::helpersMutex);
     if(!SqlDataAccessObjectHelperPrivate::helpersForConnection.contains(database.connectionName()))
         SqlDataAccessObjectHelperPrivate::helpersForConnection.insert(database.connectionName(),
-                                                                      asd);
+                                                                      new SqlDataAccessObjectHelper(database, &guard));
 
     return SqlDataAccessObjectHelperPrivate::helpersForConnection.value(database.connectionName());
 }
 
+QSqlDatabase SqlDataAccessObjectHelper::database() const
+{
+    // Every thread uses its own connection
+    return d->connectionPool->database();
+}
+
 int SqlDataAccessObjectHelper::count(const QDataSuite::MetaObject &metaObject) const
 {
-    SqlQuery query(d->database);
+    // The result does not tell about errors, so the caller checks lastError()
+    d->lastError.setLocalData(QDataSuite::Error());
+
+    SqlQuery query(database());
     query.prepare(QString("SELECT COUNT(*) FROM %1")
                   .arg(metaObject.tableName()));
 
@@ -83,8 +273,10 @@ int SqlDataAccessObjectHelper::count(const QDataSuite::MetaObject &metaObject) c
 
 QList<QVariant> SqlDataAccessObjectHelper::allKeys(const QDataSuite::MetaObject &metaObject) const
 {
-    qDebug("\n\nallKeys<%s>", qPrintable(metaObject.tableName()));
-    SqlQuery query(d->database);
+    qCDebug(qpersistenceSql, "allKeys<%s>", qPrintable(metaObject.tableName()));
+    d->lastError.setLocalData(QDataSuite::Error());
+
+    SqlQuery query(database());
     query.clear();
     query.setTable(metaObject.tableName());
     query.addField(metaObject.primaryKeyPropertyName());
@@ -101,6 +293,7 @@ QList<QVariant> SqlDataAccessObjectHelper::allKeys(const QDataSuite::MetaObject
         result.append(query.value(0));
     }
 
+    query.finish();
     return result;
 }
 
@@ -108,11 +301,11 @@ bool SqlDataAccessObjectHelper::readObject(const QDataSuite::MetaObject &metaObj
                                            const QVariant &key,
                                            QObject *object)
 {
-    qDebug("\n\nreadObject<%s>(%s)", qPrintable(metaObject.tableName()), qPrintable(key.toString()));
+    qCDebug(qpersistenceSql, "readObject<%s>(%s)", qPrintable(metaObject.tableName()), qPrintable(key.toString()));
     Q_ASSERT(object);
     Q_ASSERT(!key.isNull());
 
-    SqlQuery query(d->database);
+    SqlQuery query(database());
     query.setTable(metaObject.tableName());
     query.setLimit(1);
     query.setWhereCondition(SqlCondition(metaObject.primaryKeyProperty().columnName(),
@@ -127,17 +320,221 @@ bool SqlDataAccessObjectHelper::readObject(const QDataSuite::MetaObject &metaObj
         return false;
     }
 
-    readQueryIntoObject(query, object);
-    return readRelatedObjects(metaObject, object);
+    ForeignKeyColumns foreignKeys;
+    readQueryIntoObject(query, readPlan(metaObject, query), object, foreignKeys);
+    query.finish();
+
+    QHash<QString, QHash<QVariant, QObject *> > alreadyReadObjectsPerClass;
+    if(!readRelatedObjects(metaObject, QList<QObject *>() << object, foreignKeys, alreadyReadObjectsPerClass))
+        return false;
+
+    rememberObjects(alreadyReadObjectsPerClass);
+    return true;
+}
+
+bool SqlDataAccessObjectHelper::readAllObjects(const QDataSuite::MetaObject &metaObject,
+                                               const QDataSuite::AbstractDataAccessObject *dataAccessObject,
+                                               QList<QObject *> &objects)
+{
+    qCDebug(qpersistenceSql, "readAllObjects<%s>", qPrintable(metaObject.tableName()));
+
+    // Select the whole table at once. We only walk through the result once,
+    // so the driver does not have to buffer the rows it has already returned.
+    SqlQuery query(database());
+    query.setForwardOnly(true);
+    query.setTable(metaObject.tableName());
+    query.prepareSelect();
+
+    return readObjects(metaObject, dataAccessObject, query, objects);
+}
+
+bool SqlDataAccessObjectHelper::readObjects(const QDataSuite::MetaObject &metaObject,
+                                            const QDataSuite::AbstractDataAccessObject *dataAccessObject,
+                                            int offset,
+                                            int limit,
+                                            QList<QObject *> &objects)
+{
+    qCDebug(qpersistenceSql, "readObjects<%s>(%d, %d)", qPrintable(metaObject.tableName()), offset, limit);
+
+    SqlQuery query(database());
+    query.setForwardOnly(true);
+    query.setTable(metaObject.tableName());
+    query.addOrder(metaObject.primaryKeyProperty().columnName());
+    query.setLimit(limit);
+    query.setOffset(offset);
+    query.prepareSelect();
+
+    return readObjects(metaObject, dataAccessObject, query, objects);
+}
+
+bool SqlDataAccessObjectHelper::readObjectsAfter(const QDataSuite::MetaObject &metaObject,
+                                                 const QDataSuite::AbstractDataAccessObject *dataAccessObject,
+                                                 const QVariant &key,
+                                                 int limit,
+                                                 QList<QObject *> &objects)
+{
+    qCDebug(qpersistenceSql, "readObjectsAfter<%s>(%s, %d)", qPrintable(metaObject.tableName()), qPrintable(key.toString()), limit);
+
+    // Unlike an offset, the key lets the database seek directly to the page
+    QDataSuite::MetaProperty primaryKeyProperty = metaObject.primaryKeyProperty();
+
+    SqlQuery query(database());
+    query.setForwardOnly(true);
+    query.setTable(metaObject.tableName());
+    query.setWhereCondition(SqlCondition(primaryKeyProperty.columnName(),
+                                         SqlCondition::GreaterThan,
+                                         normalizedKey(key, primaryKeyProperty.type())));
+    query.addOrder(primaryKeyProperty.columnName());
+    query.setLimit(limit);
+    query.prepareSelect();
+
+    return readObjects(metaObject, dataAccessObject, query, objects);
+}
+
+bool SqlDataAccessObjectHelper::readObjects(const QDataSuite::MetaObject &metaObject,
+                                            const QDataSuite::AbstractDataAccessObject *dataAccessObject,
+                                            SqlQuery &query,
+                                            QList<QObject *> &objects)
+{
+    Q_ASSERT(dataAccessObject);
+
+    if ( !query.exec()
+         || query.lastError().isValid()) {
+        setLastError(query);
+        return false;
+    }
+
+    SqlReadPlan plan = readPlan(metaObject, query);
+    ForeignKeyColumns foreignKeys;
+    QList<QObject *> result;
+    QList<QObject *> newObjects;
+
+    // Objects, which the session already knows, are returned as they are
+    Session *session = Session::current();
+    QString className = QLatin1String(metaObject.className());
+    QDataSuite::MetaProperty primaryKeyProperty = metaObject.primaryKeyProperty();
+    int primaryKeyIndex = query.record().indexOf(primaryKeyProperty.columnName());
+
+    while (query.next()) {
+        QObject *object = 0;
+        if(session) {
+            object = session->object(className, normalizedKey(query.value(primaryKeyIndex),
+                                                              primaryKeyProperty.type()));
+        }
+
+        if(!object) {
+            object = dataAccessObject->createObject();
+            readQueryIntoObject(query, plan, object, foreignKeys);
+            newObjects.append(object);
+        }
+
+        result.append(object);
+    }
+
+    if (query.lastError().isValid()) {
+        setLastError(query);
+        qDeleteAll(newObjects);
+        return false;
+    }
+
+    // Release the statement before the relations issue their own queries
+    query.finish();
+
+    QHash<QString, QHash<QVariant, QObject *> > alreadyReadObjectsPerClass;
+    if(!readRelatedObjects(metaObject, newObjects, foreignKeys, alreadyReadObjectsPerClass)) {
+        qDeleteAll(newObjects);
+        return false;
+    }
+
+    rememberObjects(alreadyReadObjectsPerClass);
+    objects.append(result);
+    return true;
+}
+
+bool SqlDataAccessObjectHelper::openCursor(const QDataSuite::MetaObject &metaObject, SqlQuery *query)
+{
+    qCDebug(qpersistenceSql, "openCursor<%s>", qPrintable(metaObject.tableName()));
+
+    // The driver does not have to buffer the rows, which have already been returned
+    *query = SqlQuery(database());
+    query->setForwardOnly(true);
+    query->setTable(metaObject.tableName());
+    query->prepareSelect();
+
+    if ( !query->exec()
+         || query->lastError().isValid()) {
+        setLastError(*query);
+        return false;
+    }
+
+    return true;
+}
+
+bool SqlDataAccessObjectHelper::readNextObjects(const QDataSuite::MetaObject &metaObject,
+                                                const QDataSuite::AbstractDataAccessObject *dataAccessObject,
+                                                SqlQuery &query,
+                                                int count,
+                                                QList<QObject *> &recycledObjects,
+                                                QList<QObject *> &objects,
+                                                QList<QObject *> *relatedObjects)
+{
+    Q_ASSERT(dataAccessObject);
+    Q_ASSERT(count > 0);
+
+    SqlReadPlan plan = readPlan(metaObject, query);
+    ForeignKeyColumns foreignKeys;
+    QList<QObject *> result;
+    while (result.size() < count && query.next()) {
+        QObject *object = recycledObjects.isEmpty()
+                ? dataAccessObject->createObject()
+                : recycledObjects.takeFirst();
+        readQueryIntoObject(query, plan, object, foreignKeys);
+        result.append(object);
+    }
+
+    // Objects of a failed chunk are handed back to be re-used or deleted by the cursor
+    if (query.lastError().isValid()) {
+        setLastError(query);
+        recycledObjects.append(result);
+        return false;
+    }
+
+    if (result.size() < count)
+        query.finish();
+
+    // The relations of each chunk are read with one query per relation.
+    // The cursor re-uses or deletes the objects of a chunk, so they must not be shared with the session of the thread.
+    // For the same reason, lazy relations are read right away: the cursor has to know all related objects,
+    // and nothing is read into the session of the thread later, after the chunk session is gone.
+    Session chunkSession;
+    QHash<QString, QHash<QVariant, QObject *> > alreadyReadObjectsPerClass;
+    if(!readRelatedObjects(metaObject, result, foreignKeys, alreadyReadObjectsPerClass, true)) {
+        recycledObjects.append(result);
+        return false;
+    }
+
+    if(relatedObjects) {
+        typedef QHash<QVariant, QObject *> ObjectsByKey;
+        QSet<QObject *> chunk = result.toSet();
+        foreach(const ObjectsByKey &alreadyReadObjects, alreadyReadObjectsPerClass) {
+            foreach(QObject *object, alreadyReadObjects) {
+                if(!chunk.contains(object))
+                    relatedObjects->append(object);
+            }
+        }
+    }
+
+    objects.append(result);
+    return true;
 }
 
 bool SqlDataAccessObjectHelper::insertObject(const QDataSuite::MetaObject &metaObject, QObject *object)
 {
-    qDebug("\n\ninsertObject<%s>", qPrintable(metaObject.tableName()));
+    qCDebug(qpersistenceSql, "insertObject<%s>", qPrintable(metaObject.tableName()));
     Q_ASSERT(object);
 
     // Create main INSERT query
-    SqlQuery query(d->database);
+    SqlQuery query(database());
     query.setTable(metaObject.tableName());
     fillValuesIntoQuery(metaObject, object, query);
 
@@ -154,80 +551,325 @@ bool SqlDataAccessObjectHelper::insertObject(const QDataSuite::MetaObject &metaO
     }
 
     // Update related objects
-    return adjustRelations(metaObject, object);
+    if(!adjustRelations(metaObject, QList<const QObject *>() << object))
+        return false;
+
+    takeSnapshot(metaObject, object);
+    rememberObject(metaObject, object);
+    return true;
+}
+
+bool SqlDataAccessObjectHelper::insertObjects(const QDataSuite::MetaObject &metaObject, const QList<QObject *> &objects)
+{
+    qCDebug(qpersistenceSql, "insertObjects<%s>(%d)", qPrintable(metaObject.tableName()), objects.size());
+
+    if(objects.isEmpty())
+        return true;
+
+    // Insert all objects in one transaction, so that the database only has to sync once.
+    // A transaction, which the caller has already begun, is joined through a savepoint.
+    QSqlDatabase database = this->database();
+    bool ownTransaction = database.transaction();
+    if(!ownTransaction) {
+        QSqlQuery savepoint(database);
+        if(!savepoint.exec(QLatin1String("SAVEPOINT qpersistence_insertobjects"))) {
+            setLastError(savepoint);
+            return false;
+        }
+    }
+
+    QList<const QObject *> insertedObjects;
+    foreach(QObject *object, objects) {
+        insertedObjects.append(object);
+    }
+
+    if(!insertRows(metaObject, objects)
+            || !adjustRelations(metaObject, insertedObjects)) {
+        if(ownTransaction) {
+            database.rollback();
+        }
+        else {
+            QSqlQuery rollback(database);
+            rollback.exec(QLatin1String("ROLLBACK TO SAVEPOINT qpersistence_insertobjects"));
+            rollback.exec(QLatin1String("RELEASE SAVEPOINT qpersistence_insertobjects"));
+        }
+        return false;
+    }
+
+    if(!ownTransaction) {
+        QSqlQuery release(database);
+        if(!release.exec(QLatin1String("RELEASE SAVEPOINT qpersistence_insertobjects"))) {
+            setLastError(release);
+            return false;
+        }
+    }
+    else if(!database.commit()) {
+        setLastError(QDataSuite::Error(database.lastError().text(), QDataSuite::Error::SqlError));
+        database.rollback();
+        return false;
+    }
+
+    foreach(QObject *object, objects) {
+        takeSnapshot(metaObject, object);
+        rememberObject(metaObject, object);
+    }
+
+    return true;
+}
+
+bool SqlDataAccessObjectHelper::insertRows(const QDataSuite::MetaObject &metaObject, const QList<QObject *> &objects)
+{
+    QDataSuite::MetaProperty primaryKeyProperty = metaObject.primaryKeyProperty();
+
+    // We need the generated key of every single row. Other databases do not tell, which keys a
+    // multi-row INSERT has generated, so each row gets its own INSERT there.
+    // Since the statement is cached and we are in a transaction, this is still cheap.
+    bool generatesKeys = primaryKeyProperty.isAutoIncremented();
+    if(generatesKeys && !database().driverName().startsWith(QLatin1String("QSQLITE"))) {
+        foreach(QObject *object, objects) {
+            SqlQuery query(database());
+            query.setTable(metaObject.tableName());
+            fillValuesIntoQuery(metaObject, object, query);
+            query.prepareInsert();
+
+            if ( !query.exec()
+                 || query.lastError().isValid()) {
+                setLastError(query);
+                return false;
+            }
+
+            primaryKeyProperty.write(object, query.lastInsertId());
+        }
+
+        return true;
+    }
+
+    // Otherwise insert as many rows per statement, as we may bind values
+    int columnCount = qMax(1, metaObject.simpleProperties().size() + metaObject.relationProperties().size());
+    int rowsPerQuery = qMax(1, MaximumBoundValuesPerQuery / columnCount);
+
+    for(int i = 0; i < objects.size(); i += rowsPerQuery) {
+        SqlQuery query(database());
+        query.setTable(metaObject.tableName());
+
+        foreach(QObject *object, objects.mid(i, rowsPerQuery)) {
+            fillValuesIntoQuery(metaObject, object, query);
+            query.addRow();
+        }
+
+        query.prepareInsert();
+        if ( !query.exec()
+             || query.lastError().isValid()) {
+            setLastError(query);
+            return false;
+        }
+
+        // SQLite numbers the rows of one INSERT consecutively and reports the key of the last one.
+        // Nobody else can insert in between, because our transaction holds the write lock.
+        // This does not hold for tables, whose triggers insert into the same table.
+        if(generatesKeys) {
+            QList<QObject *> insertedObjects = objects.mid(i, rowsPerQuery);
+            qlonglong lastKey = query.lastInsertId().toLongLong();
+            qlonglong firstKey = lastKey - insertedObjects.size() + 1;
+            for(int j = 0; j < insertedObjects.size(); ++j) {
+                primaryKeyProperty.write(insertedObjects.at(j), firstKey + j);
+            }
+        }
+    }
+
+    return true;
 }
 
 bool SqlDataAccessObjectHelper::updateObject(const QDataSuite::MetaObject &metaObject, const QObject *object)
 {
-    qDebug("\n\nupdateObject<%s>", qPrintable(metaObject.tableName()));
+    qCDebug(qpersistenceSql, "updateObject<%s>", qPrintable(metaObject.tableName()));
     Q_ASSERT(object);
 
-    // Create main UPDATE query
-    SqlQuery query(d->database);
+    bool hasSnapshot = false;
+    ObjectSnapshot oldSnapshot;
+    {
+        QMutexLocker locker(&d->snapshotsMutex);
+        hasSnapshot = d->snapshots.contains(object);
+        oldSnapshot = d->snapshots.value(object);
+    }
+
+    // Objects, which have not been read or written by us, are written completely
+    if(!hasSnapshot) {
+        // Create main UPDATE query
+        SqlQuery query(database());
+        query.setTable(metaObject.tableName());
+        query.setWhereCondition(SqlCondition(metaObject.primaryKeyProperty().columnName(),
+                                             SqlCondition::EqualTo,
+                                             metaObject.primaryKeyProperty().read(object)));
+        fillValuesIntoQuery(metaObject, object, query);
+
+        // Insert the object itself
+        query.prepareUpdate();
+        if ( !query.exec()
+             || query.lastError().isValid()) {
+            setLastError(query);
+            return false;
+        }
+
+        // Update related objects
+        if(!adjustRelations(metaObject, QList<const QObject *>() << object))
+            return false;
+
+        takeSnapshot(metaObject, object);
+        rememberObject(metaObject, object);
+        return true;
+    }
+
+    ObjectSnapshot newSnapshot = snapshotOfObject(metaObject, object);
+
+    // Only write the columns, which have changed. Columns, which have no value anymore, become NULL.
+    SqlQuery query(database());
     query.setTable(metaObject.tableName());
     query.setWhereCondition(SqlCondition(metaObject.primaryKeyProperty().columnName(),
                                          SqlCondition::EqualTo,
                                          metaObject.primaryKeyProperty().read(object)));
-    fillValuesIntoQuery(metaObject, object, query);
 
-    // Insert the object itself
-    query.prepareUpdate();
-    if ( !query.exec()
-         || query.lastError().isValid()) {
-        setLastError(query);
+    QSet<QString> columns = oldSnapshot.columns.keys().toSet() + newSnapshot.columns.keys().toSet();
+    foreach(const QString &column, columns) {
+        QVariant value = newSnapshot.columns.value(column);
+        if(oldSnapshot.columns.value(column) != value)
+            query.addField(column, value);
+    }
+
+    // prepareUpdate() fails, if there are no fields
+    if(query.prepareUpdate()) {
+        if ( !query.exec()
+             || query.lastError().isValid()) {
+            setLastError(query);
+            return false;
+        }
+    }
+
+    // Only touch relations, whose members have changed
+    if(!adjustRelations(metaObject, object, oldSnapshot.relatedKeys, newSnapshot.relatedKeys))
         return false;
+
+    {
+        QMutexLocker locker(&d->snapshotsMutex);
+        d->snapshots.insert(object, newSnapshot);
     }
 
-    // Update related objects
-    return adjustRelations(metaObject, object);
+    // A transaction, which is rolled back, has to forget the written state (see Transaction)
+    rememberObject(metaObject, object);
+    return true;
 }
 
 void SqlDataAccessObjectHelper::fillValuesIntoQuery(const QDataSuite::MetaObject &metaObject,
                                                     const QObject *object,
                                                     SqlQuery &query)
 {
-    // Add simple properties
+    QueryFieldsFiller filler(query);
+    visitColumnValues(metaObject, object, filler);
+}
+
+void SqlDataAccessObjectHelper::takeSnapshot(const QDataSuite::MetaObject &metaObject, const QObject *object)
+{
+    ObjectSnapshot snapshot = snapshotOfObject(metaObject, object);
+
+    // The snapshot lives as long as the object, unless the object is removed before
+    connect(object, SIGNAL(destroyed(QObject*)), this, SLOT(removeSnapshot(QObject*)),
+            Qt::ConnectionType(Qt::DirectConnection | Qt::UniqueConnection));
+
+    QMutexLocker locker(&d->snapshotsMutex);
+    d->snapshots.insert(object, snapshot);
+}
+
+void SqlDataAccessObjectHelper::dropSnapshot(const QObject *object)
+{
+    disconnect(object, SIGNAL(destroyed(QObject*)), this, SLOT(removeSnapshot(QObject*)));
+
+    QMutexLocker locker(&d->snapshotsMutex);
+    d->snapshots.remove(object);
+}
+
+void SqlDataAccessObjectHelper::removeSnapshot(QObject *object)
+{
+    QMutexLocker locker(&d->snapshotsMutex);
+    d->snapshots.remove(object);
+}
+
+SqlReadPlan SqlDataAccessObjectHelper::readPlan(const QDataSuite::MetaObject &metaObject,
+                                                const QSqlQuery &query) const
+{
+    QSqlRecord record = query.record();
+    int fieldCount = record.count();
+
+    QString key = QLatin1String(metaObject.className());
+    for (int i = 0; i < fieldCount; ++i) {
+        key.append(',').append(record.fieldName(i));
+    }
+
+    QMutexLocker locker(&d->readPlansMutex);
+    if (d->readPlans.contains(key))
+        return d->readPlans.value(key);
+
+    QHash<QString, QDataSuite::MetaProperty> propertiesByColumn;
     foreach(const QDataSuite::MetaProperty property, metaObject.simpleProperties()) {
-        if(!property.isAutoIncremented()) {
-            query.addField(property.columnName(), property.read(object));
-        }
+        propertiesByColumn.insert(property.columnName(), property);
     }
 
-    // Add relation properties
+    QSet<QString> foreignKeyColumns;
     foreach(const QDataSuite::MetaProperty property, metaObject.relationProperties()) {
         QDataSuite::MetaProperty::Cardinality cardinality = property.cardinality();
-
-        // Only care for "XtoOne" relations, since only they have to be inserted into our table
         if(cardinality == QDataSuite::MetaProperty::ToOneCardinality
                 || cardinality == QDataSuite::MetaProperty::ManyToOneCardinality) {
-            QObject *relatedObject = QDataSuite::MetaObject::objectCast(property.read(object));
-
-            if(!relatedObject)
-                continue;
-
-            QVariant foreignKey = property.reverseMetaObject().primaryKeyProperty().read(relatedObject);
-            query.addField(property.columnName(), foreignKey);
-        }
-        else if(cardinality == QDataSuite::MetaProperty::OneToOneCardinality) {
-            Q_ASSERT_X(false, Q_FUNC_INFO, "OneToOneCardinality relations are not supported yet.");
+            foreignKeyColumns.insert(property.columnName());
         }
     }
-}
 
-void SqlDataAccessObjectHelper::readQueryIntoObject(const QSqlQuery &query, QObject *object)
-{
-    QSqlRecord record = query.record();
-    int fieldCount = record.count();
+    SqlReadPlan plan;
     for (int i = 0; i < fieldCount; ++i) {
         QString fieldName = record.fieldName(i);
-        QVariant value = query.value(i);
-        object->setProperty(fieldName.toLatin1(), value);
+        if (propertiesByColumn.contains(fieldName))
+            plan.properties.append(qMakePair(i, propertiesByColumn.value(fieldName)));
+        else if (foreignKeyColumns.contains(fieldName))
+            plan.foreignKeys.append(qMakePair(i, fieldName));
+        else
+            plan.dynamicProperties.append(qMakePair(i, fieldName.toLatin1()));
     }
+
+    d->readPlans.insert(key, plan);
+    return plan;
 }
 
-bool SqlDataAccessObjectHelper::adjustRelations(const QDataSuite::MetaObject &metaObject, const QObject *object)
+void SqlDataAccessObjectHelper::readQueryIntoObject(const QSqlQuery &query,
+                                                    const SqlReadPlan &plan,
+                                                    QObject *object,
+                                                    ForeignKeyColumns &foreignKeys)
 {
-    QVariant primaryKey = metaObject.primaryKeyProperty().read(object);
+    // A recycled object must not keep the pending relations of its last row
+    QDataSuite::LazyRelations::discardAll(object);
+
+    for (int i = 0; i < plan.properties.size(); ++i) {
+        const QPair<int, QDataSuite::MetaProperty> &binding = plan.properties.at(i);
+        binding.second.write(object, query.value(binding.first));
+    }
+
+    // Foreign keys are only needed to read the related objects
+    for (int i = 0; i < plan.foreignKeys.size(); ++i) {
+        const QPair<int, QString> &binding = plan.foreignKeys.at(i);
+        foreignKeys[binding.second].append(query.value(binding.first));
+    }
+
+    for (int i = 0; i < plan.dynamicProperties.size(); ++i) {
+        const QPair<int, QByteArray> &binding = plan.dynamicProperties.at(i);
+        object->setProperty(binding.second, query.value(binding.first));
+    }
+}
+
+bool SqlDataAccessObjectHelper::adjustRelations(const QDataSuite::MetaObject &metaObject, const QList<const QObject *> &objects)
+{
+    QDataSuite::MetaProperty primaryKeyProperty = metaObject.primaryKeyProperty();
+
+    QList<QVariant> primaryKeys;
+    foreach(const QObject *object, objects) {
+        primaryKeys.append(primaryKeyProperty.read(object));
+    }
 
     QList<SqlQuery> queries;
 
@@ -239,8 +881,103 @@ bool SqlDataAccessObjectHelper::adjustRelations(const QDataSuite::MetaObject &me
                 || cardinality == QDataSuite::MetaProperty::OneToManyCardinality) {
             QDataSuite::MetaProperty reversePrimaryKey = property.reverseMetaObject().primaryKeyProperty();
 
-            // Prepare a query, which resets the relation (set all foreign keys to NULL)
-            SqlQuery resetRelationQuery(d->database);
+            // Relations, which are still pending, have not changed and are not touched.
+            // Writing must not read them, because a failed read would look like an empty relation.
+            QList<QList<QObject *> > relatedObjectsPerObject;
+            QList<QVariant> changedKeys;
+            for(int i = 0; i < objects.size(); ++i) {
+                QList<QObject *> relatedObjects = property.peekObjects(objects.at(i));
+                if(relatedObjects.isEmpty() && QDataSuite::LazyRelations::isPending(objects.at(i), property)) {
+                    relatedObjectsPerObject.append(QList<QObject *>());
+                    continue;
+                }
+
+                relatedObjectsPerObject.append(relatedObjects);
+                changedKeys.append(primaryKeys.at(i));
+            }
+
+            // Prepare queries, which reset the relations of all objects at once (set all foreign keys to NULL)
+            for(int i = 0; i < changedKeys.size(); i += MaximumBoundValuesPerQuery) {
+                SqlQuery resetRelationQuery(database());
+                resetRelationQuery.setTable(property.tableName());
+                resetRelationQuery.addField(property.columnName(), QVariant());
+                resetRelationQuery.setWhereCondition(SqlCondition(property.columnName(),
+                                                                  SqlCondition::In,
+                                                                  QVariant(changedKeys.mid(i, MaximumBoundValuesPerQuery))));
+                resetRelationQuery.prepareUpdate();
+                queries.append(resetRelationQuery);
+            }
+
+            for(int i = 0; i < objects.size(); ++i) {
+                // Check if there are related objects
+                const QList<QObject *> relatedObjects = relatedObjectsPerObject.at(i);
+                if(relatedObjects.isEmpty())
+                    continue;
+
+                QList<QVariant> relatedKeys;
+                foreach(QObject *relatedObject, relatedObjects) {
+                    relatedKeys.append(reversePrimaryKey.read(relatedObject));
+                }
+
+                // Prepare queries, which set the foreign keys of the related objects to our objects key
+                for(int j = 0; j < relatedKeys.size(); j += MaximumBoundValuesPerQuery) {
+                    SqlQuery setForeignKeysQuery(database());
+                    setForeignKeysQuery.setTable(property.tableName());
+                    setForeignKeysQuery.addField(property.columnName(), primaryKeys.at(i));
+                    setForeignKeysQuery.setWhereCondition(SqlCondition(reversePrimaryKey.columnName(),
+                                                                       SqlCondition::In,
+                                                                       QVariant(relatedKeys.mid(j, MaximumBoundValuesPerQuery))));
+                    setForeignKeysQuery.prepareUpdate();
+                    queries.append(setForeignKeysQuery);
+                }
+            }
+        }
+        else if(cardinality == QDataSuite::MetaProperty::ManyToManyCardinality) {
+            Q_ASSERT_X(false, Q_FUNC_INFO, "ManyToManyCardinality relations are not supported yet.");
+        }
+        else if(cardinality == QDataSuite::MetaProperty::OneToOneCardinality) {
+            Q_ASSERT_X(false, Q_FUNC_INFO, "OneToOneCardinality relations are not supported yet.");
+        }
+    }
+
+    foreach(SqlQuery query, queries) {
+        if ( !query.exec()
+             || query.lastError().isValid()) {
+            setLastError(query);
+            return false;
+        }
+    }
+
+    return true;
+}
+
+bool SqlDataAccessObjectHelper::adjustRelations(const QDataSuite::MetaObject &metaObject,
+                                                const QObject *object,
+                                                const QHash<QString, QSet<QVariant> > &oldRelatedKeys,
+                                                const QHash<QString, QSet<QVariant> > &newRelatedKeys)
+{
+    QVariant primaryKey = metaObject.primaryKeyProperty().read(object);
+
+    QList<SqlQuery> queries;
+
+    foreach(const QDataSuite::MetaProperty property, metaObject.relationProperties()) {
+        QDataSuite::MetaProperty::Cardinality cardinality = property.cardinality();
+
+        if(cardinality != QDataSuite::MetaProperty::ToManyCardinality
+                && cardinality != QDataSuite::MetaProperty::OneToManyCardinality) {
+            continue;
+        }
+
+        // A relation, which is still pending, has not changed
+        QString name = QLatin1String(property.name());
+        if(!newRelatedKeys.contains(name))
+            continue;
+
+        QString reversePrimaryKeyColumn = property.reverseMetaObject().primaryKeyProperty().columnName();
+
+        // The old members of a relation, which has been set without ever being read, are unknown
+        if(!oldRelatedKeys.contains(name)) {
+            SqlQuery resetRelationQuery(database());
             resetRelationQuery.setTable(property.tableName());
             resetRelationQuery.addField(property.columnName(), QVariant());
             resetRelationQuery.setWhereCondition(SqlCondition(property.columnName(),
@@ -248,35 +985,38 @@ bool SqlDataAccessObjectHelper::adjustRelations(const QDataSuite::MetaObject &me
                                                               primaryKey));
             resetRelationQuery.prepareUpdate();
             queries.append(resetRelationQuery);
+        }
 
-            // Check if there are related objects
-            QList<QObject *> relatedObjects = QDataSuite::MetaObject::objectListCast(property.read(object));
-            if(relatedObjects.isEmpty())
-                continue;
+        QSet<QVariant> oldKeys = oldRelatedKeys.value(name);
+        QSet<QVariant> newKeys = newRelatedKeys.value(name);
+        QList<QVariant> removedKeys = (oldKeys - newKeys).toList();
+        QList<QVariant> addedKeys = (newKeys - oldKeys).toList();
 
-            // Build an OR'd where clause, which matches all related objects
-            QList<SqlCondition> relatedObjectsWhereClauses;
-            foreach(QObject *relatedObject, relatedObjects) {
-                relatedObjectsWhereClauses.append(SqlCondition(reversePrimaryKey.columnName(),
-                                                               SqlCondition::EqualTo,
-                                                               reversePrimaryKey.read(relatedObject)));
-            }
-            SqlCondition relatedObjectsWhereClause(SqlCondition::Or, relatedObjectsWhereClauses);
+        // Release the removed objects, unless another object has already taken them
+        for(int i = 0; i < removedKeys.size(); i += MaximumBoundValuesPerQuery) {
+            SqlQuery resetRelationQuery(database());
+            resetRelationQuery.setTable(property.tableName());
+            resetRelationQuery.addField(property.columnName(), QVariant());
+            resetRelationQuery.setWhereCondition(SqlCondition(reversePrimaryKeyColumn,
+                                                              SqlCondition::In,
+                                                              QVariant(removedKeys.mid(i, MaximumBoundValuesPerQuery)))
+                                                 && SqlCondition(property.columnName(),
+                                                                 SqlCondition::EqualTo,
+                                                                 primaryKey));
+            resetRelationQuery.prepareUpdate();
+            queries.append(resetRelationQuery);
+        }
 
-            // Prepare a query, which sets the foreign keys of the related objects to our objects key
-            SqlQuery setForeignKeysQuery(d->database);
+        for(int i = 0; i < addedKeys.size(); i += MaximumBoundValuesPerQuery) {
+            SqlQuery setForeignKeysQuery(database());
             setForeignKeysQuery.setTable(property.tableName());
             setForeignKeysQuery.addField(property.columnName(), primaryKey);
-            setForeignKeysQuery.setWhereCondition(relatedObjectsWhereClause);
+            setForeignKeysQuery.setWhereCondition(SqlCondition(reversePrimaryKeyColumn,
+                                                               SqlCondition::In,
+                                                               QVariant(addedKeys.mid(i, MaximumBoundValuesPerQuery))));
             setForeignKeysQuery.prepareUpdate();
             queries.append(setForeignKeysQuery);
         }
-        else if(cardinality == QDataSuite::MetaProperty::ManyToManyCardinality) {
-            Q_ASSERT_X(false, Q_FUNC_INFO, "ManyToManyCardinality relations are not supported yet.");
-        }
-        else if(cardinality == QDataSuite::MetaProperty::OneToOneCardinality) {
-            Q_ASSERT_X(false, Q_FUNC_INFO, "OneToOneCardinality relations are not supported yet.");
-        }
     }
 
     foreach(SqlQuery query, queries) {
@@ -291,98 +1031,282 @@ bool SqlDataAccessObjectHelper::adjustRelations(const QDataSuite::MetaObject &me
 }
 
 bool SqlDataAccessObjectHelper::readRelatedObjects(const QDataSuite::MetaObject &metaObject,
-                                                   QObject *object)
+                                                   const QList<QObject *> &objects,
+                                                   const ForeignKeyColumns &foreignKeys,
+                                                   QHash<QString, QHash<QVariant, QObject *> > &alreadyReadObjectsPerClass,
+                                                   bool readLazyRelations)
 {
-    // This static cache makes this method non-re-entrant!
-    // If we want some kind of thread safety someday, we have to do something about this
-    static QHash<QString, QHash<QVariant, QObject *> > alreadyReadObjectsPerTable;
-    static QObject *objectGraphRoot = 0;
-    if(!objectGraphRoot)
-        objectGraphRoot = object;
+    if(objects.isEmpty())
+        return true;
+
+    QDataSuite::MetaProperty primaryKeyProperty = metaObject.primaryKeyProperty();
 
-    // Insert the current object into the cache
+    // Insert the current objects into the cache
     {
-        QHash<QVariant, QObject *> alreadyReadObjects = alreadyReadObjectsPerTable.value(metaObject.tableName());
-        alreadyReadObjects.insert(metaObject.primaryKeyProperty().read(object), object);
-        alreadyReadObjectsPerTable.insert(metaObject.tableName(), alreadyReadObjects);
+        QHash<QVariant, QObject *> &alreadyReadObjects = alreadyReadObjectsPerClass[QLatin1String(metaObject.className())];
+        foreach(QObject *object, objects) {
+            alreadyReadObjects.insert(primaryKeyProperty.read(object), object);
+        }
     }
 
     foreach(const QDataSuite::MetaProperty property, metaObject.relationProperties()) {
-        QDataSuite::MetaProperty::Cardinality cardinality = property.cardinality();
-
-        QString className = property.reverseClassName();
-        QDataSuite::AbstractDataAccessObject *dao = QDataSuite::MetaObject::dataAccessObject(property.reverseMetaObject(), d->database.connectionName());
-        if(!dao)
+        if(property.isLazy() && !readLazyRelations) {
+            deferRelation(metaObject, property, objects, foreignKeys);
             continue;
+        }
 
-        // Get the already read objects of the related table
-        QHash<QVariant, QObject *> alreadyReadRelatedObjects = alreadyReadObjectsPerTable.value(
-                    property.reverseMetaObject().className());
+        if(!readRelation(metaObject, property, objects, foreignKeys, alreadyReadObjectsPerClass, readLazyRelations))
+            return false;
+    }
 
-        if(cardinality == QDataSuite::MetaProperty::ToOneCardinality
-                || cardinality == QDataSuite::MetaProperty::ManyToOneCardinality) {
-            QVariant foreignKey = object->property(property.columnName().toLatin1());
-            if(foreignKey.isNull())
-                continue;
+    // The objects are complete now
+    foreach(QObject *object, objects) {
+        takeSnapshot(metaObject, object);
+    }
 
-            QObject *relatedObject = 0;
-            if(alreadyReadRelatedObjects.contains(foreignKey)) {
-                relatedObject = alreadyReadRelatedObjects.value(foreignKey);
-            }
-            else {
-                relatedObject = dao->readObject(foreignKey);
+    return true;
+}
+
+bool SqlDataAccessObjectHelper::readRelation(const QDataSuite::MetaObject &metaObject,
+                                             const QDataSuite::MetaProperty &property,
+                                             const QList<QObject *> &objects,
+                                             const ForeignKeyColumns &foreignKeys,
+                                             QHash<QString, QHash<QVariant, QObject *> > &alreadyReadObjectsPerClass,
+                                             bool readLazyRelations)
+{
+    QDataSuite::MetaProperty::Cardinality cardinality = property.cardinality();
+
+    QString className = property.reverseClassName();
+    QDataSuite::MetaObject reverseMetaObject = property.reverseMetaObject();
+    QDataSuite::AbstractDataAccessObject *dao = QDataSuite::MetaObject::dataAccessObject(reverseMetaObject, d->database.connectionName());
+    if(!dao)
+        return true;
+
+    QDataSuite::MetaProperty primaryKeyProperty = metaObject.primaryKeyProperty();
+    QDataSuite::MetaProperty reversePrimaryKey = reverseMetaObject.primaryKeyProperty();
+    QList<QObject *> newObjects;
+    ForeignKeyColumns newForeignKeys;
+
+    if(cardinality == QDataSuite::MetaProperty::ToOneCardinality
+            || cardinality == QDataSuite::MetaProperty::ManyToOneCardinality) {
+        // Collect the foreign keys of all objects
+        QList<QVariant> relatedKeys;
+        QSet<QVariant> unknownForeignKeys;
+        {
+            // Objects, which the session already knows, do not have to be read again
+            Session *session = Session::current();
+            QHash<QVariant, QObject *> &alreadyReadRelatedObjects = alreadyReadObjectsPerClass[className];
+            const QList<QVariant> columnValues = foreignKeys.value(property.columnName());
+            for(int i = 0; i < objects.size(); ++i) {
+                QVariant foreignKey = normalizedKey(columnValues.value(i), reversePrimaryKey.type());
+                relatedKeys.append(foreignKey);
+
+                if(foreignKey.isNull()
+                        || alreadyReadRelatedObjects.contains(foreignKey)) {
+                    continue;
+                }
+
+                QObject *sessionObject = session ? session->object(className, foreignKey) : 0;
+                if(sessionObject)
+                    alreadyReadRelatedObjects.insert(foreignKey, sessionObject);
+                else
+                    unknownForeignKeys.insert(foreignKey);
             }
+        }
 
-            QVariant value = QDataSuite::MetaObject::variantCast(relatedObject, className);
+        // Read all related objects, which we do not know yet, at once
+        if(!readObjects(reverseMetaObject, dao,
+                        reversePrimaryKey.columnName(), reversePrimaryKey.type(),
+                        unknownForeignKeys.toList(),
+                        alreadyReadObjectsPerClass[className],
+                        newObjects, newForeignKeys, 0)
+                || !readRelatedObjects(reverseMetaObject, newObjects, newForeignKeys, alreadyReadObjectsPerClass, readLazyRelations)) {
+            return false;
+        }
+
+        const QHash<QVariant, QObject *> alreadyReadRelatedObjects = alreadyReadObjectsPerClass.value(className);
+        for(int i = 0; i < objects.size(); ++i) {
+            QObject *relatedObject = 0;
+            if(!relatedKeys.at(i).isNull())
+                relatedObject = alreadyReadRelatedObjects.value(relatedKeys.at(i));
 
             // Write the value even if it is NULL
-            object->setProperty(property.name(), value);
+            property.writeObject(objects.at(i), relatedObject);
+        }
+    }
+    else if(cardinality == QDataSuite::MetaProperty::ToManyCardinality
+            || cardinality == QDataSuite::MetaProperty::OneToManyCardinality) {
+        QList<QVariant> keys;
+        foreach(QObject *object, objects) {
+            keys.append(primaryKeyProperty.read(object));
         }
-        else if(cardinality == QDataSuite::MetaProperty::ToManyCardinality
-                || cardinality == QDataSuite::MetaProperty::OneToManyCardinality) {
-            // Construct a query, which selects all rows,
-            // which have our primary key as foreign
-            SqlQuery selectForeignKeysQuery(d->database);
-            selectForeignKeysQuery.setTable(property.tableName()); // select from foreign table
-            selectForeignKeysQuery.addField(property.reverseMetaObject().primaryKeyProperty().columnName());
-            selectForeignKeysQuery.setWhereCondition(SqlCondition(property.columnName(),
-                                                                  SqlCondition::EqualTo,
-                                                                  metaObject.primaryKeyProperty().read(object)));
-            selectForeignKeysQuery.prepareSelect();
-
-            if ( !selectForeignKeysQuery.exec()
-                 || selectForeignKeysQuery.lastError().isValid()) {
-                setLastError(selectForeignKeysQuery);
-                return false;
-            }
 
-            QList<QObject *> relatedObjects;
-            while(selectForeignKeysQuery.next()) {
-                QVariant foreignKey = selectForeignKeysQuery.value(0);
-                QObject *relatedObject = 0;
-                if(alreadyReadRelatedObjects.contains(foreignKey)) {
-                    relatedObject = alreadyReadRelatedObjects.value(foreignKey);
-                }
-                else {
-                    relatedObject = dao->readObject(foreignKey);
-                }
-                relatedObjects.append(relatedObject);
-            }
-            QVariant value = QDataSuite::MetaObject::variantListCast(relatedObjects, className);
-            object->setProperty(property.name(), value);
+        // Select all rows of the foreign table, which have one of our primary keys as foreign key
+        QHash<QVariant, QList<QObject *> > relatedObjectsPerKey;
+        if(!readObjects(reverseMetaObject, dao,
+                        property.columnName(), primaryKeyProperty.type(),
+                        keys,
+                        alreadyReadObjectsPerClass[className],
+                        newObjects, newForeignKeys, &relatedObjectsPerKey)
+                || !readRelatedObjects(reverseMetaObject, newObjects, newForeignKeys, alreadyReadObjectsPerClass, readLazyRelations)) {
+            return false;
         }
-        else if(cardinality == QDataSuite::MetaProperty::ManyToManyCardinality) {
-            Q_ASSERT_X(false, Q_FUNC_INFO, "ManyToManyCardinality relations are not supported yet.");
+
+        foreach(QObject *object, objects) {
+            property.writeObjects(object, relatedObjectsPerKey.value(primaryKeyProperty.read(object)));
         }
-        else if(cardinality == QDataSuite::MetaProperty::OneToOneCardinality) {
-            Q_ASSERT_X(false, Q_FUNC_INFO, "OneToOneCardinality relations are not supported yet.");
+    }
+    else if(cardinality == QDataSuite::MetaProperty::ManyToManyCardinality) {
+        Q_ASSERT_X(false, Q_FUNC_INFO, "ManyToManyCardinality relations are not supported yet.");
+    }
+    else if(cardinality == QDataSuite::MetaProperty::OneToOneCardinality) {
+        Q_ASSERT_X(false, Q_FUNC_INFO, "OneToOneCardinality relations are not supported yet.");
+    }
+
+    return true;
+}
+
+void SqlDataAccessObjectHelper::deferRelation(const QDataSuite::MetaObject &metaObject,
+                                              const QDataSuite::MetaProperty &property,
+                                              const QList<QObject *> &objects,
+                                              const ForeignKeyColumns &foreignKeys)
+{
+    QDataSuite::MetaProperty primaryKeyProperty = metaObject.primaryKeyProperty();
+    QDataSuite::MetaProperty reversePrimaryKey = property.reverseMetaObject().primaryKeyProperty();
+    const QList<QVariant> columnValues = foreignKeys.value(property.columnName());
+
+    for(int i = 0; i < objects.size(); ++i) {
+        // "XtoOne" relations are read by their foreign key, "XtoMany" relations by our primary key
+        QVariant key;
+        if(property.isToOneRelationProperty())
+            key = normalizedKey(columnValues.value(i), reversePrimaryKey.type());
+        else
+            key = primaryKeyProperty.read(objects.at(i));
+
+        // An object without a related object has nothing to read later
+        if(key.isNull()) {
+            QDataSuite::LazyRelations::discard(objects.at(i), property);
+            continue;
         }
+
+        QDataSuite::LazyRelations::defer(objects.at(i), property, key,
+                                         [this, metaObject, property, key](QObject *object) {
+            return resolveRelation(metaObject, property, object, key);
+        });
     }
+}
+
+bool SqlDataAccessObjectHelper::resolveRelation(const QDataSuite::MetaObject &metaObject,
+                                                const QDataSuite::MetaProperty &property,
+                                                QObject *object,
+                                                const QVariant &key)
+{
+    qCDebug(qpersistenceSql, "resolveRelation<%s>(%s)", qPrintable(metaObject.tableName()), property.name());
+
+    // The relation might have been set through the typed setter in the meantime
+    if(property.isToOneRelationProperty() && property.peekObject(object))
+        return true;
+    if(property.isToManyRelationProperty() && !property.peekObjects(object).isEmpty())
+        return true;
+
+    ForeignKeyColumns foreignKeys;
+    if(property.isToOneRelationProperty())
+        foreignKeys[property.columnName()].append(key);
 
-    // clear the caches
-    if(object == objectGraphRoot) {
-        alreadyReadObjectsPerTable.clear();
-        objectGraphRoot = 0;
+    QHash<QString, QHash<QVariant, QObject *> > alreadyReadObjectsPerClass;
+    alreadyReadObjectsPerClass[QLatin1String(metaObject.className())].insert(metaObject.primaryKeyProperty().read(object), object);
+
+    if(!readRelation(metaObject, property, QList<QObject *>() << object, foreignKeys, alreadyReadObjectsPerClass))
+        return false;
+
+    // The object itself might have been read by a cursor, which does not share its objects
+    alreadyReadObjectsPerClass[QLatin1String(metaObject.className())].remove(metaObject.primaryKeyProperty().read(object));
+    rememberObjects(alreadyReadObjectsPerClass);
+
+    // The snapshot did not know the members of the relation yet
+    if(property.isToManyRelationProperty()) {
+        QDataSuite::MetaProperty reversePrimaryKey = property.reverseMetaObject().primaryKeyProperty();
+        QSet<QVariant> keys;
+        foreach(QObject *relatedObject, property.peekObjects(object)) {
+            if(relatedObject)
+                keys.insert(reversePrimaryKey.read(relatedObject));
+        }
+
+        QMutexLocker locker(&d->snapshotsMutex);
+        if(d->snapshots.contains(object))
+            d->snapshots[object].relatedKeys.insert(QLatin1String(property.name()), keys);
+    }
+
+    return true;
+}
+
+bool SqlDataAccessObjectHelper::readObjects(const QDataSuite::MetaObject &metaObject,
+                                            const QDataSuite::AbstractDataAccessObject *dataAccessObject,
+                                            const QString &columnName,
+                                            QVariant::Type columnType,
+                                            const QList<QVariant> &values,
+                                            QHash<QVariant, QObject *> &alreadyReadObjects,
+                                            QList<QObject *> &newObjects,
+                                            ForeignKeyColumns &newForeignKeys,
+                                            QHash<QVariant, QList<QObject *> > *objectsByColumnValue)
+{
+    QDataSuite::MetaProperty primaryKeyProperty = metaObject.primaryKeyProperty();
+    QString primaryKeyColumnName = primaryKeyProperty.columnName();
+    QString className = QLatin1String(metaObject.className());
+    Session *session = Session::current();
+
+    // Select all rows, whose column matches one of the values.
+    // SQLite limits the number of bound values per statement, so we split large sets.
+    for(int i = 0; i < values.size(); i += MaximumBoundValuesPerQuery) {
+        SqlQuery query(database());
+        query.setForwardOnly(true);
+        query.setTable(metaObject.tableName());
+        query.setWhereCondition(SqlCondition(columnName,
+                                             SqlCondition::In,
+                                             QVariant(values.mid(i, MaximumBoundValuesPerQuery))));
+        query.prepareSelect();
+
+        if ( !query.exec()
+             || query.lastError().isValid()) {
+            setLastError(query);
+            return false;
+        }
+
+        QSqlRecord record = query.record();
+        int primaryKeyIndex = record.indexOf(primaryKeyColumnName);
+        int columnIndex = record.indexOf(columnName);
+        SqlReadPlan plan = readPlan(metaObject, query);
+
+        while(query.next()) {
+            QVariant key = normalizedKey(query.value(primaryKeyIndex), primaryKeyProperty.type());
+
+            // Objects, which are part of the current object graph or the session, are not read again
+            QObject *object = alreadyReadObjects.value(key);
+            if(!object && session) {
+                object = session->object(className, key);
+                if(object)
+                    alreadyReadObjects.insert(key, object);
+            }
+
+            if(!object) {
+                object = dataAccessObject->createObject();
+                readQueryIntoObject(query, plan, object, newForeignKeys);
+                alreadyReadObjects.insert(key, object);
+                newObjects.append(object);
+            }
+
+            if(objectsByColumnValue) {
+                QVariant value = normalizedKey(query.value(columnIndex), columnType);
+                (*objectsByColumnValue)[value].append(object);
+            }
+        }
+
+        if(query.lastError().isValid()) {
+            setLastError(query);
+            return false;
+        }
+
+        query.finish();
     }
 
     return true;
@@ -390,10 +1314,10 @@ bool SqlDataAccessObjectHelper::readRelatedObjects(const QDataSuite::MetaObject
 
 bool SqlDataAccessObjectHelper::removeObject(const QDataSuite::MetaObject &metaObject, const QObject *object)
 {
-    qDebug("\n\nremoveObject<%s>", qPrintable(metaObject.tableName()));
+    qCDebug(qpersistenceSql, "removeObject<%s>", qPrintable(metaObject.tableName()));
     Q_ASSERT(object);
 
-    SqlQuery query(d->database);
+    SqlQuery query(database());
     query.setTable(metaObject.tableName());
     query.setWhereCondition(SqlCondition(metaObject.primaryKeyProperty().columnName(),
                                          SqlCondition::EqualTo,
@@ -406,22 +1330,33 @@ bool SqlDataAccessObjectHelper::removeObject(const QDataSuite::MetaObject &metaO
         return false;
     }
 
+    if(Session *session = Session::current())
+        session->removeObject(QLatin1String(metaObject.className()), metaObject.primaryKeyProperty().read(object));
+
+    dropSnapshot(object);
     return true;
 }
 
 QDataSuite::Error SqlDataAccessObjectHelper::lastError() const
 {
-    return d->lastError;
+    return d->lastError.localData();
 }
 
 void SqlDataAccessObjectHelper::setLastError(const QDataSuite::Error &error) const
 {
-    qDebug() << error;
-    d->lastError = error;
+    qCDebug(qpersistenceSql) << error;
+    d->lastError.setLocalData(error);
 }
 
 void SqlDataAccessObjectHelper::setLastError(const QSqlQuery &query) const
 {
+    // The query failed, because the thread did not get a connection
+    QDataSuite::Error connectionError = d->connectionPool->lastError();
+    if(connectionError.isValid()) {
+        setLastError(connectionError);
+        return;
+    }
+
     setLastError(QDataSuite::Error(query.lastError().text().append(": ").append(query.executedQuery()), QDataSuite::Error::SqlError));
 }
 
@@ -3,12 +3,16 @@
 
 #include <QtCore/QObject>
 
-#include <QtCore/QSharedDataPointer>
+#include <QtCore/QExplicitlySharedDataPointer>
+#include <QtCore/QSet>
+#include <QtCore/QVariant>
 #include <QtSql/QSqlDatabase>
 
 namespace QDataSuite {
 class Error;
 class MetaObject;
+class MetaProperty;
+class AbstractDataAccessObject;
 }
 
 class QSqlQuery;
@@ -16,7 +20,13 @@ class QSqlQuery;
 namespace QPersistence {
 
 class SqlQuery;
+class SqlReadPlan;
 class PersistentDataAccessObjectBase;
+class Transaction;
+
+// The foreign key columns of a result set by column name.
+// The values are in the same order as the objects, which have been read.
+typedef QHash<QString, QList<QVariant> > ForeignKeyColumns;
 
 class SqlDataAccessObjectHelperPrivate;
 class SqlDataAccessObjectHelper : public QObject
@@ -30,30 +40,101 @@ public:
     int count(const QDataSuite::MetaObject &metaObject) const;
     QList<QVariant> allKeys(const QDataSuite::MetaObject &metaObject) const;
     bool readObject(const QDataSuite::MetaObject &metaObject, const QVariant &key, QObject *object);
+    bool readAllObjects(const QDataSuite::MetaObject &metaObject,
+                        const QDataSuite::AbstractDataAccessObject *dataAccessObject,
+                        QList<QObject *> &objects);
+    bool readObjects(const QDataSuite::MetaObject &metaObject,
+                     const QDataSuite::AbstractDataAccessObject *dataAccessObject,
+                     int offset,
+                     int limit,
+                     QList<QObject *> &objects);
+    bool readObjectsAfter(const QDataSuite::MetaObject &metaObject,
+                          const QDataSuite::AbstractDataAccessObject *dataAccessObject,
+                          const QVariant &key,
+                          int limit,
+                          QList<QObject *> &objects);
+    // Executes a forward-only query over the whole table
+    bool openCursor(const QDataSuite::MetaObject &metaObject, SqlQuery *query);
+    // Reads at most count rows of an open cursor and their relations.
+    // Objects are taken from recycledObjects before new ones are created.
+    // The related objects, which have been created for the chunk, are appended to relatedObjects.
+    bool readNextObjects(const QDataSuite::MetaObject &metaObject,
+                         const QDataSuite::AbstractDataAccessObject *dataAccessObject,
+                         SqlQuery &query,
+                         int count,
+                         QList<QObject *> &recycledObjects,
+                         QList<QObject *> &objects,
+                         QList<QObject *> *relatedObjects);
     bool insertObject(const QDataSuite::MetaObject &metaObject, QObject *object);
+    bool insertObjects(const QDataSuite::MetaObject &metaObject, const QList<QObject *> &objects);
     bool updateObject(const QDataSuite::MetaObject &metaObject, const QObject *object);
     bool removeObject(const QDataSuite::MetaObject &metaObject, const QObject *object);
-    bool readRelatedObjects(const QDataSuite::MetaObject &metaObject, QObject *object);
 
     QDataSuite::Error lastError() const;
 
+private Q_SLOTS:
+    void removeSnapshot(QObject *object);
+
 private:
-    QSharedDataPointer<SqlDataAccessObjectHelperPrivate> d;
+    QExplicitlySharedDataPointer<SqlDataAccessObjectHelperPrivate> d;
+
+    friend class Transaction;
 
     explicit SqlDataAccessObjectHelper(const QSqlDatabase &database, QObject *parent = 0);
 
+    QSqlDatabase database() const;
     void setLastError(const QDataSuite::Error &error) const;
     void setLastError(const QSqlQuery &query) const;
 
     void fillValuesIntoQuery(const QDataSuite::MetaObject &metaObject,
                              const QObject *object,
                              SqlQuery &queryconst);
+    SqlReadPlan readPlan(const QDataSuite::MetaObject &metaObject, const QSqlQuery &query) const;
     void readQueryIntoObject(const QSqlQuery &query,
-                             QObject *object);
-    bool adjustRelations(const QDataSuite::MetaObject &metaObject, const QObject *object);
+                             const SqlReadPlan &plan,
+                             QObject *object,
+                             ForeignKeyColumns &foreignKeys);
+    void takeSnapshot(const QDataSuite::MetaObject &metaObject, const QObject *object);
+    void dropSnapshot(const QObject *object);
+    bool readObjects(const QDataSuite::MetaObject &metaObject,
+                     const QDataSuite::AbstractDataAccessObject *dataAccessObject,
+                     SqlQuery &query,
+                     QList<QObject *> &objects);
+    bool insertRows(const QDataSuite::MetaObject &metaObject, const QList<QObject *> &objects);
+    bool adjustRelations(const QDataSuite::MetaObject &metaObject, const QList<const QObject *> &objects);
+    bool adjustRelations(const QDataSuite::MetaObject &metaObject,
+                         const QObject *object,
+                         const QHash<QString, QSet<QVariant> > &oldRelatedKeys,
+                         const QHash<QString, QSet<QVariant> > &newRelatedKeys);
+    // Lazy relations are deferred, unless readLazyRelations is set
     bool readRelatedObjects(const QDataSuite::MetaObject &metaObject,
-                            QObject *object,
-                            QHash<QString, QHash<QVariant, QObject *> > &alreadyReadObjectsPerTable);
+                            const QList<QObject *> &objects,
+                            const ForeignKeyColumns &foreignKeys,
+                            QHash<QString, QHash<QVariant, QObject *> > &alreadyReadObjectsPerClass,
+                            bool readLazyRelations = false);
+    bool readRelation(const QDataSuite::MetaObject &metaObject,
+                      const QDataSuite::MetaProperty &property,
+                      const QList<QObject *> &objects,
+                      const ForeignKeyColumns &foreignKeys,
+                      QHash<QString, QHash<QVariant, QObject *> > &alreadyReadObjectsPerClass,
+                      bool readLazyRelations = false);
+    void deferRelation(const QDataSuite::MetaObject &metaObject,
+                       const QDataSuite::MetaProperty &property,
+                       const QList<QObject *> &objects,
+                       const ForeignKeyColumns &foreignKeys);
+    bool resolveRelation(const QDataSuite::MetaObject &metaObject,
+                         const QDataSuite::MetaProperty &property,
+                         QObject *object,
+                         const QVariant &key);
+    bool readObjects(const QDataSuite::MetaObject &metaObject,
+                     const QDataSuite::AbstractDataAccessObject *dataAccessObject,
+                     const QString &columnName,
+                     QVariant::Type columnType,
+                     const QList<QVariant> &values,
+                     QHash<QVariant, QObject *> &alreadyReadObjects,
+                     QList<QObject *> &newObjects,
+                     ForeignKeyColumns &newForeignKeys,
+                     QHash<QVariant, QList<QObject *> > *objectsByColumnValue);
 
 };
 
@@ -1,11 +1,14 @@
 #include "sqlquery.h"
 
 #include "sqlcondition.h"
+#include "sqlstatementcache.h"
+#include "sqlquerylog.h"
 
 #include <QSharedData>
 #include <QStringList>
 #include <QHash>
 #include <QDebug>
+#include <QElapsedTimer>
 #include <QRegularExpressionMatchIterator>
 #define COMMA ,
 
@@ -15,15 +18,22 @@ class SqlQueryPrivate : public QSharedData {
 public:
     SqlQueryPrivate() :
         QSharedData(),
-        limit(-1)
+        limit(-1),
+        offset(0),
+        cachedStatement(false)
     {}
 
+    QSqlDatabase database;
     QString table;
     QHash<QString, QVariant> fields;
+    QList<QHash<QString, QVariant> > rows;
     int limit;
+    int offset;
     SqlCondition whereCondition;
     QList<QPair<QString, SqlQuery::Order> > orderBy;
     QList<QStringList> foreignKeys;
+    QVariantList bindValues;
+    bool cachedStatement;
 };
 
 SqlQuery::SqlQuery() :
@@ -36,6 +46,7 @@ SqlQuery::SqlQuery(const QSqlDatabase &database) :
     QSqlQuery(database),
     d(new SqlQueryPrivate)
 {
+    d->database = database;
 }
 
 SqlQuery::SqlQuery(const SqlQuery &rhs) :
@@ -56,24 +67,30 @@ SqlQuery &SqlQuery::operator=(const SqlQuery &rhs)
 
 SqlQuery::~SqlQuery()
 {
+    // The statement cache holds another reference to our statement. It hands out finished
+    // statements only, and an unfinished SELECT would keep its locks.
+    if(d->cachedStatement
+            && d->ref.load() == 1
+            && isActive()) {
+        finish();
+    }
 }
 
 bool SqlQuery::exec()
 {
-    bool ok = QSqlQuery::exec();
-    QString query = executedQuery();
-    int index = query.indexOf('?');
-    int i = 0;
-    QList<QVariant> values = boundValues().values();
-    while (index >= 0) {
-        QString value = values.at(i).toString();
-        if(value.isEmpty())
-            value = QLatin1String("NULL");
-        query.replace(index, 1, value);
-        index = query.indexOf('?', index + value.length());
-        ++i;
+    // Values are bound right before executing, because cached statements
+    // may be shared by several queries with the same SQL text.
+    for(int i = 0; i < d->bindValues.size(); ++i) {
+        QSqlQuery::bindValue(i, d->bindValues.at(i));
     }
-    qDebug() << qPrintable(query);
+
+    if(!SqlQueryLog::isEnabled())
+        return QSqlQuery::exec();
+
+    QElapsedTimer timer;
+    timer.start();
+    bool ok = QSqlQuery::exec();
+    SqlQueryLog::log(*this, timer.nsecsElapsed());
     return ok;
 }
 
@@ -84,14 +101,22 @@ QString SqlQuery::table() const
 
 void SqlQuery::clear()
 {
+    // Give the statement back to the cache
+    if(d->cachedStatement && isActive())
+        finish();
+
     QSqlQuery::clear();
 
     d->table = QString();
     d->fields.clear();
+    d->rows.clear();
     d->limit = -1;
+    d->offset = 0;
     d->whereCondition = SqlCondition();
     d->orderBy.clear();
     d->foreignKeys.clear();
+    d->bindValues.clear();
+    d->cachedStatement = false;
 }
 
 void SqlQuery::setTable(const QString &table)
@@ -104,6 +129,12 @@ void SqlQuery::addField(const QString &name, const QVariant &value)
     d->fields.insert(name, value);
 }
 
+void SqlQuery::addRow()
+{
+    d->rows.append(d->fields);
+    d->fields.clear();
+}
+
 void SqlQuery::addForeignKey(const QString &columnName, const QString &keyName, const QString &foreignTableName)
 {
     d->foreignKeys.append(QStringList() << columnName << keyName << foreignTableName);
@@ -114,6 +145,11 @@ void SqlQuery::setLimit(int limit)
     d->limit = limit;
 }
 
+void SqlQuery::setOffset(int offset)
+{
+    d->offset = offset;
+}
+
 void SqlQuery::setWhereCondition(const SqlCondition &condition)
 {
     d->whereCondition = condition;
@@ -167,6 +203,25 @@ void SqlQuery::prepareAlterTable()
                        .arg(d->fields.values().first().toString()));
 }
 
+void SqlQuery::prepareCreateIndex(const QString &name, const QStringList &columns, bool unique)
+{
+    QStringList quotedColumns;
+    foreach(const QString &column, columns) {
+        quotedColumns.append(QString("\"%1\"").arg(column));
+    }
+
+    QSqlQuery::prepare(QString("CREATE %1INDEX IF NOT EXISTS \"%2\" ON \"%3\" (%4);")
+                       .arg(unique ? QLatin1String("UNIQUE ") : QLatin1String(""))
+                       .arg(name)
+                       .arg(d->table)
+                       .arg(quotedColumns.join(", ")));
+}
+
+void SqlQuery::prepareDropIndex(const QString &name)
+{
+    QSqlQuery::prepare(QString("DROP INDEX IF EXISTS \"%1\";").arg(name));
+}
+
 void SqlQuery::prepareSelect()
 {
     QString query("SELECT ");
@@ -202,15 +257,18 @@ void SqlQuery::prepareSelect()
         query.append(orderClauses.join(','));
     }
 
-    if(d->limit >= 0) {
-        query.append(QString("\n\tLIMIT %1").arg(d->limit));
+    // Limit and offset are bound, so that all pages share one statement
+    if(d->limit >= 0 || d->offset > 0) {
+        query.append("\n\tLIMIT ? OFFSET ?");
     }
 
     query.append(';');
-    QSqlQuery::prepare(query);
+    prepareStatement(query);
 
-    foreach(const QVariant value, d->whereCondition.bindValues()) {
-        QSqlQuery::addBindValue(value);
+    d->bindValues = d->whereCondition.bindValues();
+    if(d->limit >= 0 || d->offset > 0) {
+        d->bindValues.append(d->limit);
+        d->bindValues.append(d->offset);
     }
 }
 
@@ -233,40 +291,62 @@ bool SqlQuery::prepareUpdate()
     }
 
     query.append(';');
-    QSqlQuery::prepare(query);
+    prepareStatement(query);
 
-    foreach(const QVariant value, d->fields.values()) {
-        QSqlQuery::addBindValue(value);
-    }
-    foreach(const QVariant value, d->whereCondition.bindValues()) {
-        QSqlQuery::addBindValue(value);
-    }
+    d->bindValues = d->fields.values();
+    d->bindValues.append(d->whereCondition.bindValues());
 
     return true;
 }
 
 void SqlQuery::prepareInsert()
 {
+    // Rows added with addRow() are inserted by one multi-row INSERT.
+    // Fields, which are missing in a row, are inserted as NULL.
+    typedef QHash<QString, QVariant> Row;
+    QList<Row> rows = d->rows;
+    if(rows.isEmpty() || !d->fields.isEmpty())
+        rows.append(d->fields);
+
+    QStringList columns;
+    foreach(const Row &row, rows) {
+        foreach(const QString &field, row.keys()) {
+            if(!columns.contains(field))
+                columns.append(field);
+        }
+    }
+
     QString query("INSERT INTO \"");
     query.append(d->table).append("\"\n\t(");
 
     QStringList fields;
-    foreach(const QString &field, d->fields.keys()) {
+    foreach(const QString &field, columns) {
         fields.append(QString("\"%1\"").arg(field));
     }
     query.append(fields.join(", "));
 
-    query.append(")\n\tVALUES (");
-    query.append(QString("?, ").repeated(fields.size() - 1));
+    QString placeholders("(");
+    placeholders.append(QString("?, ").repeated(fields.size() - 1));
     if(fields.size() > 0)
-        query.append("?");
+        placeholders.append("?");
+    placeholders.append(")");
 
-    query.append(");");
+    QStringList values;
+    for(int i = 0; i < rows.size(); ++i) {
+        values.append(placeholders);
+    }
 
-    QSqlQuery::prepare(query);
+    query.append(")\n\tVALUES ");
+    query.append(values.join(",\n\t\t"));
+    query.append(";");
+
+    prepareStatement(query);
 
-    foreach(const QVariant value, d->fields.values()) {
-        QSqlQuery::addBindValue(value);
+    d->bindValues.clear();
+    foreach(const Row &row, rows) {
+        foreach(const QString &field, columns) {
+            d->bindValues.append(row.value(field));
+        }
     }
 }
 
@@ -280,10 +360,37 @@ void SqlQuery::prepareDelete()
     }
 
     query.append(';');
-    QSqlQuery::prepare(query);
+    prepareStatement(query);
+
+    d->bindValues = d->whereCondition.bindValues();
+}
+
+void SqlQuery::prepareStatement(const QString &query)
+{
+    d->bindValues.clear();
+    if(d->cachedStatement && isActive())
+        finish();
+    d->cachedStatement = false;
+
+    if(!d->database.isValid()) {
+        QSqlQuery::prepare(query);
+        return;
+    }
+
+    SqlStatementCache *cache = SqlStatementCache::forDatabase(d->database);
+    bool forwardOnly = isForwardOnly();
+
+    QSqlQuery statement;
+    if(cache->statement(query, statement)) {
+        QSqlQuery::operator =(statement);
+        setForwardOnly(forwardOnly);
+        d->cachedStatement = true;
+        return;
+    }
 
-    foreach(const QVariant value, d->whereCondition.bindValues()) {
-        QSqlQuery::addBindValue(value);
+    if(QSqlQuery::prepare(query)) {
+        cache->insertStatement(query, *this);
+        d->cachedStatement = true;
     }
 }
 
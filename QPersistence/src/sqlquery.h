@@ -4,6 +4,7 @@
 #include <QtSql/QSqlQuery>
 
 #include <QtCore/QExplicitlySharedDataPointer>
+#include <QtCore/QStringList>
 #include <QtCore/QVariant>
 
 namespace QPersistence {
@@ -32,14 +33,18 @@ public:
     void clear();
     void setTable(const QString &table);
     void addField(const QString &name, const QVariant &value = QVariant());
+    void addRow();
     void addForeignKey(const QString &columnName, const QString &keyName, const QString &foreignTableName);
     void setLimit(int limit);
+    void setOffset(int offset);
     void setWhereCondition(const SqlCondition &condition);
     void addOrder(const QString &field, Order order = Ascending);
 
     void prepareCreateTable();
     void prepareDropTable();
     void prepareAlterTable();
+    void prepareCreateIndex(const QString &name, const QStringList &columns, bool unique = false);
+    void prepareDropIndex(const QString &name);
 
     void prepareSelect();
     bool prepareUpdate();
@@ -48,6 +53,8 @@ public:
 
 private:
     QExplicitlySharedDataPointer<SqlQueryPrivate> d;
+
+    void prepareStatement(const QString &query);
 };
 
 } // namespace QPersistence
@@ -0,0 +1,105 @@
+#include "sqlquerylog.h"
+
+#include <QAtomicInt>
+#include <QSqlQuery>
+#include <QStringList>
+#include <QVariant>
+
+namespace QPersistence {
+
+// Defined by hand instead of with Q_LOGGING_CATEGORY, so that setLevel() can enable its debug messages
+static QLoggingCategory &sqlCategory()
+{
+    static QLoggingCategory category("qpersistence.sql", QtWarningMsg);
+    return category;
+}
+
+const QLoggingCategory &qpersistenceSql()
+{
+    return sqlCategory();
+}
+
+static QAtomicInt logLevel(SqlQueryLog::Off);
+static QAtomicInt samplingInterval(1);
+static QAtomicInt sampledQueries(0);
+static QAtomicInt slowQueryThresholdMsecs(100);
+
+static QString boundValuesToString(const QSqlQuery &query)
+{
+    QStringList values;
+    foreach(const QVariant &value, query.boundValues().values()) {
+        values.append(value.isNull() ? QLatin1String("NULL") : value.toString());
+    }
+    return values.join(", ");
+}
+
+SqlQueryLog::Level SqlQueryLog::level()
+{
+    return static_cast<Level>(logLevel.load());
+}
+
+void SqlQueryLog::setLevel(SqlQueryLog::Level level)
+{
+    logLevel.store(level);
+
+    // Debug messages of the category are off by default
+    sqlCategory().setEnabled(QtDebugMsg, level == AllQueries);
+}
+
+double SqlQueryLog::samplingRate()
+{
+    return 1.0 / samplingInterval.load();
+}
+
+void SqlQueryLog::setSamplingRate(double rate)
+{
+    Q_ASSERT(rate > 0 && rate <= 1);
+
+    // We log every n-th query instead of rolling dice for each one
+    samplingInterval.store(qMax(1, qRound(1.0 / rate)));
+}
+
+int SqlQueryLog::slowQueryThreshold()
+{
+    return slowQueryThresholdMsecs.load();
+}
+
+void SqlQueryLog::setSlowQueryThreshold(int msecs)
+{
+    slowQueryThresholdMsecs.store(msecs);
+}
+
+bool SqlQueryLog::isEnabled()
+{
+    return logLevel.load() != Off;
+}
+
+void SqlQueryLog::log(const QSqlQuery &query, qint64 nsecsElapsed)
+{
+    Level currentLevel = level();
+    if(currentLevel == Off)
+        return;
+
+    double msecs = nsecsElapsed / 1000000.0;
+
+    if(msecs >= slowQueryThreshold()) {
+        qCWarning(qpersistenceSql, "Slow query (%.3f ms): %s [%s]",
+                  msecs,
+                  qPrintable(query.executedQuery()),
+                  qPrintable(boundValuesToString(query)));
+        return;
+    }
+
+    if(currentLevel < AllQueries)
+        return;
+
+    if(sampledQueries.fetchAndAddRelaxed(1) % samplingInterval.load() != 0)
+        return;
+
+    qCDebug(qpersistenceSql, "Query (%.3f ms): %s [%s]",
+            msecs,
+            qPrintable(query.executedQuery()),
+            qPrintable(boundValuesToString(query)));
+}
+
+} // namespace QPersistence
@@ -0,0 +1,44 @@
+#ifndef QPERSISTENCE_SQLQUERYLOG_H
+#define QPERSISTENCE_SQLQUERYLOG_H
+
+#include <QtCore/QLoggingCategory>
+
+class QSqlQuery;
+
+namespace QPersistence {
+
+Q_DECLARE_LOGGING_CATEGORY(qpersistenceSql)
+
+// Opt-in logging of executed queries to the "qpersistence.sql" category.
+// While the level is Off, executing a query does not do any logging work at all.
+class SqlQueryLog
+{
+public:
+    enum Level {
+        Off,
+        SlowQueries,    // queries, which take longer than slowQueryThreshold(), as warnings
+        AllQueries      // additionally every sampled query as debug message
+    };
+
+    static Level level();
+    // Enables the debug messages of the category on the AllQueries level and disables them otherwise.
+    // Logging rules, which are set later (e.g. QLoggingCategory::setFilterRules()), take precedence.
+    static void setLevel(Level level);
+
+    // The share of queries, which are logged on the AllQueries level (between 0 and 1)
+    static double samplingRate();
+    static void setSamplingRate(double rate);
+
+    static int slowQueryThreshold();
+    static void setSlowQueryThreshold(int msecs);
+
+    static bool isEnabled();
+    static void log(const QSqlQuery &query, qint64 nsecsElapsed);
+
+private:
+    SqlQueryLog();
+};
+
+} // namespace QPersistence
+
+#endif // QPERSISTENCE_SQLQUERYLOG_H
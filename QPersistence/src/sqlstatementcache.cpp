@@ -0,0 +1,129 @@
+#include "sqlstatementcache.h"
+
+#include <QAtomicInt>
+#include <QCache>
+#include <QHash>
+#include <QMutex>
+#include <QSqlQuery>
+
+namespace QPersistence {
+
+class SqlStatementCachePrivate : public QSharedData
+{
+public:
+    SqlStatementCachePrivate() :
+        QSharedData(),
+        statements(100),
+        hits(0),
+        misses(0)
+    {}
+
+    QSqlDatabase database;
+
+    // The key of a statement is its SQL text, which is determined by
+    // the table, the operation, the set of fields and the shape of the WHERE condition.
+    // Bound values never are part of the text.
+    QCache<QString, QSqlQuery> statements;
+
+    // Read by monitoring code in other threads
+    QAtomicInt hits;
+    QAtomicInt misses;
+
+    // Each connection is used by one thread only, but the registry is shared
+    static QMutex cachesMutex;
+    static QHash<QString, SqlStatementCache *> cachesForConnection;
+};
+
+QMutex SqlStatementCachePrivate::cachesMutex;
+QHash<QString, SqlStatementCache *> SqlStatementCachePrivate::cachesForConnection;
+
+SqlStatementCache::SqlStatementCache(const QSqlDatabase &database) :
+    d(new SqlStatementCachePrivate)
+{
+    d->database = database;
+}
+
+SqlStatementCache::~SqlStatementCache()
+{
+}
+
+SqlStatementCache *SqlStatementCache::forDatabase(const QSqlDatabase &database)
+{
+    QString connectionName = database.connectionName();
+
+    QMutexLocker locker(&SqlStatementCachePrivate::cachesMutex);
+    if(!SqlStatementCachePrivate::cachesForConnection.contains(connectionName))
+        SqlStatementCachePrivate::cachesForConnection.insert(connectionName,
+                                                             new SqlStatementCache(database));
+
+    return SqlStatementCachePrivate::cachesForConnection.value(connectionName);
+}
+
+void SqlStatementCache::removeDatabase(const QString &connectionName)
+{
+    QMutexLocker locker(&SqlStatementCachePrivate::cachesMutex);
+    delete SqlStatementCachePrivate::cachesForConnection.take(connectionName);
+}
+
+bool SqlStatementCache::statement(const QString &query, QSqlQuery &statement)
+{
+    QSqlQuery *cached = d->statements.object(query);
+
+    // Copies of a QSqlQuery share their result. An active statement is still being used by
+    // someone else (a SELECT being iterated, or the affected rows and inserted id of a write),
+    // which executing it again would reset. Only finished statements are handed out.
+    if(!cached || cached->isActive()) {
+        d->misses.ref();
+        return false;
+    }
+
+    d->hits.ref();
+    statement = *cached;
+    return true;
+}
+
+void SqlStatementCache::insertStatement(const QString &query, const QSqlQuery &statement)
+{
+    if(d->statements.maxCost() <= 0)
+        return;
+
+    d->statements.insert(query, new QSqlQuery(statement));
+}
+
+void SqlStatementCache::clear()
+{
+    d->statements.clear();
+}
+
+int SqlStatementCache::maximumSize() const
+{
+    return d->statements.maxCost();
+}
+
+void SqlStatementCache::setMaximumSize(int size)
+{
+    d->statements.setMaxCost(size);
+}
+
+int SqlStatementCache::size() const
+{
+    return d->statements.size();
+}
+
+int SqlStatementCache::hits() const
+{
+    return d->hits.load();
+}
+
+int SqlStatementCache::misses() const
+{
+    return d->misses.load();
+}
+
+void SqlStatementCache::resetStatistics()
+{
+    d->hits.store(0);
+    d->misses.store(0);
+}
+
+} // namespace QPersistence
@@ -0,0 +1,41 @@
+#ifndef QPERSISTENCE_SQLSTATEMENTCACHE_H
+#define QPERSISTENCE_SQLSTATEMENTCACHE_H
+
+#include <QtCore/QExplicitlySharedDataPointer>
+#include <QtSql/QSqlDatabase>
+
+class QSqlQuery;
+
+namespace QPersistence {
+
+class SqlStatementCachePrivate;
+class SqlStatementCache
+{
+public:
+    ~SqlStatementCache();
+
+    static SqlStatementCache *forDatabase(const QSqlDatabase &database = QSqlDatabase::database());
+    static void removeDatabase(const QString &connectionName);
+
+    bool statement(const QString &query, QSqlQuery &statement);
+    void insertStatement(const QString &query, const QSqlQuery &statement);
+    void clear();
+
+    int maximumSize() const;
+    void setMaximumSize(int size);
+    int size() const;
+
+    int hits() const;
+    int misses() const;
+    void resetStatistics();
+
+private:
+    QExplicitlySharedDataPointer<SqlStatementCachePrivate> d;
+
+    explicit SqlStatementCache(const QSqlDatabase &database);
+    Q_DISABLE_COPY(SqlStatementCache)
+};
+
+} // namespace QPersistence
+
+#endif // QPERSISTENCE_SQLSTATEMENTCACHE_H
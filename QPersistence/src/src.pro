@@ -9,7 +9,7 @@ include($$QPERSISTENCE_PATH/QPersistence.pri)
 TARGET          = $$QPERSISTENCE_TARGET
 VERSION         = $$QPERSISTENCE_VERSION
 TEMPLATE        = lib
-QT              += sql
+QT              += sql concurrent
 QT              -= gui
 CONFIG          += static c++11
 QMAKE_CXXFLAGS  += $$QDATASUITE_COMMON_QMAKE_CXXFLAGS
@@ -29,11 +29,23 @@ HEADERS += \
     sqldataaccessobjecthelper.h \
     persistentdataaccessobject.h \
     sqlquery.h \
-    sqlcondition.h
+    sqlcondition.h \
+    sqlstatementcache.h \
+    sqlconnectionpool.h \
+    sqlquerylog.h \
+    cursor.h \
+    session.h \
+    transaction.h
 
 SOURCES += \
     databaseschema.cpp \
     sqldataaccessobjecthelper.cpp \
     persistentdataaccessobject.cpp \
     sqlquery.cpp \
-    sqlcondition.cpp
+    sqlcondition.cpp \
+    sqlstatementcache.cpp \
+    sqlconnectionpool.cpp \
+    sqlquerylog.cpp \
+    cursor.cpp \
+    session.cpp \
+    transaction.cpp
@@ -0,0 +1,97 @@
+#include "transaction.h"
+
+#include "session.h"
+#include "sqldataaccessobjecthelper.h"
+
+#include <QDataSuite/error.h>
+
+#include <QSharedData>
+#include <QSqlError>
+
+namespace QPersistence {
+
+class TransactionPrivate : public QSharedData
+{
+public:
+    TransactionPrivate() :
+        QSharedData(),
+        helper(0),
+        active(false)
+    {}
+
+    SqlDataAccessObjectHelper *helper;
+    QSqlDatabase database;
+    bool active;
+    QDataSuite::Error lastError;
+
+    // Opened with the transaction, so that it is the innermost session of the thread
+    Session session;
+};
+
+Transaction::Transaction(const QSqlDatabase &database) :
+    d(new TransactionPrivate)
+{
+    // The data access objects of this thread use the same pooled connection
+    d->helper = SqlDataAccessObjectHelper::forDatabase(database);
+    d->database = d->helper->database();
+
+    d->active = d->database.transaction();
+    if(!d->active) {
+        d->lastError = QDataSuite::Error(QString("Could not begin a transaction: %1")
+                                         .arg(d->database.lastError().text()),
+                                         QDataSuite::Error::SqlError);
+    }
+}
+
+Transaction::~Transaction()
+{
+    rollback();
+}
+
+bool Transaction::isActive() const
+{
+    return d->active;
+}
+
+bool Transaction::commit()
+{
+    if(!d->active)
+        return false;
+
+    if(!d->database.commit()) {
+        d->lastError = QDataSuite::Error(d->database.lastError().text(), QDataSuite::Error::SqlError);
+        rollback();
+        return false;
+    }
+
+    d->active = false;
+    return true;
+}
+
+void Transaction::rollback()
+{
+    if(!d->active)
+        return;
+
+    d->database.rollback();
+    d->active = false;
+
+    // The snapshots of these objects describe rows, which have been rolled back.
+    // Without them, the next update writes the objects completely.
+    foreach(QObject *object, d->session.objects()) {
+        d->helper->dropSnapshot(object);
+    }
+    d->session.clear();
+}
+
+Session *Transaction::session() const
+{
+    return &d->session;
+}
+
+QDataSuite::Error Transaction::lastError() const
+{
+    return d->lastError;
+}
+
+} // namespace QPersistence
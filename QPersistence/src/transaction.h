@@ -0,0 +1,43 @@
+#ifndef QPERSISTENCE_TRANSACTION_H
+#define QPERSISTENCE_TRANSACTION_H
+
+#include <QtCore/QExplicitlySharedDataPointer>
+#include <QtSql/QSqlDatabase>
+
+namespace QDataSuite {
+class Error;
+}
+
+namespace QPersistence {
+
+class Session;
+
+// A transaction on the connection of the current thread, which is one unit of work:
+// it opens a session, so that all reads and writes within the transaction share their objects.
+// A rollback makes the session forget its objects and the data access objects forget, what they
+// have read and written within the transaction, because it never made it into the database.
+// Transactions, which are neither committed nor rolled back, are rolled back when destroyed.
+// Create one on the stack. Transactions do not nest.
+class TransactionPrivate;
+class Transaction
+{
+public:
+    explicit Transaction(const QSqlDatabase &database = QSqlDatabase::database());
+    ~Transaction();
+
+    bool isActive() const;
+    bool commit();
+    void rollback();
+
+    Session *session() const;
+    QDataSuite::Error lastError() const;
+
+private:
+    QExplicitlySharedDataPointer<TransactionPrivate> d;
+
+    Q_DISABLE_COPY(Transaction)
+};
+
+} // namespace QPersistence
+
+#endif // QPERSISTENCE_TRANSACTION_H
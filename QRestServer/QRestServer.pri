@@ -5,7 +5,7 @@ isEmpty(QRESTSERVER_PATH) {
 QRESTSERVER_TARGET          = qrestserver
 QRESTSERVER_VERSION         = 0.0.0
 QRESTSERVER_INCLUDEPATH     = $$PWD/include
-QRESTSERVER_LIBS            = -L$$QRESTSERVER_PATH/src -l$$QRESTSERVER_TARGET
+QRESTSERVER_LIBS            = -L$$QRESTSERVER_PATH/src -l$$QRESTSERVER_TARGET -lz
 
 QHTTPSERVER_INCLUDEPATH     = $$PWD/lib/qhttpserver/src/src
 QHTTPSERVER_LIBS            = -L$$PWD/lib/qhttpserver/lib -lqhttpserver
@@ -0,0 +1 @@
+#include "../../src/responsecache.h"
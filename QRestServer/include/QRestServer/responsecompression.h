@@ -0,0 +1 @@
+#include "../../src/responsecompression.h"
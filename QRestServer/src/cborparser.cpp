@@ -0,0 +1,279 @@
+#include "cborparser.h"
+
+#include <QDateTime>
+#include <QtEndian>
+
+#include <cmath>
+#include <cstring>
+#include <limits>
+
+namespace QRestServer {
+
+static const int MaximumNestingDepth = 64;
+static const uchar CborBreak = 0xff;
+static const int CborIndefiniteLength = 31;
+
+class CborReader
+{
+public:
+    explicit CborReader(const QByteArray &data) :
+        data(data),
+        position(0)
+    {}
+
+    QVariant readItem(int depth = 0);
+    bool atEnd() const { return position >= data.size(); }
+
+    QString error;
+
+private:
+    const QByteArray &data;
+    int position;
+
+    const uchar *current() const { return reinterpret_cast<const uchar *>(data.constData()) + position; }
+    bool need(quint64 bytes);
+    bool readLength(int additional, quint64 *value);
+    bool readBreak();
+    QByteArray readString(int majorType, int additional, int depth);
+    QVariant fail(const QString &message);
+};
+
+QVariant CborReader::fail(const QString &message)
+{
+    if(error.isEmpty())
+        error = QString("%1 at offset %2").arg(message).arg(position);
+    return QVariant();
+}
+
+bool CborReader::need(quint64 bytes)
+{
+    if(quint64(data.size() - position) >= bytes)
+        return true;
+
+    fail(QLatin1String("Unexpected end of data"));
+    return false;
+}
+
+bool CborReader::readLength(int additional, quint64 *value)
+{
+    if(additional < 24) {
+        *value = quint64(additional);
+        return true;
+    }
+
+    switch(additional) {
+    case 24:
+        if(!need(1)) return false;
+        *value = *current();
+        position += 1;
+        return true;
+    case 25:
+        if(!need(2)) return false;
+        *value = qFromBigEndian<quint16>(current());
+        position += 2;
+        return true;
+    case 26:
+        if(!need(4)) return false;
+        *value = qFromBigEndian<quint32>(current());
+        position += 4;
+        return true;
+    case 27:
+        if(!need(8)) return false;
+        *value = qFromBigEndian<quint64>(current());
+        position += 8;
+        return true;
+    default:
+        fail(QLatin1String("Invalid length"));
+        return false;
+    }
+}
+
+bool CborReader::readBreak()
+{
+    if(!need(1))
+        return false;
+
+    if(*current() != CborBreak)
+        return false;
+
+    ++position;
+    return true;
+}
+
+QByteArray CborReader::readString(int majorType, int additional, int depth)
+{
+    if(additional == CborIndefiniteLength) {
+        // Definite length chunks of the same type until a break
+        QByteArray result;
+        while(error.isEmpty() && !readBreak()) {
+            if(!error.isEmpty() || ((*current() >> 5) != majorType)) {
+                fail(QLatin1String("Invalid chunk of an indefinite length string"));
+                return QByteArray();
+            }
+
+            int chunkAdditional = *current() & 0x1f;
+            ++position;
+            if(chunkAdditional == CborIndefiniteLength) {
+                fail(QLatin1String("Nested indefinite length string"));
+                return QByteArray();
+            }
+            result.append(readString(majorType, chunkAdditional, depth));
+        }
+        return result;
+    }
+
+    quint64 length;
+    if(!readLength(additional, &length) || !need(length))
+        return QByteArray();
+
+    QByteArray result(data.constData() + position, int(length));
+    position += int(length);
+    return result;
+}
+
+QVariant CborReader::readItem(int depth)
+{
+    if(depth > MaximumNestingDepth)
+        return fail(QLatin1String("Nesting too deep"));
+
+    if(!need(1))
+        return QVariant();
+
+    uchar initial = *current();
+    ++position;
+    int majorType = initial >> 5;
+    int additional = initial & 0x1f;
+    quint64 value = 0;
+
+    switch(majorType) {
+    case 0:
+        if(!readLength(additional, &value))
+            return QVariant();
+        if(value > quint64(std::numeric_limits<qint64>::max()))
+            return QVariant(value);
+        return QVariant(qint64(value));
+    case 1:
+        if(!readLength(additional, &value))
+            return QVariant();
+        if(value > quint64(std::numeric_limits<qint64>::max()))
+            return fail(QLatin1String("Negative integer out of range"));
+        return QVariant(-1 - qint64(value));
+    case 2:
+        return readString(majorType, additional, depth);
+    case 3:
+        return QString::fromUtf8(readString(majorType, additional, depth));
+    case 4: {
+        QVariantList list;
+        if(additional == CborIndefiniteLength) {
+            while(error.isEmpty() && !readBreak())
+                list.append(readItem(depth + 1));
+        }
+        else {
+            // Every item takes at least one byte
+            if(!readLength(additional, &value) || !need(value))
+                return QVariant();
+            for(quint64 i = 0; i < value && error.isEmpty(); ++i)
+                list.append(readItem(depth + 1));
+        }
+        return list;
+    }
+    case 5: {
+        QVariantMap map;
+        if(additional == CborIndefiniteLength) {
+            while(error.isEmpty() && !readBreak()) {
+                QString key = readItem(depth + 1).toString();
+                map.insert(key, readItem(depth + 1));
+            }
+        }
+        else {
+            if(!readLength(additional, &value) || !need(value * 2))
+                return QVariant();
+            for(quint64 i = 0; i < value && error.isEmpty(); ++i) {
+                QString key = readItem(depth + 1).toString();
+                map.insert(key, readItem(depth + 1));
+            }
+        }
+        return map;
+    }
+    case 6: {
+        if(!readLength(additional, &value))
+            return QVariant();
+        QVariant item = readItem(depth + 1);
+        if(value == 0 && item.type() == QVariant::String)
+            return QDateTime::fromString(item.toString(), Qt::ISODate);
+        return item;
+    }
+    default:
+        break;
+    }
+
+    // Major type 7: simple values and floating point numbers
+    switch(additional) {
+    case 20:
+        return false;
+    case 21:
+        return true;
+    case 22:
+    case 23:
+        return QVariant();
+    case 25: {
+        if(!need(2))
+            return QVariant();
+        quint16 half = qFromBigEndian<quint16>(current());
+        position += 2;
+        int exponent = (half >> 10) & 0x1f;
+        int mantissa = half & 0x3ff;
+        double result;
+        if(exponent == 0)
+            result = std::ldexp(double(mantissa), -24);
+        else if(exponent != 31)
+            result = std::ldexp(double(mantissa + 1024), exponent - 25);
+        else
+            result = mantissa == 0 ? std::numeric_limits<double>::infinity() : std::numeric_limits<double>::quiet_NaN();
+        return (half & 0x8000) ? -result : result;
+    }
+    case 26: {
+        if(!need(4))
+            return QVariant();
+        quint32 bits = qFromBigEndian<quint32>(current());
+        position += 4;
+        float result;
+        memcpy(&result, &bits, sizeof(result));
+        return double(result);
+    }
+    case 27: {
+        if(!need(8))
+            return QVariant();
+        quint64 bits = qFromBigEndian<quint64>(current());
+        position += 8;
+        double result;
+        memcpy(&result, &bits, sizeof(result));
+        return result;
+    }
+    default:
+        return fail(QLatin1String("Unsupported simple value"));
+    }
+}
+
+CborParser::CborParser() :
+    VariantParser("cbor", "application/cbor")
+{
+}
+
+CborParser::~CborParser()
+{
+}
+
+QVariant CborParser::decode(const QByteArray &data, QString *errorMessage) const
+{
+    CborReader reader(data);
+    QVariant result = reader.readItem();
+
+    if(reader.error.isEmpty() && !reader.atEnd())
+        reader.error = QLatin1String("Unexpected data after the document");
+
+    *errorMessage = reader.error;
+    return result;
+}
+
+} // namespace QRestServer
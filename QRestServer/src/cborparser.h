@@ -0,0 +1,23 @@
+#ifndef QRESTSERVER_CBORPARSER_H
+#define QRESTSERVER_CBORPARSER_H
+
+#include "variantparser.h"
+
+namespace QRestServer {
+
+class CborParser : public VariantParser
+{
+public:
+    CborParser();
+    ~CborParser();
+
+protected:
+    QVariant decode(const QByteArray &data, QString *errorMessage) const Q_DECL_OVERRIDE;
+
+private:
+    Q_DISABLE_COPY(CborParser)
+};
+
+} // namespace QRestServer
+
+#endif // QRESTSERVER_CBORPARSER_H
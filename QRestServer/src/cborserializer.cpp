@@ -0,0 +1,177 @@
+#include "cborserializer.h"
+
+#include <QDateTime>
+#include <QIODevice>
+#include <QStringList>
+#include <QUrl>
+#include <QtEndian>
+
+#include <cstring>
+
+namespace QRestServer {
+
+enum CborMajorType {
+    CborUnsignedInteger = 0,
+    CborNegativeInteger = 1,
+    CborByteString = 2,
+    CborTextString = 3,
+    CborArray = 4,
+    CborMap = 5,
+    CborTag = 6,
+    CborSimple = 7
+};
+
+static const char CborFalse = char(0xf4);
+static const char CborTrue = char(0xf5);
+static const char CborNull = char(0xf6);
+static const char CborDouble = char(0xfb);
+static const quint64 CborTagDateTimeString = 0;
+
+static void writeHead(QIODevice *device, CborMajorType majorType, quint64 value)
+{
+    char buffer[9];
+    char type = char(majorType << 5);
+
+    if(value < 24) {
+        buffer[0] = char(type | value);
+        device->write(buffer, 1);
+    }
+    else if(value <= 0xff) {
+        buffer[0] = char(type | 24);
+        buffer[1] = char(value);
+        device->write(buffer, 2);
+    }
+    else if(value <= 0xffff) {
+        buffer[0] = char(type | 25);
+        qToBigEndian<quint16>(quint16(value), reinterpret_cast<uchar *>(buffer + 1));
+        device->write(buffer, 3);
+    }
+    else if(value <= 0xffffffffULL) {
+        buffer[0] = char(type | 26);
+        qToBigEndian<quint32>(quint32(value), reinterpret_cast<uchar *>(buffer + 1));
+        device->write(buffer, 5);
+    }
+    else {
+        buffer[0] = char(type | 27);
+        qToBigEndian<quint64>(value, reinterpret_cast<uchar *>(buffer + 1));
+        device->write(buffer, 9);
+    }
+}
+
+static void writeInteger(QIODevice *device, qint64 value)
+{
+    if(value >= 0)
+        writeHead(device, CborUnsignedInteger, quint64(value));
+    else
+        writeHead(device, CborNegativeInteger, quint64(-1 - value));
+}
+
+static void writeText(QIODevice *device, const QString &text)
+{
+    QByteArray utf8 = text.toUtf8();
+    writeHead(device, CborTextString, quint64(utf8.size()));
+    device->write(utf8);
+}
+
+CborSerializer::CborSerializer() :
+    VariantSerializer("cbor", "application/cbor")
+{
+}
+
+CborSerializer::~CborSerializer()
+{
+}
+
+void CborSerializer::writeArrayHeader(QIODevice *device, int size) const
+{
+    writeHead(device, CborArray, quint64(size));
+}
+
+void CborSerializer::writeMapHeader(QIODevice *device, int size) const
+{
+    writeHead(device, CborMap, quint64(size));
+}
+
+void CborSerializer::writeVariant(QIODevice *device, const QVariant &value) const
+{
+    if(!value.isValid() || value.isNull()) {
+        device->write(&CborNull, 1);
+        return;
+    }
+
+    switch(value.type()) {
+    case QVariant::Bool:
+        device->write(value.toBool() ? &CborTrue : &CborFalse, 1);
+        break;
+    case QVariant::Int:
+    case QVariant::LongLong:
+        writeInteger(device, value.toLongLong());
+        break;
+    case QVariant::UInt:
+    case QVariant::ULongLong:
+        writeHead(device, CborUnsignedInteger, value.toULongLong());
+        break;
+    case QVariant::Double: {
+        char buffer[9];
+        buffer[0] = CborDouble;
+        double number = value.toDouble();
+        quint64 bits;
+        memcpy(&bits, &number, sizeof(bits));
+        qToBigEndian<quint64>(bits, reinterpret_cast<uchar *>(buffer + 1));
+        device->write(buffer, 9);
+        break;
+    }
+    case QVariant::ByteArray: {
+        QByteArray bytes = value.toByteArray();
+        writeHead(device, CborByteString, quint64(bytes.size()));
+        device->write(bytes);
+        break;
+    }
+    case QVariant::DateTime:
+        writeHead(device, CborTag, CborTagDateTimeString);
+        writeText(device, value.toDateTime().toString(Qt::ISODate));
+        break;
+    case QVariant::Date:
+        writeText(device, value.toDate().toString(Qt::ISODate));
+        break;
+    case QVariant::Url:
+        writeText(device, value.toUrl().toString());
+        break;
+    case QVariant::StringList:
+    case QVariant::List: {
+        QVariantList list = value.toList();
+        writeArrayHeader(device, list.size());
+        foreach(const QVariant &item, list) {
+            writeVariant(device, item);
+        }
+        break;
+    }
+    case QVariant::Map: {
+        QVariantMap map = value.toMap();
+        writeMapHeader(device, map.size());
+        QMapIterator<QString, QVariant> it(map);
+        while(it.hasNext()) {
+            it.next();
+            writeText(device, it.key());
+            writeVariant(device, it.value());
+        }
+        break;
+    }
+    case QVariant::Hash: {
+        QVariantHash hash = value.toHash();
+        writeMapHeader(device, hash.size());
+        QHashIterator<QString, QVariant> it(hash);
+        while(it.hasNext()) {
+            it.next();
+            writeText(device, it.key());
+            writeVariant(device, it.value());
+        }
+        break;
+    }
+    default:
+        writeText(device, value.toString());
+        break;
+    }
+}
+
+} // namespace QRestServer
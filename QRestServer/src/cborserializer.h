@@ -0,0 +1,26 @@
+#ifndef QRESTSERVER_CBORSERIALIZER_H
+#define QRESTSERVER_CBORSERIALIZER_H
+
+#include "variantserializer.h"
+
+namespace QRestServer {
+
+// Concise Binary Object Representation (RFC 7049)
+class CborSerializer : public VariantSerializer
+{
+public:
+    CborSerializer();
+    ~CborSerializer();
+
+protected:
+    void writeVariant(QIODevice *device, const QVariant &value) const Q_DECL_OVERRIDE;
+    void writeArrayHeader(QIODevice *device, int size) const Q_DECL_OVERRIDE;
+    void writeMapHeader(QIODevice *device, int size) const Q_DECL_OVERRIDE;
+
+private:
+    Q_DISABLE_COPY(CborSerializer)
+};
+
+} // namespace QRestServer
+
+#endif // QRESTSERVER_CBORSERIALIZER_H
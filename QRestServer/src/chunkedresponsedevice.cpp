@@ -0,0 +1,227 @@
+#include "chunkedresponsedevice.h"
+
+#include "server.h"
+#include "responsewriter.h"
+#include "deflatestream.h"
+
+#include <QPair>
+
+namespace QRestServer {
+
+class ChunkedResponseDevicePrivate : public QSharedData
+{
+public:
+    ChunkedResponseDevicePrivate() :
+        QSharedData(),
+        response(0),
+        statusCode(QHttpResponse::STATUS_OK),
+        chunkSize(16 * 1024),
+        headWritten(false),
+        captureLimit(-1),
+        compression(0),
+        encoding(ResponseCompression::Identity),
+        deflateStream(0)
+    {}
+
+    ~ChunkedResponseDevicePrivate()
+    {
+        delete deflateStream;
+    }
+
+    ResponseWriter *response;
+    QHttpResponse::StatusCode statusCode;
+    int chunkSize;
+    bool headWritten;
+    QByteArray buffer;
+    QList<QPair<QString, QString> > headers;
+    int captureLimit;
+    QByteArray captured;
+
+    ResponseCompression *compression;
+    ResponseCompression::Encoding encoding;
+    DeflateStream *deflateStream;
+
+    bool isDeciding() const;
+    void startCompression();
+    void writeHeaders();
+    void writeChunk();
+};
+
+// Until a response with compression has reached the threshold, it is kept uncompressed in the buffer
+bool ChunkedResponseDevicePrivate::isDeciding() const
+{
+    return compression && !deflateStream;
+}
+
+void ChunkedResponseDevicePrivate::startCompression()
+{
+    deflateStream = new DeflateStream(encoding, compression->level());
+    if(!deflateStream->isValid()) {
+        compression = 0;
+        return;
+    }
+
+    headers.append(qMakePair(QString(HttpHeaderContentEncoding), ResponseCompression::encodingName(encoding)));
+    QByteArray uncompressed = buffer;
+    buffer = deflateStream->compress(uncompressed.constData(), uncompressed.size());
+}
+
+void ChunkedResponseDevicePrivate::writeHeaders()
+{
+    typedef QPair<QString, QString> Header;
+    foreach(const Header &header, headers) {
+        response->setHeader(header.first, header.second);
+    }
+}
+
+void ChunkedResponseDevicePrivate::writeChunk()
+{
+    if(buffer.isEmpty())
+        return;
+
+    if(!headWritten) {
+        writeHeaders();
+        response->setHeader(HttpHeaderTransferEncoding, QLatin1String("chunked"));
+        response->writeHead(statusCode);
+        headWritten = true;
+    }
+
+    QByteArray chunk = QByteArray::number(buffer.size(), 16);
+    chunk.append("\r\n");
+    chunk.append(buffer);
+    chunk.append("\r\n");
+    response->write(chunk);
+
+    buffer.clear();
+
+    // A serializer in a worker thread must not read and encode pages faster than the client takes them
+    response->waitForCapacity();
+}
+
+ChunkedResponseDevice::ChunkedResponseDevice(ResponseWriter *response,
+                                             QHttpResponse::StatusCode statusCode,
+                                             QObject *parent) :
+    QIODevice(parent),
+    d(new ChunkedResponseDevicePrivate)
+{
+    d->response = response;
+    d->statusCode = statusCode;
+}
+
+ChunkedResponseDevice::~ChunkedResponseDevice()
+{
+}
+
+int ChunkedResponseDevice::chunkSize() const
+{
+    return d->chunkSize;
+}
+
+void ChunkedResponseDevice::setChunkSize(int chunkSize)
+{
+    d->chunkSize = chunkSize;
+}
+
+bool ChunkedResponseDevice::isHeadWritten() const
+{
+    return d->headWritten;
+}
+
+void ChunkedResponseDevice::setHeader(const QString &field, const QString &value)
+{
+    d->headers.append(qMakePair(field, value));
+}
+
+void ChunkedResponseDevice::setCompression(ResponseCompression *compression, ResponseCompression::Encoding encoding)
+{
+    Q_ASSERT(!d->headWritten);
+
+    if(!compression
+            || encoding == ResponseCompression::Identity
+            || compression->threshold() < 0) {
+        d->compression = 0;
+        return;
+    }
+
+    d->compression = compression;
+    d->encoding = encoding;
+}
+
+void ChunkedResponseDevice::setCaptureLimit(int bytes)
+{
+    d->captureLimit = bytes;
+}
+
+bool ChunkedResponseDevice::hasCapturedData() const
+{
+    return d->captureLimit >= 0;
+}
+
+QByteArray ChunkedResponseDevice::capturedData() const
+{
+    return d->captured;
+}
+
+void ChunkedResponseDevice::close()
+{
+    if(!isOpen())
+        return;
+
+    if(d->deflateStream && d->compression) {
+        d->buffer.append(d->deflateStream->finish());
+        d->compression->recordResponse(d->deflateStream->bytesIn(),
+                                       d->deflateStream->bytesOut(),
+                                       d->deflateStream->elapsed());
+    }
+
+    if(d->headWritten) {
+        d->writeChunk();
+        d->response->write(QByteArray("0\r\n\r\n"));
+    }
+    else {
+        d->writeHeaders();
+        d->response->setHeader(HttpHeaderContentLength, QString::number(d->buffer.size()));
+        d->response->writeHead(d->statusCode);
+        d->response->write(d->buffer);
+        d->buffer.clear();
+    }
+
+    d->response->end();
+    QIODevice::close();
+}
+
+qint64 ChunkedResponseDevice::readData(char *data, qint64 maxSize)
+{
+    Q_UNUSED(data);
+    Q_UNUSED(maxSize);
+    return -1;
+}
+
+qint64 ChunkedResponseDevice::writeData(const char *data, qint64 size)
+{
+    if(d->deflateStream && d->compression) {
+        d->buffer.append(d->deflateStream->compress(data, int(size)));
+    }
+    else {
+        d->buffer.append(data, size);
+        if(d->isDeciding() && d->buffer.size() >= d->compression->threshold())
+            d->startCompression();
+    }
+
+    if(d->captureLimit >= 0) {
+        if(d->captured.size() + size <= d->captureLimit) {
+            d->captured.append(data, size);
+        }
+        else {
+            d->captureLimit = -1;
+            d->captured.clear();
+        }
+    }
+
+    if(d->buffer.size() >= d->chunkSize && !d->isDeciding())
+        d->writeChunk();
+
+    return size;
+}
+
+} // namespace QRestServer
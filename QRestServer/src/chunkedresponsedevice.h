@@ -0,0 +1,61 @@
+#ifndef QRESTSERVER_CHUNKEDRESPONSEDEVICE_H
+#define QRESTSERVER_CHUNKEDRESPONSEDEVICE_H
+
+#include "responsecompression.h"
+
+#include <QtCore/QIODevice>
+
+#include <QtCore/QSharedDataPointer>
+
+#include <qhttpresponse.h>
+
+namespace QRestServer {
+
+class ResponseWriter;
+
+// Writes into a response with chunked transfer encoding.
+// The head is only written, once the first chunk is full. Until then,
+// the response may still be abandoned (e.g. to serve an error instead).
+// A response, which never fills a chunk, is sent with a Content-Length.
+// The captured data is never compressed.
+class ChunkedResponseDevicePrivate;
+class ChunkedResponseDevice : public QIODevice
+{
+    Q_OBJECT
+public:
+    explicit ChunkedResponseDevice(ResponseWriter *response,
+                                   QHttpResponse::StatusCode statusCode = QHttpResponse::STATUS_OK,
+                                   QObject *parent = 0);
+    ~ChunkedResponseDevice();
+
+    int chunkSize() const;
+    void setChunkSize(int chunkSize);
+
+    bool isHeadWritten() const;
+
+    // Additional headers, which are written with the head
+    void setHeader(const QString &field, const QString &value);
+
+    // Compresses the response incrementally, as soon as it has reached the threshold of the compression
+    void setCompression(ResponseCompression *compression, ResponseCompression::Encoding encoding);
+
+    // Keeps a copy of everything written (without the chunk framing), as long as it fits into the limit
+    void setCaptureLimit(int bytes);
+    bool hasCapturedData() const;
+    QByteArray capturedData() const;
+
+    // Writes the remaining data and ends the response
+    void close() Q_DECL_OVERRIDE;
+
+protected:
+    qint64 readData(char *data, qint64 maxSize) Q_DECL_OVERRIDE;
+    qint64 writeData(const char *data, qint64 size) Q_DECL_OVERRIDE;
+
+private:
+    QSharedDataPointer<ChunkedResponseDevicePrivate> d;
+    Q_DISABLE_COPY(ChunkedResponseDevice)
+};
+
+} // namespace QRestServer
+
+#endif // QRESTSERVER_CHUNKEDRESPONSEDEVICE_H
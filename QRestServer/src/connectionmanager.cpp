@@ -0,0 +1,206 @@
+#include "connectionmanager.h"
+
+#include "responsewriter.h"
+#include "server.h"
+
+#include <qhttpserver.h>
+#include <qhttprequest.h>
+
+#include <QElapsedTimer>
+#include <QHash>
+#include <QTcpServer>
+#include <QTcpSocket>
+#include <QTimer>
+
+namespace QRestServer {
+
+class ConnectionManagerPrivate : public QSharedData
+{
+public:
+    ConnectionManagerPrivate() :
+        QSharedData(),
+        httpServer(0),
+        idleTimer(0),
+        idleTimeout(30000)
+    {}
+
+    QHttpServer *httpServer;
+    QTimer *idleTimer;
+    int idleTimeout;
+    QElapsedTimer clock;
+
+    QHash<QTcpSocket *, qint64> lastActivity;
+
+    // The responses of a connection in the order of their requests.
+    // Only the first one writes, all others are held.
+    QHash<QString, QList<ResponseWriter *> > pendingResponses;
+    QHash<ResponseWriter *, QString> connectionOfResponse;
+
+    void removeResponse(ResponseWriter *writer);
+
+    static QString connectionKey(const QString &address, quint16 port);
+};
+
+QString ConnectionManagerPrivate::connectionKey(const QString &address, quint16 port)
+{
+    return QString("%1:%2").arg(address).arg(port);
+}
+
+void ConnectionManagerPrivate::removeResponse(ResponseWriter *writer)
+{
+    if(!connectionOfResponse.contains(writer))
+        return;
+
+    QString connection = connectionOfResponse.take(writer);
+    QList<ResponseWriter *> &responses = pendingResponses[connection];
+    bool wasFirst = !responses.isEmpty() && responses.first() == writer;
+    responses.removeAll(writer);
+
+    if(responses.isEmpty()) {
+        pendingResponses.remove(connection);
+        return;
+    }
+
+    // Releasing may end the next response right away, which removes it again
+    if(wasFirst)
+        responses.first()->release();
+}
+
+ConnectionManager::ConnectionManager(QHttpServer *httpServer, QObject *parent) :
+    QObject(parent),
+    d(new ConnectionManagerPrivate)
+{
+    d->httpServer = httpServer;
+    d->clock.start();
+
+    d->idleTimer = new QTimer(this);
+    connect(d->idleTimer, SIGNAL(timeout()), this, SLOT(closeIdleConnections()));
+}
+
+ConnectionManager::~ConnectionManager()
+{
+}
+
+int ConnectionManager::idleTimeout() const
+{
+    return d->idleTimeout;
+}
+
+void ConnectionManager::setIdleTimeout(int idleTimeout)
+{
+    Q_ASSERT(idleTimeout >= 0);
+    d->idleTimeout = idleTimeout;
+
+    if(idleTimeout == 0) {
+        d->idleTimer->stop();
+        return;
+    }
+
+    d->idleTimer->setInterval(qMax(100, idleTimeout / 2));
+    if(!d->lastActivity.isEmpty() || d->httpServer->findChild<QTcpServer *>())
+        d->idleTimer->start();
+}
+
+int ConnectionManager::connectionCount() const
+{
+    return d->lastActivity.size();
+}
+
+void ConnectionManager::addResponse(QHttpRequest *request, ResponseWriter *writer)
+{
+    QString connection = ConnectionManagerPrivate::connectionKey(request->remoteAddress(),
+                                                                 request->remotePort());
+
+    QList<ResponseWriter *> &responses = d->pendingResponses[connection];
+    if(!responses.isEmpty())
+        writer->hold();
+
+    responses.append(writer);
+    d->connectionOfResponse.insert(writer, connection);
+
+    connect(writer, SIGNAL(ended()), this, SLOT(responseEnded()));
+    connect(writer, SIGNAL(destroyed(QObject*)), this, SLOT(writerDestroyed(QObject*)));
+
+    if(d->idleTimeout > 0)
+        writer->setHeader(HttpHeaderKeepAlive, QString("timeout=%1").arg(qMax(1, d->idleTimeout / 1000)));
+}
+
+void ConnectionManager::startTracking()
+{
+    // QHttpServer does not expose its connections, so the sockets are picked up
+    // after it has accepted them.
+    QTcpServer *tcpServer = d->httpServer->findChild<QTcpServer *>();
+    if(tcpServer) {
+        connect(tcpServer, SIGNAL(newConnection()),
+                this, SLOT(trackNewConnections()),
+                Qt::QueuedConnection);
+    }
+
+    trackNewConnections();
+
+    if(d->idleTimeout > 0) {
+        d->idleTimer->setInterval(qMax(100, d->idleTimeout / 2));
+        d->idleTimer->start();
+    }
+}
+
+void ConnectionManager::trackNewConnections()
+{
+    foreach(QTcpSocket *socket, d->httpServer->findChildren<QTcpSocket *>()) {
+        if(d->lastActivity.contains(socket))
+            continue;
+
+        d->lastActivity.insert(socket, d->clock.elapsed());
+        connect(socket, SIGNAL(readyRead()), this, SLOT(socketActive()));
+        connect(socket, SIGNAL(bytesWritten(qint64)), this, SLOT(socketActive()));
+        connect(socket, SIGNAL(destroyed(QObject*)), this, SLOT(socketDestroyed(QObject*)));
+    }
+}
+
+void ConnectionManager::socketActive()
+{
+    QTcpSocket *socket = static_cast<QTcpSocket *>(sender());
+    d->lastActivity.insert(socket, d->clock.elapsed());
+}
+
+void ConnectionManager::socketDestroyed(QObject *socket)
+{
+    // Only used as a key, the socket is already gone
+    d->lastActivity.remove(static_cast<QTcpSocket *>(socket));
+}
+
+void ConnectionManager::responseEnded()
+{
+    d->removeResponse(static_cast<ResponseWriter *>(sender()));
+}
+
+void ConnectionManager::writerDestroyed(QObject *writer)
+{
+    // A response, which has been abandoned, must not block the following ones
+    d->removeResponse(static_cast<ResponseWriter *>(writer));
+}
+
+void ConnectionManager::closeIdleConnections()
+{
+    qint64 now = d->clock.elapsed();
+
+    QHashIterator<QTcpSocket *, qint64> it(d->lastActivity);
+    while(it.hasNext()) {
+        it.next();
+        QTcpSocket *socket = it.key();
+
+        if(now - it.value() < d->idleTimeout
+                || socket->bytesToWrite() > 0
+                || socket->state() != QAbstractSocket::ConnectedState)
+            continue;
+
+        QString connection = ConnectionManagerPrivate::connectionKey(socket->peerAddress().toString(),
+                                                                     socket->peerPort());
+        if(d->pendingResponses.contains(connection))
+            continue;
+
+        socket->disconnectFromHost();
+    }
+}
+
+} // namespace QRestServer
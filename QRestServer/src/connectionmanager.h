@@ -0,0 +1,53 @@
+#ifndef QRESTSERVER_CONNECTIONMANAGER_H
+#define QRESTSERVER_CONNECTIONMANAGER_H
+
+#include <QtCore/QObject>
+
+#include <QtCore/QSharedDataPointer>
+
+class QHttpRequest;
+class QHttpServer;
+
+namespace QRestServer {
+
+class ResponseWriter;
+
+// Keeps track of the persistent connections of a QHttpServer.
+// Responses to pipelined requests are written in the order of their requests
+// and connections without pending responses are closed after an idle timeout.
+class ConnectionManagerPrivate;
+class ConnectionManager : public QObject
+{
+    Q_OBJECT
+public:
+    explicit ConnectionManager(QHttpServer *httpServer, QObject *parent = 0);
+    ~ConnectionManager();
+
+    // In milliseconds. 0 keeps idle connections open forever.
+    int idleTimeout() const;
+    void setIdleTimeout(int idleTimeout);
+
+    int connectionCount() const;
+
+    // Must be called in the order, in which the requests arrive
+    void addResponse(QHttpRequest *request, ResponseWriter *writer);
+
+    // Has to be called after the HTTP server started listening
+    void startTracking();
+
+private Q_SLOTS:
+    void trackNewConnections();
+    void socketActive();
+    void socketDestroyed(QObject *socket);
+    void responseEnded();
+    void writerDestroyed(QObject *writer);
+    void closeIdleConnections();
+
+private:
+    QSharedDataPointer<ConnectionManagerPrivate> d;
+    Q_DISABLE_COPY(ConnectionManager)
+};
+
+} // namespace QRestServer
+
+#endif // QRESTSERVER_CONNECTIONMANAGER_H
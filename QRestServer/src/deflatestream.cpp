@@ -0,0 +1,117 @@
+#include "deflatestream.h"
+
+#include <QElapsedTimer>
+#include <QSharedData>
+
+#include <zlib.h>
+
+#include <cstring>
+
+namespace QRestServer {
+
+// Window bits for a zlib stream; adding 16 writes a gzip header and trailer instead
+static const int WindowBits = 15;
+static const int GzipWindowBits = WindowBits + 16;
+static const int MemoryLevel = 8;
+
+class DeflateStreamPrivate : public QSharedData
+{
+public:
+    DeflateStreamPrivate() :
+        QSharedData(),
+        valid(false),
+        finished(false),
+        bytesIn(0),
+        bytesOut(0),
+        elapsed(0)
+    {}
+
+    z_stream stream;
+    bool valid;
+    bool finished;
+    qint64 bytesIn;
+    qint64 bytesOut;
+    qint64 elapsed;
+
+    QByteArray deflate(const char *data, int size, int flush);
+};
+
+QByteArray DeflateStreamPrivate::deflate(const char *data, int size, int flush)
+{
+    QByteArray result;
+    if(!valid || finished)
+        return result;
+
+    QElapsedTimer timer;
+    timer.start();
+
+    stream.next_in = reinterpret_cast<Bytef *>(const_cast<char *>(data));
+    stream.avail_in = uInt(size);
+
+    char buffer[16 * 1024];
+    int status;
+    do {
+        stream.next_out = reinterpret_cast<Bytef *>(buffer);
+        stream.avail_out = sizeof(buffer);
+        status = ::deflate(&stream, flush);
+        result.append(buffer, int(sizeof(buffer) - stream.avail_out));
+    } while(status == Z_OK && stream.avail_out == 0);
+
+    if(flush == Z_FINISH)
+        finished = true;
+
+    bytesIn += size;
+    bytesOut += result.size();
+    elapsed += timer.nsecsElapsed();
+    return result;
+}
+
+DeflateStream::DeflateStream(ResponseCompression::Encoding encoding, int level) :
+    d(new DeflateStreamPrivate)
+{
+    memset(&d->stream, 0, sizeof(d->stream));
+
+    if(encoding == ResponseCompression::Identity)
+        return;
+
+    int windowBits = encoding == ResponseCompression::Gzip ? GzipWindowBits : WindowBits;
+    d->valid = deflateInit2(&d->stream, level, Z_DEFLATED, windowBits, MemoryLevel, Z_DEFAULT_STRATEGY) == Z_OK;
+}
+
+DeflateStream::~DeflateStream()
+{
+    if(d->valid)
+        deflateEnd(&d->stream);
+}
+
+bool DeflateStream::isValid() const
+{
+    return d->valid;
+}
+
+QByteArray DeflateStream::compress(const char *data, int size)
+{
+    return d->deflate(data, size, Z_NO_FLUSH);
+}
+
+QByteArray DeflateStream::finish()
+{
+    return d->deflate(0, 0, Z_FINISH);
+}
+
+qint64 DeflateStream::bytesIn() const
+{
+    return d->bytesIn;
+}
+
+qint64 DeflateStream::bytesOut() const
+{
+    return d->bytesOut;
+}
+
+qint64 DeflateStream::elapsed() const
+{
+    return d->elapsed;
+}
+
+} // namespace QRestServer
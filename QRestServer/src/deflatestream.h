@@ -0,0 +1,37 @@
+#ifndef QRESTSERVER_DEFLATESTREAM_H
+#define QRESTSERVER_DEFLATESTREAM_H
+
+#include "responsecompression.h"
+
+#include <QtCore/QByteArray>
+#include <QtCore/QExplicitlySharedDataPointer>
+
+namespace QRestServer {
+
+// Compresses data incrementally with zlib.
+// The output of compress() is not complete, before finish() has been called.
+class DeflateStreamPrivate;
+class DeflateStream
+{
+public:
+    DeflateStream(ResponseCompression::Encoding encoding, int level);
+    ~DeflateStream();
+
+    bool isValid() const;
+
+    QByteArray compress(const char *data, int size);
+    QByteArray finish();
+
+    qint64 bytesIn() const;
+    qint64 bytesOut() const;
+    // The time spent compressing in nanoseconds
+    qint64 elapsed() const;
+
+private:
+    QExplicitlySharedDataPointer<DeflateStreamPrivate> d;
+    Q_DISABLE_COPY(DeflateStream)
+};
+
+} // namespace QRestServer
+
+#endif // QRESTSERVER_DEFLATESTREAM_H
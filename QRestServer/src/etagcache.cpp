@@ -0,0 +1,261 @@
+#include "etagcache.h"
+
+#include "serializer.h"
+
+#include <QDataSuite/abstractdataaccessobject.h>
+#include <QDataSuite/metaobject.h>
+#include <QDataSuite/metaproperty.h>
+
+#include <QCryptographicHash>
+#include <QDataStream>
+#include <QDateTime>
+#include <QHash>
+#include <QMutex>
+#include <QStringList>
+
+namespace QRestServer {
+
+class ETagCachePrivate : public QSharedData
+{
+public:
+    ETagCachePrivate() :
+        QSharedData()
+    {}
+
+    // Objects and collections are changed and tagged by all workers
+    mutable QMutex mutex;
+
+    // By collection name and the key as string, because keys parsed from a URL are always strings
+    QHash<QString, QHash<QString, QByteArray> > objectETags;
+    QHash<QString, quint64> collectionGenerations;
+
+    // The representations of objects contain links to their related objects,
+    // so a change invalidates the tags of the related collections, too
+    QHash<QString, QStringList> relatedCollections;
+
+    // Tags of collections must not repeat after a restart
+    QByteArray instance;
+
+    void invalidate(const QString &collectionName);
+
+    static QString keyOfObject(const QObject *object);
+    static QByteArray relationKeys(const QObject *object);
+};
+
+void ETagCachePrivate::invalidate(const QString &collectionName)
+{
+    ++collectionGenerations[collectionName];
+
+    foreach (const QString &relatedCollection, relatedCollections.value(collectionName)) {
+        objectETags.remove(relatedCollection);
+        ++collectionGenerations[relatedCollection];
+    }
+}
+
+QString ETagCachePrivate::keyOfObject(const QObject *object)
+{
+    QDataSuite::MetaObject metaObject = QDataSuite::MetaObject::metaObject(object);
+    return metaObject.primaryKeyProperty().read(object).toString();
+}
+
+QByteArray ETagCachePrivate::relationKeys(const QObject *object)
+{
+    // The links of a representation only depend on the keys of the related objects
+    QByteArray data;
+    QDataStream stream(&data, QIODevice::WriteOnly);
+
+    QDataSuite::MetaObject metaObject = QDataSuite::MetaObject::metaObject(object);
+    foreach (const QDataSuite::MetaProperty property, metaObject.relationProperties()) {
+        QStringList keys;
+        if (property.isToOneRelationProperty()) {
+            QObject *relatedObject = property.readObject(object);
+            if (relatedObject)
+                keys.append(keyOfObject(relatedObject));
+        }
+        else if (property.isToManyRelationProperty()) {
+            foreach (QObject *relatedObject, property.readObjects(object)) {
+                if (relatedObject)
+                    keys.append(keyOfObject(relatedObject));
+            }
+        }
+
+        stream << QString(QLatin1String(property.name())) << keys;
+    }
+
+    return data;
+}
+
+ETagCache::ETagCache(QObject *parent) :
+    QObject(parent),
+    d(new ETagCachePrivate)
+{
+    d->instance = QByteArray::number(QDateTime::currentMSecsSinceEpoch(), 16);
+}
+
+ETagCache::~ETagCache()
+{
+}
+
+void ETagCache::addCollection(QDataSuite::AbstractDataAccessObject *collection)
+{
+    QDataSuite::MetaObject metaObject = collection->dataSuiteMetaObject();
+    {
+        QMutexLocker locker(&d->mutex);
+        foreach (const QDataSuite::MetaProperty property, metaObject.relationProperties()) {
+            QString relatedCollection = property.reverseMetaObject().collectionName();
+            if (!d->relatedCollections.value(metaObject.collectionName()).contains(relatedCollection))
+                d->relatedCollections[metaObject.collectionName()].append(relatedCollection);
+        }
+    }
+
+    // Direct connections, so that a tag is dropped before the change has been answered
+    connect(collection, SIGNAL(objectInserted(QObject*)),
+            this, SLOT(objectInserted(QObject*)),
+            Qt::DirectConnection);
+    connect(collection, SIGNAL(objectUpdated(QObject*)),
+            this, SLOT(objectChanged(QObject*)),
+            Qt::DirectConnection);
+    connect(collection, SIGNAL(objectRemoved(QObject*)),
+            this, SLOT(objectChanged(QObject*)),
+            Qt::DirectConnection);
+}
+
+QByteArray ETagCache::cachedObjectETag(const QDataSuite::AbstractDataAccessObject *collection, const QVariant &key) const
+{
+    QString collectionName = collection->dataSuiteMetaObject().collectionName();
+
+    QMutexLocker locker(&d->mutex);
+    return d->objectETags.value(collectionName).value(key.toString());
+}
+
+QByteArray ETagCache::objectETag(const QObject *object)
+{
+    QDataSuite::MetaObject metaObject = QDataSuite::MetaObject::metaObject(object);
+    QString collectionName = metaObject.collectionName();
+
+    // A tag, which has been computed while the object changed, must not be cached
+    quint64 generation = 0;
+    {
+        QMutexLocker locker(&d->mutex);
+        generation = d->collectionGenerations.value(collectionName);
+    }
+
+    QByteArray relationHash = QCryptographicHash::hash(ETagCachePrivate::relationKeys(object), QCryptographicHash::Sha1).toHex();
+
+    QByteArray etag("\"");
+    QString versionPropertyName = metaObject.classInformation(QDATASUITE_REST_VERSIONPROPERTY, QString());
+    if (!versionPropertyName.isEmpty()) {
+        // The version does not change, when objects are added to or removed from a relation
+        etag.append('v').append(metaObject.metaProperty(versionPropertyName).read(object).toString().toUtf8());
+        etag.append('-').append(relationHash.left(16));
+    }
+    else {
+        QByteArray data;
+        QDataStream stream(&data, QIODevice::WriteOnly);
+        stream << Serializer::objectToVariant(object);
+        data.append(relationHash);
+        etag.append(QCryptographicHash::hash(data, QCryptographicHash::Sha1).toHex());
+    }
+    etag.append('"');
+
+    QMutexLocker locker(&d->mutex);
+    if (d->collectionGenerations.value(collectionName) == generation)
+        d->objectETags[collectionName].insert(ETagCachePrivate::keyOfObject(object), etag);
+
+    return etag;
+}
+
+QByteArray ETagCache::collectionETag(const QDataSuite::AbstractDataAccessObject *collection) const
+{
+    QString collectionName = collection->dataSuiteMetaObject().collectionName();
+
+    QMutexLocker locker(&d->mutex);
+    return QByteArray("\"c")
+            .append(d->instance)
+            .append('-')
+            .append(QByteArray::number(d->collectionGenerations.value(collectionName)))
+            .append('"');
+}
+
+QByteArray ETagCache::representationETag(const QByteArray &etag, const QString &format, const QString &encoding)
+{
+    if (etag.isEmpty())
+        return etag;
+
+    QByteArray result = etag.left(etag.size() - 1);
+    result.append('+').append(format.toLatin1());
+    if (!encoding.isEmpty())
+        result.append('+').append(encoding.toLatin1());
+    result.append('"');
+    return result;
+}
+
+bool ETagCache::matchesAnyRepresentation(const QString &header, const QByteArray &etag)
+{
+    if (header.isEmpty() || etag.isEmpty())
+        return false;
+
+    QByteArray representationPrefix = etag.left(etag.size() - 1).append('+');
+    foreach (QString candidate, header.split(',', QString::SkipEmptyParts)) {
+        candidate = candidate.trimmed();
+
+        if (candidate == QLatin1String("*"))
+            return true;
+
+        // Weak tags never match in a strong comparison
+        if (candidate.startsWith(QLatin1String("W/")))
+            continue;
+
+        QByteArray candidateTag = candidate.toLatin1();
+        if (candidateTag == etag || candidateTag.startsWith(representationPrefix))
+            return true;
+    }
+
+    return false;
+}
+
+bool ETagCache::matches(const QString &header, const QByteArray &etag, bool weakComparison)
+{
+    if (header.isEmpty() || etag.isEmpty())
+        return false;
+
+    foreach (QString candidate, header.split(',', QString::SkipEmptyParts)) {
+        candidate = candidate.trimmed();
+
+        if (candidate == QLatin1String("*"))
+            return true;
+
+        if (candidate.startsWith(QLatin1String("W/"))) {
+            // Weak tags never match in a strong comparison
+            if (!weakComparison)
+                continue;
+
+            candidate = candidate.mid(2);
+        }
+
+        if (candidate.toLatin1() == etag)
+            return true;
+    }
+
+    return false;
+}
+
+void ETagCache::objectChanged(QObject *object)
+{
+    QDataSuite::MetaObject metaObject = QDataSuite::MetaObject::metaObject(object);
+    QString key = ETagCachePrivate::keyOfObject(object);
+
+    QMutexLocker locker(&d->mutex);
+    d->objectETags[metaObject.collectionName()].remove(key);
+    d->invalidate(metaObject.collectionName());
+}
+
+void ETagCache::objectInserted(QObject *object)
+{
+    QDataSuite::MetaObject metaObject = QDataSuite::MetaObject::metaObject(object);
+
+    QMutexLocker locker(&d->mutex);
+    d->invalidate(metaObject.collectionName());
+}
+
+} // namespace QRestServer
@@ -0,0 +1,55 @@
+#ifndef QRESTSERVER_ETAGCACHE_H
+#define QRESTSERVER_ETAGCACHE_H
+
+#include <QtCore/QObject>
+
+#include <QtCore/QExplicitlySharedDataPointer>
+
+namespace QDataSuite {
+class AbstractDataAccessObject;
+}
+
+namespace QRestServer {
+
+// Computes and caches strong entity tags for objects and collections.
+// The tag of an object is its version property (QDATASUITE_REST_VERSIONPROPERTY),
+// or a hash of its properties, plus a hash of the keys of its related objects.
+// The tag of a collection changes with every change to it or to a related collection.
+// Cached tags are dropped, when the data access objects report a change,
+// which is why all changes have to go through them.
+// Responses carry the tag of their representation (see representationETag()).
+class ETagCachePrivate;
+class ETagCache : public QObject
+{
+    Q_OBJECT
+public:
+    explicit ETagCache(QObject *parent = 0);
+    ~ETagCache();
+
+    void addCollection(QDataSuite::AbstractDataAccessObject *collection);
+
+    // Returns an empty tag, if the object has not been tagged since its last change
+    QByteArray cachedObjectETag(const QDataSuite::AbstractDataAccessObject *collection, const QVariant &key) const;
+    QByteArray objectETag(const QObject *object);
+    QByteArray collectionETag(const QDataSuite::AbstractDataAccessObject *collection) const;
+
+    // Strong tags must differ between formats and content codings of the same state
+    static QByteArray representationETag(const QByteArray &etag, const QString &format, const QString &encoding);
+
+    // Compares against the value of an If-Match or If-None-Match header
+    static bool matches(const QString &header, const QByteArray &etag, bool weakComparison);
+    // Strongly compares against the tags of all representations of a state (e.g. for If-Match)
+    static bool matchesAnyRepresentation(const QString &header, const QByteArray &etag);
+
+private Q_SLOTS:
+    void objectChanged(QObject *object);
+    void objectInserted(QObject *object);
+
+private:
+    QExplicitlySharedDataPointer<ETagCachePrivate> d;
+    Q_DISABLE_COPY(ETagCache)
+};
+
+} // namespace QRestServer
+
+#endif // QRESTSERVER_ETAGCACHE_H
@@ -55,12 +55,15 @@ void HalJsonParser::parse(const QByteArray &data, QObject *object, Server *serve
 
     QDataSuite::MetaObject metaObject = QDataSuite::MetaObject::metaObject(object);
 
+    // Converted from the resource once, not once per property
+    const QVariantMap properties = resource.properties();
+
     foreach(QDataSuite::MetaProperty property, metaObject.simpleProperties()) {
         if(property.isPrimaryKey()
                 && mode != Create)
             continue;
 
-        property.write(object, resource.properties().value(property.name()));
+        property.write(object, properties.value(property.name()));
     }
 
     foreach(QHalLink link, resource.links()) {
@@ -82,16 +85,14 @@ void HalJsonParser::parse(const QByteArray &data, QObject *object, Server *serve
                 if(relatedObject)
                     relatedObjects.append(relatedObject);
             }
-            QVariant value = QDataSuite::MetaObject::variantListCast(relatedObjects, property.reverseClassName());
-            property.write(object, value);
+            property.writeObjects(object, relatedObjects);
         }
         else {
             if(!property.isToOneRelationProperty())
                 continue;
 
             QObject *relatedObject = server->linkHelper()->resolveObjectLink(link.href());
-            QVariant value = QDataSuite::MetaObject::variantCast(relatedObject, property.reverseClassName());
-            property.write(object, value);
+            property.writeObject(object, relatedObject);
         }
     }
 }
@@ -12,14 +12,33 @@
 #include <qhalresource.h>
 #include <qhallink.h>
 
+#include <QBuffer>
+#include <QJsonArray>
 #include <QJsonDocument>
 #include <QUrl>
 
 namespace QRestServer {
 
+static QByteArray jsonString(const QString &string)
+{
+    // QJsonDocument can only serialize arrays and objects
+    QByteArray array = QJsonDocument(QJsonArray() << string).toJson(QJsonDocument::Compact);
+    return array.mid(1, array.size() - 2);
+}
+
 class HalJsonSerializerData : public QSharedData {
 public:
     QHalResource objectToResource(const QObject *object, Server *server) const;
+
+    // We write the frame of the HAL document by hand and only convert one object at a time,
+    // so that we never hold more than one object's JSON in memory.
+    void writeCollectionHeader(const QDataSuite::AbstractDataAccessObject *collection, QIODevice *device) const;
+    void writeObjects(const QList<QObject *> &objects, bool first, Server *server, QIODevice *device) const;
+    void writeCollectionFooter(const QDataSuite::AbstractDataAccessObject *collection,
+                               const QMap<QString, QUrl> &links,
+                               int count,
+                               Server *server,
+                               QIODevice *device) const;
 };
 
 QHalResource HalJsonSerializerData::objectToResource(const QObject *object, Server *server) const
@@ -41,7 +60,7 @@ QHalResource HalJsonSerializerData::objectToResource(const QObject *object, Serv
 
         if(cardinality == QDataSuite::MetaProperty::ToOneCardinality
                 || cardinality == QDataSuite::MetaProperty::ManyToOneCardinality) {
-            QObject *relatedObject = QDataSuite::MetaObject::objectCast(property.read(object));
+            QObject *relatedObject = property.readObject(object);
 
             QUrl relatedUrl;
             if(relatedObject)
@@ -51,7 +70,7 @@ QHalResource HalJsonSerializerData::objectToResource(const QObject *object, Serv
         }
         else if(cardinality == QDataSuite::MetaProperty::ToManyCardinality
                 || cardinality == QDataSuite::MetaProperty::OneToManyCardinality) {
-            QList<QObject *> relatedObjects = QDataSuite::MetaObject::objectListCast(property.read(object));
+            QList<QObject *> relatedObjects = property.readObjects(object);
 
             QHalLink link(property.name(), QList<QHalLink>());
             foreach(QObject *relatedObject, relatedObjects) {
@@ -117,24 +136,110 @@ QByteArray HalJsonSerializer::serialize(const QDataSuite::Error &error) const
 
 QByteArray HalJsonSerializer::serialize(const QDataSuite::AbstractDataAccessObject *collection, Server *server) const
 {
-    QUrl collectionUrl = server->linkHelper()->collectionLink(collection);
-    QDataSuite::MetaObject metaObject = collection->dataSuiteMetaObject();
+    QBuffer buffer;
+    buffer.open(QIODevice::WriteOnly);
+
+    if(!serialize(collection, server, &buffer))
+        return QByteArray();
+
+    return buffer.data();
+}
+
+bool HalJsonSerializer::serialize(const QDataSuite::AbstractDataAccessObject *collection,
+                                  Server *server,
+                                  QIODevice *device) const
+{
+    resetLastError();
+
+    // The first page is read before anything is written, so that a failing collection
+    // can still be answered with an error
+    QList<QObject *> page = readNextPage(collection, QList<QObject *>());
+    if(lastError().isValid())
+        return false;
+
+    data->writeCollectionHeader(collection, device);
+
+    int count = 0;
+    forever {
+        data->writeObjects(page, count == 0, server, device);
+        count += page.size();
+
+        if(page.size() < StreamPageSize)
+            break;
 
-    QHalResource collectionResource;
-    foreach(QObject *object, collection->readAllObjects()) {
-        QHalResource objectResource = data->objectToResource(object, server);
-        collectionResource.append(objectResource);
+        page = readNextPage(collection, page);
+        if(lastError().isValid())
+            return false;
     }
 
-    QHalResource resource;
-    resource.setHref(collectionUrl);
-    resource.embed(metaObject.collectionName(), collectionResource);
-    resource.setProperty("count", QVariant(collectionResource.count()));
+    data->writeCollectionFooter(collection, QMap<QString, QUrl>(), count, server, device);
+    return true;
+}
 
-    QVariant documentVariant = resource.toVariant();
-    QJsonDocument jsonDoc = QJsonDocument::fromVariant(documentVariant);
-    return jsonDoc.toJson();
+bool HalJsonSerializer::serialize(const QDataSuite::AbstractDataAccessObject *collection,
+                                  const QList<QObject *> &objects,
+                                  const QMap<QString, QUrl> &links,
+                                  Server *server,
+                                  QIODevice *device) const
+{
+    resetLastError();
+
+    data->writeCollectionHeader(collection, device);
+    data->writeObjects(objects, true, server, device);
+    data->writeCollectionFooter(collection, links, objects.size(), server, device);
+
+    return true;
+}
+
+void HalJsonSerializerData::writeCollectionHeader(const QDataSuite::AbstractDataAccessObject *collection,
+                                                  QIODevice *device) const
+{
+    device->write("{\"_embedded\":{");
+    device->write(jsonString(collection->dataSuiteMetaObject().collectionName()));
+    device->write(":[");
+}
+
+void HalJsonSerializerData::writeObjects(const QList<QObject *> &objects,
+                                         bool first,
+                                         Server *server,
+                                         QIODevice *device) const
+{
+    foreach(QObject *object, objects) {
+        if(!first)
+            device->write(",");
+        first = false;
+
+        QHalResource objectResource = objectToResource(object, server);
+        QJsonDocument objectDocument = QJsonDocument::fromVariant(objectResource.toVariant());
+        device->write(objectDocument.toJson(QJsonDocument::Compact));
+    }
 }
 
+void HalJsonSerializerData::writeCollectionFooter(const QDataSuite::AbstractDataAccessObject *collection,
+                                                  const QMap<QString, QUrl> &links,
+                                                  int count,
+                                                  Server *server,
+                                                  QIODevice *device) const
+{
+    QUrl collectionUrl = server->linkHelper()->collectionLink(collection);
+
+    device->write("]},\"_links\":{\"self\":{\"href\":");
+    device->write(jsonString(collectionUrl.toString()));
+    device->write("}");
+
+    QMapIterator<QString, QUrl> it(links);
+    while(it.hasNext()) {
+        it.next();
+        device->write(",");
+        device->write(jsonString(it.key()));
+        device->write(":{\"href\":");
+        device->write(jsonString(it.value().toString()));
+        device->write("}");
+    }
+
+    device->write("},\"count\":");
+    device->write(QByteArray::number(count));
+    device->write("}");
+}
 
 } // namespace QRestServer
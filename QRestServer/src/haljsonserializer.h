@@ -19,6 +19,14 @@ public:
     QByteArray serialize(const QDataSuite::Error &error) const;
     QByteArray serialize(const QDataSuite::AbstractDataAccessObject *collection,
                          Server *server) const;
+    bool serialize(const QDataSuite::AbstractDataAccessObject *collection,
+                   Server *server,
+                   QIODevice *device) const;
+    bool serialize(const QDataSuite::AbstractDataAccessObject *collection,
+                   const QList<QObject *> &objects,
+                   const QMap<QString, QUrl> &links,
+                   Server *server,
+                   QIODevice *device) const;
     
 private:
     QSharedDataPointer<HalJsonSerializerData> data;
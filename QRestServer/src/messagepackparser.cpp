@@ -0,0 +1,240 @@
+#include "messagepackparser.h"
+
+#include <QtEndian>
+
+#include <cstring>
+
+namespace QRestServer {
+
+static const int MaximumNestingDepth = 64;
+
+class MessagePackReader
+{
+public:
+    explicit MessagePackReader(const QByteArray &data) :
+        data(data),
+        position(0)
+    {}
+
+    QVariant readItem(int depth = 0);
+    bool atEnd() const { return position >= data.size(); }
+
+    QString error;
+
+private:
+    const QByteArray &data;
+    int position;
+
+    const uchar *current() const { return reinterpret_cast<const uchar *>(data.constData()) + position; }
+    bool need(quint64 bytes);
+    template<typename T> bool readInteger(T *value);
+    bool readLength(int bytes, quint32 *length);
+    QByteArray readBytes(quint32 length);
+    QVariant readArray(quint32 size, int depth);
+    QVariant readMap(quint32 size, int depth);
+    QVariant fail(const QString &message);
+};
+
+QVariant MessagePackReader::fail(const QString &message)
+{
+    if(error.isEmpty())
+        error = QString("%1 at offset %2").arg(message).arg(position);
+    return QVariant();
+}
+
+bool MessagePackReader::need(quint64 bytes)
+{
+    if(quint64(data.size() - position) >= bytes)
+        return true;
+
+    fail(QLatin1String("Unexpected end of data"));
+    return false;
+}
+
+template<typename T>
+bool MessagePackReader::readInteger(T *value)
+{
+    if(!need(sizeof(T)))
+        return false;
+
+    *value = qFromBigEndian<T>(current());
+    position += sizeof(T);
+    return true;
+}
+
+bool MessagePackReader::readLength(int bytes, quint32 *length)
+{
+    switch(bytes) {
+    case 1: {
+        quint8 value;
+        if(!readInteger(&value)) return false;
+        *length = value;
+        return true;
+    }
+    case 2: {
+        quint16 value;
+        if(!readInteger(&value)) return false;
+        *length = value;
+        return true;
+    }
+    default:
+        return readInteger(length);
+    }
+}
+
+QByteArray MessagePackReader::readBytes(quint32 length)
+{
+    if(!need(length))
+        return QByteArray();
+
+    QByteArray result(data.constData() + position, int(length));
+    position += int(length);
+    return result;
+}
+
+QVariant MessagePackReader::readArray(quint32 size, int depth)
+{
+    // Every item takes at least one byte
+    if(!need(size))
+        return QVariant();
+
+    QVariantList list;
+    for(quint32 i = 0; i < size && error.isEmpty(); ++i)
+        list.append(readItem(depth + 1));
+    return list;
+}
+
+QVariant MessagePackReader::readMap(quint32 size, int depth)
+{
+    if(!need(quint64(size) * 2))
+        return QVariant();
+
+    QVariantMap map;
+    for(quint32 i = 0; i < size && error.isEmpty(); ++i) {
+        QString key = readItem(depth + 1).toString();
+        map.insert(key, readItem(depth + 1));
+    }
+    return map;
+}
+
+QVariant MessagePackReader::readItem(int depth)
+{
+    if(depth > MaximumNestingDepth)
+        return fail(QLatin1String("Nesting too deep"));
+
+    if(!need(1))
+        return QVariant();
+
+    uchar marker = *current();
+    ++position;
+
+    if(marker <= 0x7f)
+        return qint64(marker);
+    if(marker >= 0xe0)
+        return qint64(qint8(marker));
+    if((marker & 0xf0) == 0x80)
+        return readMap(marker & 0x0f, depth);
+    if((marker & 0xf0) == 0x90)
+        return readArray(marker & 0x0f, depth);
+    if((marker & 0xe0) == 0xa0)
+        return QString::fromUtf8(readBytes(marker & 0x1f));
+
+    quint32 length = 0;
+    switch(marker) {
+    case 0xc0:
+        return QVariant();
+    case 0xc2:
+        return false;
+    case 0xc3:
+        return true;
+    case 0xc4:
+    case 0xc5:
+    case 0xc6:
+        if(!readLength(1 << (marker - 0xc4), &length))
+            return QVariant();
+        return readBytes(length);
+    case 0xc7:
+    case 0xc8:
+    case 0xc9:
+        // Extension types are not known to us; their data is returned as bytes
+        if(!readLength(1 << (marker - 0xc7), &length) || !need(1))
+            return QVariant();
+        ++position;
+        return readBytes(length);
+    case 0xca: {
+        quint32 bits;
+        if(!readInteger(&bits))
+            return QVariant();
+        float result;
+        memcpy(&result, &bits, sizeof(result));
+        return double(result);
+    }
+    case 0xcb: {
+        quint64 bits;
+        if(!readInteger(&bits))
+            return QVariant();
+        double result;
+        memcpy(&result, &bits, sizeof(result));
+        return result;
+    }
+    case 0xcc: { quint8 value; if(!readInteger(&value)) return QVariant(); return qint64(value); }
+    case 0xcd: { quint16 value; if(!readInteger(&value)) return QVariant(); return qint64(value); }
+    case 0xce: { quint32 value; if(!readInteger(&value)) return QVariant(); return qint64(value); }
+    case 0xcf: { quint64 value; if(!readInteger(&value)) return QVariant(); return value; }
+    case 0xd0: { qint8 value; if(!readInteger(&value)) return QVariant(); return qint64(value); }
+    case 0xd1: { qint16 value; if(!readInteger(&value)) return QVariant(); return qint64(value); }
+    case 0xd2: { qint32 value; if(!readInteger(&value)) return QVariant(); return qint64(value); }
+    case 0xd3: { qint64 value; if(!readInteger(&value)) return QVariant(); return value; }
+    case 0xd4:
+    case 0xd5:
+    case 0xd6:
+    case 0xd7:
+    case 0xd8:
+        // fixext: one byte type and 1, 2, 4, 8 or 16 bytes of data
+        if(!need(1))
+            return QVariant();
+        ++position;
+        return readBytes(1 << (marker - 0xd4));
+    case 0xd9:
+    case 0xda:
+    case 0xdb:
+        if(!readLength(1 << (marker - 0xd9), &length))
+            return QVariant();
+        return QString::fromUtf8(readBytes(length));
+    case 0xdc:
+    case 0xdd:
+        if(!readLength(marker == 0xdc ? 2 : 4, &length))
+            return QVariant();
+        return readArray(length, depth);
+    case 0xde:
+    case 0xdf:
+        if(!readLength(marker == 0xde ? 2 : 4, &length))
+            return QVariant();
+        return readMap(length, depth);
+    default:
+        return fail(QLatin1String("Invalid marker"));
+    }
+}
+
+MessagePackParser::MessagePackParser() :
+    VariantParser("msgpack", "application/msgpack")
+{
+}
+
+MessagePackParser::~MessagePackParser()
+{
+}
+
+QVariant MessagePackParser::decode(const QByteArray &data, QString *errorMessage) const
+{
+    MessagePackReader reader(data);
+    QVariant result = reader.readItem();
+
+    if(reader.error.isEmpty() && !reader.atEnd())
+        reader.error = QLatin1String("Unexpected data after the document");
+
+    *errorMessage = reader.error;
+    return result;
+}
+
+} // namespace QRestServer
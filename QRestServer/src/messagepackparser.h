@@ -0,0 +1,23 @@
+#ifndef QRESTSERVER_MESSAGEPACKPARSER_H
+#define QRESTSERVER_MESSAGEPACKPARSER_H
+
+#include "variantparser.h"
+
+namespace QRestServer {
+
+class MessagePackParser : public VariantParser
+{
+public:
+    MessagePackParser();
+    ~MessagePackParser();
+
+protected:
+    QVariant decode(const QByteArray &data, QString *errorMessage) const Q_DECL_OVERRIDE;
+
+private:
+    Q_DISABLE_COPY(MessagePackParser)
+};
+
+} // namespace QRestServer
+
+#endif // QRESTSERVER_MESSAGEPACKPARSER_H
@@ -0,0 +1,206 @@
+#include "messagepackserializer.h"
+
+#include <QDateTime>
+#include <QIODevice>
+#include <QStringList>
+#include <QUrl>
+#include <QtEndian>
+
+#include <cstring>
+#include <limits>
+
+namespace QRestServer {
+
+static const char MessagePackNil = char(0xc0);
+static const char MessagePackFalse = char(0xc2);
+static const char MessagePackTrue = char(0xc3);
+
+// Writes the marker followed by the big endian value
+template<class T>
+static void writeValue(QIODevice *device, uchar marker, T value)
+{
+    char buffer[1 + sizeof(T)];
+    buffer[0] = char(marker);
+    qToBigEndian<T>(value, reinterpret_cast<uchar *>(buffer + 1));
+    device->write(buffer, sizeof(buffer));
+}
+
+static void writeInteger(QIODevice *device, qint64 value)
+{
+    if(value >= 0) {
+        if(value <= 0x7f) {
+            char fixint = char(value);
+            device->write(&fixint, 1);
+        }
+        else if(value <= 0xff) {
+            writeValue<quint8>(device, 0xcc, quint8(value));
+        }
+        else if(value <= 0xffff) {
+            writeValue<quint16>(device, 0xcd, quint16(value));
+        }
+        else if(value <= 0xffffffffLL) {
+            writeValue<quint32>(device, 0xce, quint32(value));
+        }
+        else {
+            writeValue<quint64>(device, 0xcf, quint64(value));
+        }
+        return;
+    }
+
+    if(value >= -32) {
+        char fixint = char(value);
+        device->write(&fixint, 1);
+    }
+    else if(value >= -128) {
+        writeValue<qint8>(device, 0xd0, qint8(value));
+    }
+    else if(value >= -32768) {
+        writeValue<qint16>(device, 0xd1, qint16(value));
+    }
+    else if(value >= -2147483647LL - 1) {
+        writeValue<qint32>(device, 0xd2, qint32(value));
+    }
+    else {
+        writeValue<qint64>(device, 0xd3, value);
+    }
+}
+
+static void writeHeader(QIODevice *device, int size, uchar fixMarker, int fixMaximum, uchar marker16, uchar marker32)
+{
+    if(size <= fixMaximum) {
+        char fix = char(fixMarker | size);
+        device->write(&fix, 1);
+    }
+    else if(size <= 0xffff) {
+        writeValue<quint16>(device, marker16, quint16(size));
+    }
+    else {
+        writeValue<quint32>(device, marker32, quint32(size));
+    }
+}
+
+static void writeString(QIODevice *device, const QString &string)
+{
+    QByteArray utf8 = string.toUtf8();
+    if(utf8.size() < 32) {
+        char fixstr = char(0xa0 | utf8.size());
+        device->write(&fixstr, 1);
+    }
+    else if(utf8.size() <= 0xff) {
+        writeValue<quint8>(device, 0xd9, quint8(utf8.size()));
+    }
+    else if(utf8.size() <= 0xffff) {
+        writeValue<quint16>(device, 0xda, quint16(utf8.size()));
+    }
+    else {
+        writeValue<quint32>(device, 0xdb, quint32(utf8.size()));
+    }
+    device->write(utf8);
+}
+
+MessagePackSerializer::MessagePackSerializer() :
+    VariantSerializer("msgpack", "application/msgpack")
+{
+}
+
+MessagePackSerializer::~MessagePackSerializer()
+{
+}
+
+void MessagePackSerializer::writeArrayHeader(QIODevice *device, int size) const
+{
+    writeHeader(device, size, 0x90, 15, 0xdc, 0xdd);
+}
+
+void MessagePackSerializer::writeMapHeader(QIODevice *device, int size) const
+{
+    writeHeader(device, size, 0x80, 15, 0xde, 0xdf);
+}
+
+void MessagePackSerializer::writeVariant(QIODevice *device, const QVariant &value) const
+{
+    if(!value.isValid() || value.isNull()) {
+        device->write(&MessagePackNil, 1);
+        return;
+    }
+
+    switch(value.type()) {
+    case QVariant::Bool:
+        device->write(value.toBool() ? &MessagePackTrue : &MessagePackFalse, 1);
+        break;
+    case QVariant::Int:
+    case QVariant::LongLong:
+    case QVariant::UInt:
+        writeInteger(device, value.toLongLong());
+        break;
+    case QVariant::ULongLong:
+        if(value.toULongLong() > quint64(std::numeric_limits<qint64>::max()))
+            writeValue<quint64>(device, 0xcf, value.toULongLong());
+        else
+            writeInteger(device, value.toLongLong());
+        break;
+    case QVariant::Double: {
+        double number = value.toDouble();
+        quint64 bits;
+        memcpy(&bits, &number, sizeof(bits));
+        writeValue<quint64>(device, 0xcb, bits);
+        break;
+    }
+    case QVariant::ByteArray: {
+        QByteArray bytes = value.toByteArray();
+        if(bytes.size() <= 0xff)
+            writeValue<quint8>(device, 0xc4, quint8(bytes.size()));
+        else if(bytes.size() <= 0xffff)
+            writeValue<quint16>(device, 0xc5, quint16(bytes.size()));
+        else
+            writeValue<quint32>(device, 0xc6, quint32(bytes.size()));
+        device->write(bytes);
+        break;
+    }
+    case QVariant::DateTime:
+        writeString(device, value.toDateTime().toString(Qt::ISODate));
+        break;
+    case QVariant::Date:
+        writeString(device, value.toDate().toString(Qt::ISODate));
+        break;
+    case QVariant::Url:
+        writeString(device, value.toUrl().toString());
+        break;
+    case QVariant::StringList:
+    case QVariant::List: {
+        QVariantList list = value.toList();
+        writeArrayHeader(device, list.size());
+        foreach(const QVariant &item, list) {
+            writeVariant(device, item);
+        }
+        break;
+    }
+    case QVariant::Map: {
+        QVariantMap map = value.toMap();
+        writeMapHeader(device, map.size());
+        QMapIterator<QString, QVariant> it(map);
+        while(it.hasNext()) {
+            it.next();
+            writeString(device, it.key());
+            writeVariant(device, it.value());
+        }
+        break;
+    }
+    case QVariant::Hash: {
+        QVariantHash hash = value.toHash();
+        writeMapHeader(device, hash.size());
+        QHashIterator<QString, QVariant> it(hash);
+        while(it.hasNext()) {
+            it.next();
+            writeString(device, it.key());
+            writeVariant(device, it.value());
+        }
+        break;
+    }
+    default:
+        writeString(device, value.toString());
+        break;
+    }
+}
+
+} // namespace QRestServer
@@ -0,0 +1,26 @@
+#ifndef QRESTSERVER_MESSAGEPACKSERIALIZER_H
+#define QRESTSERVER_MESSAGEPACKSERIALIZER_H
+
+#include "variantserializer.h"
+
+namespace QRestServer {
+
+// MessagePack (https://github.com/msgpack/msgpack/blob/master/spec.md)
+class MessagePackSerializer : public VariantSerializer
+{
+public:
+    MessagePackSerializer();
+    ~MessagePackSerializer();
+
+protected:
+    void writeVariant(QIODevice *device, const QVariant &value) const Q_DECL_OVERRIDE;
+    void writeArrayHeader(QIODevice *device, int size) const Q_DECL_OVERRIDE;
+    void writeMapHeader(QIODevice *device, int size) const Q_DECL_OVERRIDE;
+
+private:
+    Q_DISABLE_COPY(MessagePackSerializer)
+};
+
+} // namespace QRestServer
+
+#endif // QRESTSERVER_MESSAGEPACKSERIALIZER_H
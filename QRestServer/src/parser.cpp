@@ -3,6 +3,8 @@
 #include <QDataSuite/error.h>
 
 #include <QHash>
+#include <QString>
+#include <QThreadStorage>
 
 namespace QRestServer {
 
@@ -13,7 +15,8 @@ public:
         QSharedData()
     {}
 
-    mutable QDataSuite::Error lastError;
+    // Each instance is shared by all threads serving requests
+    mutable QThreadStorage<QDataSuite::Error> lastError;
     QString format;
     QString contentType;
 
@@ -45,12 +48,12 @@ QString Parser::format() const
 
 QDataSuite::Error Parser::lastError() const
 {
-    return d->lastError;
+    return d->lastError.localData();
 }
 
 void Parser::setLastError(const QDataSuite::Error &error) const
 {
-    d->lastError = error;
+    d->lastError.setLocalData(error);
 }
 
 void Parser::resetLastError() const
@@ -63,6 +66,25 @@ Parser *Parser::forFormat(const QString &format)
     return ParserPrivate::parsers.value(format);
 }
 
+Parser *Parser::forContentType(const QString &contentType)
+{
+    // Parameters like "; charset=utf-8" do not matter
+    QString mediaType = contentType.section(';', 0, 0).trimmed().toLower();
+    if(mediaType.isEmpty())
+        return forFormat(QString());
+
+    foreach(Parser *parser, ParserPrivate::parsers) {
+        if(parser->contentType() == mediaType)
+            return parser;
+    }
+
+    // Plain JSON is what most clients send for HAL
+    if(mediaType == QLatin1String("application/json"))
+        return forFormat(QLatin1String("json"));
+
+    return 0;
+}
+
 void Parser::registerParser(Parser *parser)
 {
     if(!ParserPrivate::parsers.contains(QString()))
@@ -1,7 +1,7 @@
 #ifndef QDATASUITE_PARSER_H
 #define QDATASUITE_PARSER_H
 
-#include <QtCore/QSharedDataPointer>
+#include <QtCore/QExplicitlySharedDataPointer>
 
 class QByteArray;
 class QObject;
@@ -29,6 +29,8 @@ public:
     virtual void parse(const QByteArray &data, QObject *object, Server *server, Mode mode) const = 0;
 
     static Parser *forFormat(const QString &format);
+    // Returns the parser for the value of a Content-Type header, or 0
+    static Parser *forContentType(const QString &contentType);
     static void registerParser(Parser *parser);
     static void setDefaultParser(Parser *parser);
 
@@ -39,7 +41,7 @@ protected:
     void resetLastError() const;
 
 private:
-    QSharedDataPointer<ParserPrivate> d;
+    QExplicitlySharedDataPointer<ParserPrivate> d;
 };
 
 } // namespace QRestServer
@@ -3,40 +3,121 @@
 #include "server.h"
 #include "serializer.h"
 #include "parser.h"
+#include "chunkedresponsedevice.h"
+#include "responsewriter.h"
+#include "connectionmanager.h"
+#include "etagcache.h"
+#include "responsecache.h"
+#include "responsecompression.h"
 
 #include <QDataSuite/metaobject.h>
 #include <QDataSuite/metaproperty.h>
 #include <QDataSuite/abstractdataaccessobject.h>
+#include <QDataSuite/taskscope.h>
 
 #include <qhttprequest.h>
 #include <qhttpresponse.h>
 
+#include <QUrlQuery>
+#include <QtConcurrent/QtConcurrentRun>
+
 Q_DECLARE_METATYPE(QHttpResponse::StatusCode)
 
 namespace QRestServer {
 
+static const char *QueryItemLimit = "limit";
+static const char *QueryItemOffset = "offset";
+static const char *QueryItemAfter = "after";
+static const int DefaultPageSize = 100;
+static const int MaximumPageSize = 1000;
+static const char *VaryHeaders = "Accept, Accept-Encoding";
+
+// The parts of a request, which a reply needs. They are copied from the QHttpRequest,
+// before they are handed to a worker, because the request belongs to its connection,
+// which might delete it meanwhile.
+class RequestData
+{
+public:
+    RequestData() :
+        method(QHttpRequest::HTTP_GET)
+    {}
+
+    explicit RequestData(const QHttpRequest *req) :
+        method(req->method()),
+        url(req->url()),
+        path(req->path()),
+        headers(req->headers()),
+        body(req->body())
+    {}
+
+    // Header names are stored in lower case
+    QString header(const QString &field) const { return headers.value(field.toLower()); }
+
+    QHttpRequest::HttpMethod method;
+    QUrl url;
+    QString path;
+    QHash<QString, QString> headers;
+    QByteArray body;
+};
+
 class ResponderPrivate : public QSharedData
 {
 public:
     ResponderPrivate() :
-        QSharedData()
+        QSharedData(),
+        object(0),
+        serializer(0),
+        cacheGeneration(0),
+        encoding(ResponseCompression::Identity),
+        replying(false),
+        responseDone(false)
     {}
 
     QHttpRequest *req; // We need to delete the request
-    QHttpResponse *resp;
+    RequestData request;
+    ResponseWriter *resp;
     QDataSuite::AbstractDataAccessObject *collection;
+    QVariant objectKey;
     QObject *object;
     Server *server;
+    Serializer *serializer;
+    QByteArray etag;
+    quint64 cacheGeneration;
+    ResponseCompression::Encoding encoding;
+
+    // A responder must live until both its reply and its response are done
+    bool replying;
+    bool responseDone;
 
     Responder *q;
 
-    void serveResponse(const QByteArray &data, QHttpResponse::StatusCode statusCode = QHttpResponse::STATUS_OK);
+    void reply();
+
+    // The tag of the state of the object or collection, which is served.
+    // Headers carry the tag of its representation in the negotiated format and encoding.
+    QByteArray representationETag() const;
+
+    void serveResponse(const QByteArray &data,
+                       QHttpResponse::StatusCode statusCode = QHttpResponse::STATUS_OK,
+                       const QString &contentType = QString());
+    bool isCompressed(const QByteArray &data) const;
+    void serveBody(const QByteArray &body,
+                   bool compressed,
+                   QHttpResponse::StatusCode statusCode,
+                   const QString &contentType);
+    void serveNotModified();
+    bool serveCachedResponse();
+    void cacheResponse(const QByteArray &data);
     void serveError(const QDataSuite::Error &error);
     void serveError(const QByteArray &message, QHttpResponse::StatusCode statusCode);
 
+    Parser *requestParser();
+    void setNegotiationHeaders(ChunkedResponseDevice *device);
+
     void replyCollection();
     void createObject();
     void serveCollection();
+    void servePage(const QUrlQuery &query);
 
     void replyObject();
     void serveObject();
@@ -45,6 +126,15 @@ public:
     void updateObject();
 };
 
+QByteArray ResponderPrivate::representationETag() const
+{
+    QString encodingName;
+    if (encoding != ResponseCompression::Identity)
+        encodingName = ResponseCompression::encodingName(encoding);
+
+    return ETagCache::representationETag(etag, serializer->format(), encodingName);
+}
+
 void ResponderPrivate::serveError(const QByteArray &message, QHttpResponse::StatusCode statusCode)
 {
     QDataSuite::Error error(message, QDataSuite::Error::ServerError);
@@ -52,23 +142,184 @@ void ResponderPrivate::serveError(const QByteArray &message, QHttpResponse::Stat
     serveError(error);
 }
 
-void ResponderPrivate::serveResponse(const QByteArray &data, QHttpResponse::StatusCode statusCode)
+void ResponderPrivate::serveResponse(const QByteArray &data,
+                                     QHttpResponse::StatusCode statusCode,
+                                     const QString &contentType)
+{
+    if (isCompressed(data))
+        serveBody(server->responseCompression()->compress(data, encoding), true, statusCode, contentType);
+    else
+        serveBody(data, false, statusCode, contentType);
+}
+
+bool ResponderPrivate::isCompressed(const QByteArray &data) const
 {
-    Responder::serve(resp, data, statusCode);
+    ResponseCompression *compression = server->responseCompression();
+    return encoding != ResponseCompression::Identity
+            && compression->threshold() >= 0
+            && data.size() >= compression->threshold();
+}
+
+void ResponderPrivate::serveBody(const QByteArray &body,
+                                 bool compressed,
+                                 QHttpResponse::StatusCode statusCode,
+                                 const QString &contentType)
+{
+    resp->setHeader(HttpHeaderContentType, contentType.isEmpty() ? serializer->contentType() : contentType);
+    resp->setHeader(HttpHeaderVary, QLatin1String(VaryHeaders));
+    if (!etag.isEmpty())
+        resp->setHeader(HttpHeaderETag, QString::fromLatin1(representationETag()));
+    if (compressed)
+        resp->setHeader(HttpHeaderContentEncoding, ResponseCompression::encodingName(encoding));
+
+    resp->setHeader(HttpHeaderContentLength, QString::number(body.length()));
+    resp->writeHead(statusCode);
+    resp->write(body);
+    resp->end();
+}
+
+void ResponderPrivate::serveNotModified()
+{
+    resp->setHeader(HttpHeaderETag, QString::fromLatin1(representationETag()));
+    resp->setHeader(HttpHeaderVary, QLatin1String(VaryHeaders));
+    resp->setHeader(HttpHeaderContentLength, QString::number(0));
+    resp->writeHead(QHttpResponse::STATUS_NOT_MODIFIED);
+    resp->end();
+}
+
+bool ResponderPrivate::serveCachedResponse()
+{
+    ResponseCache *cache = server->responseCache();
+
+    QString path = request.url.toString();
+    QByteArray data;
+    QByteArray cachedETag;
+    if (cache->response(path, serializer->format(), &data, &cachedETag)) {
+        etag = cachedETag;
+
+        if (!isCompressed(data)) {
+            serveBody(data, false, QHttpResponse::STATUS_OK, QString());
+            return true;
+        }
+
+        // Each response is only compressed once per content coding
+        QString encodingName = ResponseCompression::encodingName(encoding);
+        QByteArray body = cache->encodedResponse(path, serializer->format(), encodingName);
+        if (body.isEmpty()) {
+            body = server->responseCompression()->compress(data, encoding);
+            cache->insertEncodedResponse(path, serializer->format(), cachedETag, encodingName, body);
+        }
+
+        serveBody(body, true, QHttpResponse::STATUS_OK, QString());
+        return true;
+    }
+
+    cacheGeneration = cache->generation(collection);
+    return false;
+}
+
+void ResponderPrivate::cacheResponse(const QByteArray &data)
+{
+    server->responseCache()->insertResponse(cacheGeneration,
+                                            request.url.toString(),
+                                            serializer->format(),
+                                            collection,
+                                            objectKey,
+                                            data,
+                                            etag);
+}
+
+Parser *ResponderPrivate::requestParser()
+{
+    Parser *parser = Parser::forContentType(request.header(HttpHeaderContentType));
+    if (!parser) {
+        serveError(QString("Unsupported content type: %1").arg(request.header(HttpHeaderContentType)).toLatin1(),
+                   QHttpResponse::STATUS_UNSUPPORTED_MEDIA_TYPE);
+    }
+    return parser;
+}
+
+void ResponderPrivate::setNegotiationHeaders(ChunkedResponseDevice *device)
+{
+    device->setHeader(HttpHeaderContentType, serializer->contentType());
+    device->setHeader(HttpHeaderVary, QLatin1String(VaryHeaders));
+    device->setCompression(server->responseCompression(), encoding);
 }
 
 void ResponderPrivate::serveError(const QDataSuite::Error &err)
 {
-    Serializer *serializer = Serializer::forFormat(Server::formatFromRequest(req));
+    etag.clear();
     QHttpResponse::StatusCode statusCode = err.additionalInformation().value(HttpStatusCode).value<QHttpResponse::StatusCode>();
     if(statusCode == 0)
         statusCode = QHttpResponse::STATUS_BAD_REQUEST;
     serveResponse(serializer->serialize(err), statusCode);
 }
 
+void ResponderPrivate::reply()
+{
+    if (!collection) {
+        serveError(QString("Collection not found: %1").arg(request.path).toLatin1(),
+                   QHttpResponse::STATUS_NOT_FOUND);
+        return;
+    }
+
+    ETagCache *etagCache = server->etagCache();
+    QHttpRequest::HttpMethod method = request.method;
+
+    if (objectKey.isNull()) {
+        if (method == QHttpRequest::HTTP_GET) {
+            etag = etagCache->collectionETag(collection);
+            if (ETagCache::matches(request.header(HttpHeaderIfNoneMatch), representationETag(), true)) {
+                serveNotModified();
+                return;
+            }
+
+            if (serveCachedResponse())
+                return;
+        }
+
+        replyCollection();
+        return;
+    }
+
+    // Unchanged objects are neither read nor serialized again
+    if (method == QHttpRequest::HTTP_GET) {
+        etag = etagCache->cachedObjectETag(collection, objectKey);
+        if (ETagCache::matches(request.header(HttpHeaderIfNoneMatch), representationETag(), true)) {
+            serveNotModified();
+            return;
+        }
+        etag.clear();
+
+        if (serveCachedResponse())
+            return;
+    }
+
+    object = collection->readObject(objectKey);
+
+    if (!object) {
+        serveError(QString("Object not found: %1").arg(request.path).toLatin1(),
+                   QHttpResponse::STATUS_NOT_FOUND);
+        return;
+    }
+
+    if (method == QHttpRequest::HTTP_PUT
+            || method == QHttpRequest::HTTP_DELETE) {
+        QString ifMatch = request.header(HttpHeaderIfMatch);
+        if (!ifMatch.isEmpty()
+                && !ETagCache::matchesAnyRepresentation(ifMatch, etagCache->objectETag(object))) {
+            serveError(QByteArray("The object has been changed by someone else."),
+                       QHttpResponse::STATUS_PRECONDITION_FAILED);
+            return;
+        }
+    }
+
+    replyObject();
+}
+
 void ResponderPrivate::replyCollection()
 {
-    switch (req->method())
+    switch (request.method)
     {
     case QHttpRequest::HTTP_GET:
         serveCollection();
@@ -84,7 +335,7 @@ void ResponderPrivate::replyCollection()
 
 void ResponderPrivate::replyObject()
 {
-    switch (req->method())
+    switch (request.method)
     {
     case QHttpRequest::HTTP_GET:
         serveObject();
@@ -103,15 +354,132 @@ void ResponderPrivate::replyObject()
 
 void ResponderPrivate::serveCollection()
 {
-    Serializer *serializer = Serializer::forFormat(Server::formatFromRequest(req));
-    QByteArray data = serializer->serialize(collection, server);
+    QUrlQuery query(request.url);
+    if (query.hasQueryItem(QueryItemLimit)
+            || query.hasQueryItem(QueryItemOffset)
+            || query.hasQueryItem(QueryItemAfter)) {
+        servePage(query);
+        return;
+    }
+
+    // Collections may be large, so they are streamed in chunks
+    ChunkedResponseDevice device(resp);
+    setNegotiationHeaders(&device);
+    device.setHeader(HttpHeaderETag, QString::fromLatin1(representationETag()));
+    device.setCaptureLimit(server->responseCache()->maximumSize() / 4);
+    device.open(QIODevice::WriteOnly);
+    serializer->serialize(collection, server, &device);
 
     if (serializer->lastError().isValid()) {
-        serveError(serializer->lastError());
+        if (!device.isHeadWritten()) {
+            serveError(serializer->lastError());
+            return;
+        }
+
+        qWarning("Could not serialize the collection: %s", qPrintable(serializer->lastError().text()));
+    }
+    else if (device.hasCapturedData()) {
+        cacheResponse(device.capturedData());
+    }
+
+    device.close();
+}
+
+void ResponderPrivate::servePage(const QUrlQuery &query)
+{
+    bool ok = true;
+    int limit = DefaultPageSize;
+    if (query.hasQueryItem(QueryItemLimit))
+        limit = query.queryItemValue(QueryItemLimit).toInt(&ok);
+
+    if (!ok || limit <= 0 || limit > MaximumPageSize) {
+        serveError(QString("The limit has to be between 1 and %1.").arg(MaximumPageSize).toLatin1(),
+                   QHttpResponse::STATUS_BAD_REQUEST);
         return;
     }
 
-    serveResponse(data);
+    int offset = 0;
+    if (query.hasQueryItem(QueryItemOffset))
+        offset = query.queryItemValue(QueryItemOffset).toInt(&ok);
+
+    if (!ok || offset < 0) {
+        serveError(QByteArray("The offset has to be a positive number."), QHttpResponse::STATUS_BAD_REQUEST);
+        return;
+    }
+
+    bool keyset = query.hasQueryItem(QueryItemAfter);
+    QList<QObject *> objects;
+    if (keyset) {
+        // The key need not exist anymore: pages continue after objects, which have been removed meanwhile
+        QDataSuite::MetaProperty keyMetaProperty = collection->dataSuiteMetaObject().primaryKeyProperty();
+        QVariant afterKey = query.queryItemValue(QueryItemAfter);
+        if (!afterKey.convert(keyMetaProperty.type())) {
+            serveError(QString("Invalid key after which to start the page: %1")
+                       .arg(query.queryItemValue(QueryItemAfter)).toLatin1(),
+                       QHttpResponse::STATUS_BAD_REQUEST);
+            return;
+        }
+
+        objects = collection->readObjectsAfter(afterKey, limit);
+    }
+    else
+        objects = collection->readObjects(offset, limit);
+
+    if (collection->lastError().isValid()) {
+        serveError(collection->lastError());
+        return;
+    }
+
+    // A full page might be followed by another one
+    QMap<QString, QUrl> links;
+    QUrl collectionUrl = server->linkHelper()->collectionLink(collection);
+
+    if (objects.size() == limit) {
+        QUrlQuery nextQuery;
+        nextQuery.addQueryItem(QueryItemLimit, QString::number(limit));
+        if (keyset) {
+            QDataSuite::MetaProperty keyMetaProperty = collection->dataSuiteMetaObject().primaryKeyProperty();
+            nextQuery.addQueryItem(QueryItemAfter, keyMetaProperty.read(objects.last()).toString());
+        }
+        else {
+            nextQuery.addQueryItem(QueryItemOffset, QString::number(offset + limit));
+        }
+
+        QUrl nextUrl(collectionUrl);
+        nextUrl.setQuery(nextQuery);
+        links.insert(QLatin1String("next"), nextUrl);
+    }
+
+    if (!keyset && offset > 0) {
+        QUrlQuery prevQuery;
+        prevQuery.addQueryItem(QueryItemLimit, QString::number(limit));
+        prevQuery.addQueryItem(QueryItemOffset, QString::number(qMax(0, offset - limit)));
+
+        QUrl prevUrl(collectionUrl);
+        prevUrl.setQuery(prevQuery);
+        links.insert(QLatin1String("prev"), prevUrl);
+    }
+
+    ChunkedResponseDevice device(resp);
+    setNegotiationHeaders(&device);
+    device.setHeader(HttpHeaderETag, QString::fromLatin1(representationETag()));
+    device.setCaptureLimit(server->responseCache()->maximumSize() / 4);
+    device.open(QIODevice::WriteOnly);
+    serializer->serialize(collection, objects, links, server, &device);
+
+    if (serializer->lastError().isValid()) {
+        if (!device.isHeadWritten()) {
+            serveError(serializer->lastError());
+            return;
+        }
+
+        qWarning("Could not serialize the collection: %s", qPrintable(serializer->lastError().text()));
+    }
+    else if (device.hasCapturedData()) {
+        cacheResponse(device.capturedData());
+    }
+
+    device.close();
 }
 
 void ResponderPrivate::createObject()
@@ -124,8 +492,13 @@ void ResponderPrivate::createObject()
         return;
     }
 
-    Parser *parser = Parser::forFormat(Server::formatFromRequest(req));
-    parser->parse(req->body(), newObject, server, Parser::Create);
+    Parser *parser = requestParser();
+    if (!parser) {
+        delete newObject;
+        return;
+    }
+
+    parser->parse(request.body, newObject, server, Parser::Create);
 
     if (parser->lastError().isValid()) {
         serveError(parser->lastError());
@@ -163,7 +536,13 @@ void ResponderPrivate::serveObject()
 
 void ResponderPrivate::serveObject(QObject *obj)
 {
-    Serializer *serializer = Serializer::forFormat(Server::formatFromRequest(req));
+    etag = server->etagCache()->objectETag(obj);
+    if (request.method == QHttpRequest::HTTP_GET
+            && ETagCache::matches(request.header(HttpHeaderIfNoneMatch), representationETag(), true)) {
+        serveNotModified();
+        return;
+    }
+
     QByteArray data = serializer->serialize(obj, server);
 
     if (serializer->lastError().isValid()) {
@@ -171,6 +550,9 @@ void ResponderPrivate::serveObject(QObject *obj)
         return;
     }
 
+    if (request.method == QHttpRequest::HTTP_GET)
+        cacheResponse(data);
+
     serveResponse(data);
 }
 
@@ -183,13 +565,16 @@ void ResponderPrivate::deleteObject()
         return;
     }
 
-    serveResponse(QByteArray("Delete OK!"));
+    serveResponse(QByteArray("Delete OK!"), QHttpResponse::STATUS_OK, QLatin1String("text/plain"));
 }
 
 void ResponderPrivate::updateObject()
 {
-    Parser *parser = Parser::forFormat(Server::formatFromRequest(req));
-    parser->parse(req->body(), object, server, Parser::Update);
+    Parser *parser = requestParser();
+    if (!parser)
+        return;
+
+    parser->parse(request.body, object, server, Parser::Update);
 
     if (parser->lastError().isValid()) {
         serveError(parser->lastError());
@@ -210,20 +595,24 @@ Responder::Responder(QHttpRequest *req,
                      QHttpResponse *resp,
                      Server *server,
                      QDataSuite::AbstractDataAccessObject *collection,
-                     QObject *object) :
+                     const QVariant &objectKey) :
     QObject(server),
     d(new ResponderPrivate)
 {
     d->q = this;
     d->req = req;
-    d->resp = resp;
+    d->resp = new ResponseWriter(resp, this);
+    server->connectionManager()->addResponse(req, d->resp);
     d->collection = collection;
-    d->object = object;
+    d->objectKey = objectKey;
     d->server = server;
+    d->serializer = Serializer::forFormat(Server::formatFromRequest(req));
+    d->encoding = server->responseCompression()->encodingForRequest(req->header(HttpHeaderAcceptEncoding));
     req->storeBody();
 
     connect(req, SIGNAL(end()), this, SLOT(reply()));
-    connect(resp, SIGNAL(done()), this, SLOT(deleteLater()));
+    connect(resp, SIGNAL(done()), this, SLOT(responseDone()));
+    connect(resp, SIGNAL(destroyed()), this, SLOT(responseDone()));
 }
 
 Responder::~Responder()
@@ -234,16 +623,45 @@ Responder::~Responder()
 
 void Responder::reply()
 {
-    if (d->collection) {
-        if (d->object) {
-            d->replyObject();
-        }
-        else {
-            d->replyCollection();
-        }
+    if (d->server->workerThreadCount() == 0) {
+        // Each request is a task of its own, e.g. it reads into its own session
+        QDataSuite::TaskScope scope;
+        d->request = RequestData(d->req);
+        d->reply();
+        return;
+    }
+
+    if (!d->server->acquireQueueSlot()) {
+        d->serveError(QByteArray("The server is too busy. Please try again later."),
+                      QHttpResponse::STATUS_SERVICE_UNAVAILABLE);
+        return;
     }
 
-    d->serveError(QByteArray("Internal server error!"), QHttpResponse::STATUS_INTERNAL_SERVER_ERROR);
+    d->request = RequestData(d->req);
+    d->replying = true;
+    QtConcurrent::run(d->server->workerPool(), [this]() {
+        // The workers never finish, so they give back what they have acquired for the request
+        {
+            QDataSuite::TaskScope scope;
+            d->reply();
+        }
+        d->server->releaseQueueSlot();
+        QMetaObject::invokeMethod(this, "replyFinished", Qt::QueuedConnection);
+    });
+}
+
+void Responder::replyFinished()
+{
+    d->replying = false;
+    if (d->responseDone)
+        deleteLater();
+}
+
+void Responder::responseDone()
+{
+    d->responseDone = true;
+    if (!d->replying)
+        deleteLater();
 }
 
 void Responder::serve(QHttpResponse *resp, const QByteArray &data, QHttpResponse::StatusCode statusCode)
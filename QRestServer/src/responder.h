@@ -4,6 +4,7 @@
 #include <QtCore/QObject>
 
 #include <QtCore/QSharedData>
+#include <QtCore/QVariant>
 #include <QDataSuite/error.h>
 
 #include <qhttpresponse.h>
@@ -28,7 +29,7 @@ public:
                        QHttpResponse *resp,
                        Server *server,
                        QDataSuite::AbstractDataAccessObject *collection,
-                       QObject *object = 0);
+                       const QVariant &objectKey = QVariant());
     ~Responder();
 
     static void serve(QHttpResponse *resp, const QByteArray &data, QHttpResponse::StatusCode statusCode);
@@ -37,6 +38,8 @@ public:
 
 private Q_SLOTS:
     void reply();
+    void replyFinished();
+    void responseDone();
 
 private:
     QSharedDataPointer<ResponderPrivate> d;
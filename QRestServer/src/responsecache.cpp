@@ -0,0 +1,365 @@
+#include "responsecache.h"
+
+#include <QDataSuite/abstractdataaccessobject.h>
+#include <QDataSuite/metaobject.h>
+#include <QDataSuite/metaproperty.h>
+
+#include <QCache>
+#include <QHash>
+#include <QMutex>
+#include <QSet>
+#include <QStringList>
+
+namespace QRestServer {
+
+class ResponseCachePrivate;
+
+// Entries remove their cache key from the indexes, when the cache deletes them,
+// which QCache also does, when it evicts them
+class ResponseCacheEntry
+{
+public:
+    ResponseCacheEntry(ResponseCachePrivate *cache,
+                       const QString &cacheKey,
+                       const QString &collectionName,
+                       const QString &objectKey) :
+        cache(cache),
+        cacheKey(cacheKey),
+        collectionName(collectionName),
+        objectKey(objectKey)
+    {}
+
+    ~ResponseCacheEntry();
+
+    int cost() const;
+
+    QByteArray data;
+    QByteArray etag;
+    // Compressed variants by content coding
+    QHash<QString, QByteArray> encodedData;
+
+    ResponseCachePrivate *cache;
+    QString cacheKey;
+    QString collectionName;
+    QString objectKey;
+};
+
+class ResponseCachePrivate : public QSharedData
+{
+public:
+    ResponseCachePrivate() :
+        QSharedData(),
+        entries(16 * 1024 * 1024),
+        hits(0),
+        misses(0)
+    {}
+
+    ~ResponseCachePrivate()
+    {
+        // The entries remove themselves from the indexes
+        entries.clear();
+    }
+
+    // Responses are cached and invalidated by all workers
+    mutable QMutex mutex;
+
+    // The cost of an entry is its size in bytes
+    QCache<QString, ResponseCacheEntry> entries;
+
+    // The cache keys of the responses of each collection and of each of its objects by key
+    QHash<QString, QSet<QString> > keysByCollection;
+    QHash<QString, QHash<QString, QSet<QString> > > keysByObject;
+    QHash<QString, quint64> generations;
+
+    // Representations contain links to related objects, so a change to a collection
+    // invalidates the responses of the related collections, too
+    QHash<QString, QStringList> relatedCollections;
+
+    mutable int hits;
+    mutable int misses;
+
+    void remove(const QSet<QString> &keys);
+    void removeKey(const ResponseCacheEntry *entry);
+    void invalidate(const QString &collectionName);
+
+    static QString cacheKey(const QString &path, const QString &format);
+};
+
+ResponseCacheEntry::~ResponseCacheEntry()
+{
+    cache->removeKey(this);
+}
+
+int ResponseCacheEntry::cost() const
+{
+    int result = data.size();
+    foreach(const QByteArray &encoded, encodedData) {
+        result += encoded.size();
+    }
+    return result;
+}
+
+QString ResponseCachePrivate::cacheKey(const QString &path, const QString &format)
+{
+    return QString(format).append(' ').append(path);
+}
+
+void ResponseCachePrivate::remove(const QSet<QString> &keys)
+{
+    foreach(const QString &key, keys) {
+        entries.remove(key);
+    }
+}
+
+void ResponseCachePrivate::removeKey(const ResponseCacheEntry *entry)
+{
+    if(entry->objectKey.isNull()) {
+        QHash<QString, QSet<QString> >::iterator it = keysByCollection.find(entry->collectionName);
+        if(it == keysByCollection.end())
+            return;
+
+        it->remove(entry->cacheKey);
+        if(it->isEmpty())
+            keysByCollection.erase(it);
+        return;
+    }
+
+    QHash<QString, QHash<QString, QSet<QString> > >::iterator collectionIt = keysByObject.find(entry->collectionName);
+    if(collectionIt == keysByObject.end())
+        return;
+
+    QHash<QString, QSet<QString> >::iterator it = collectionIt->find(entry->objectKey);
+    if(it == collectionIt->end())
+        return;
+
+    it->remove(entry->cacheKey);
+    if(it->isEmpty())
+        collectionIt->erase(it);
+    if(collectionIt->isEmpty())
+        keysByObject.erase(collectionIt);
+}
+
+void ResponseCachePrivate::invalidate(const QString &collectionName)
+{
+    ++generations[collectionName];
+    remove(keysByCollection.value(collectionName));
+
+    // Objects of related collections might link to a changed or removed object,
+    // and since their old links are unknown, all of their responses are dropped
+    foreach(const QString &relatedCollection, relatedCollections.value(collectionName)) {
+        ++generations[relatedCollection];
+        remove(keysByCollection.value(relatedCollection));
+
+        typedef QSet<QString> Keys;
+        foreach(const Keys &keys, keysByObject.value(relatedCollection)) {
+            remove(keys);
+        }
+    }
+}
+
+ResponseCache::ResponseCache(QObject *parent) :
+    QObject(parent),
+    d(new ResponseCachePrivate)
+{
+}
+
+ResponseCache::~ResponseCache()
+{
+}
+
+void ResponseCache::addCollection(QDataSuite::AbstractDataAccessObject *collection)
+{
+    QDataSuite::MetaObject metaObject = collection->dataSuiteMetaObject();
+    {
+        QMutexLocker locker(&d->mutex);
+        foreach(const QDataSuite::MetaProperty property, metaObject.relationProperties()) {
+            QString relatedCollection = property.reverseMetaObject().collectionName();
+            if(!d->relatedCollections.value(metaObject.collectionName()).contains(relatedCollection))
+                d->relatedCollections[metaObject.collectionName()].append(relatedCollection);
+        }
+    }
+
+    // Direct connections, so that a response is dropped before the change has been answered
+    connect(collection, SIGNAL(objectInserted(QObject*)),
+            this, SLOT(objectInserted(QObject*)),
+            Qt::DirectConnection);
+    connect(collection, SIGNAL(objectUpdated(QObject*)),
+            this, SLOT(objectChanged(QObject*)),
+            Qt::DirectConnection);
+    connect(collection, SIGNAL(objectRemoved(QObject*)),
+            this, SLOT(objectChanged(QObject*)),
+            Qt::DirectConnection);
+}
+
+bool ResponseCache::response(const QString &path, const QString &format, QByteArray *data, QByteArray *etag) const
+{
+    QMutexLocker locker(&d->mutex);
+
+    ResponseCacheEntry *entry = d->entries.object(ResponseCachePrivate::cacheKey(path, format));
+    if(!entry) {
+        ++d->misses;
+        return false;
+    }
+
+    ++d->hits;
+    *data = entry->data;
+    *etag = entry->etag;
+    return true;
+}
+
+QByteArray ResponseCache::encodedResponse(const QString &path, const QString &format, const QString &encoding) const
+{
+    QMutexLocker locker(&d->mutex);
+
+    ResponseCacheEntry *entry = d->entries.object(ResponseCachePrivate::cacheKey(path, format));
+    if(!entry)
+        return QByteArray();
+
+    return entry->encodedData.value(encoding);
+}
+
+void ResponseCache::insertEncodedResponse(const QString &path,
+                                          const QString &format,
+                                          const QByteArray &etag,
+                                          const QString &encoding,
+                                          const QByteArray &data)
+{
+    QString cacheKey = ResponseCachePrivate::cacheKey(path, format);
+
+    QMutexLocker locker(&d->mutex);
+
+    // The response might have been replaced, while it was compressed
+    ResponseCacheEntry *entry = d->entries.object(cacheKey);
+    if(!entry || entry->etag != etag)
+        return;
+
+    // QCache can not change the cost of an entry, so it is inserted again
+    entry = d->entries.take(cacheKey);
+    entry->encodedData.insert(encoding, data);
+    d->entries.insert(cacheKey, entry, entry->cost());
+}
+
+quint64 ResponseCache::generation(const QDataSuite::AbstractDataAccessObject *collection) const
+{
+    QString collectionName = collection->dataSuiteMetaObject().collectionName();
+
+    QMutexLocker locker(&d->mutex);
+    return d->generations.value(collectionName);
+}
+
+void ResponseCache::insertResponse(quint64 generation,
+                                   const QString &path,
+                                   const QString &format,
+                                   const QDataSuite::AbstractDataAccessObject *collection,
+                                   const QVariant &key,
+                                   const QByteArray &data,
+                                   const QByteArray &etag)
+{
+    QString collectionName = collection->dataSuiteMetaObject().collectionName();
+    QString cacheKey = ResponseCachePrivate::cacheKey(path, format);
+
+    QMutexLocker locker(&d->mutex);
+
+    if(d->generations.value(collectionName) != generation)
+        return;
+
+    QString objectKey;
+    if(key.isValid())
+        objectKey = key.toString();
+
+    ResponseCacheEntry *entry = new ResponseCacheEntry(d.data(), cacheKey, collectionName, objectKey);
+    entry->data = data;
+    entry->etag = etag;
+
+    // QCache deletes entries, which are larger than the whole cache, right away.
+    // A replaced entry removes its key from the indexes, so the key is added afterwards.
+    if(!d->entries.insert(cacheKey, entry, entry->cost()))
+        return;
+
+    if(key.isValid())
+        d->keysByObject[collectionName][objectKey].insert(cacheKey);
+    else
+        d->keysByCollection[collectionName].insert(cacheKey);
+}
+
+int ResponseCache::maximumSize() const
+{
+    QMutexLocker locker(&d->mutex);
+    return d->entries.maxCost();
+}
+
+void ResponseCache::setMaximumSize(int bytes)
+{
+    QMutexLocker locker(&d->mutex);
+    d->entries.setMaxCost(bytes);
+}
+
+int ResponseCache::size() const
+{
+    QMutexLocker locker(&d->mutex);
+    return d->entries.totalCost();
+}
+
+int ResponseCache::count() const
+{
+    QMutexLocker locker(&d->mutex);
+    return d->entries.count();
+}
+
+void ResponseCache::clear()
+{
+    QMutexLocker locker(&d->mutex);
+    d->entries.clear();
+    d->keysByCollection.clear();
+    d->keysByObject.clear();
+}
+
+int ResponseCache::hits() const
+{
+    QMutexLocker locker(&d->mutex);
+    return d->hits;
+}
+
+int ResponseCache::misses() const
+{
+    QMutexLocker locker(&d->mutex);
+    return d->misses;
+}
+
+double ResponseCache::hitRate() const
+{
+    QMutexLocker locker(&d->mutex);
+    int lookups = d->hits + d->misses;
+    if(lookups == 0)
+        return 0.0;
+
+    return double(d->hits) / lookups;
+}
+
+void ResponseCache::resetStatistics()
+{
+    QMutexLocker locker(&d->mutex);
+    d->hits = 0;
+    d->misses = 0;
+}
+
+void ResponseCache::objectChanged(QObject *object)
+{
+    QDataSuite::MetaObject metaObject = QDataSuite::MetaObject::metaObject(object);
+    QString collectionName = metaObject.collectionName();
+    QString key = metaObject.primaryKeyProperty().read(object).toString();
+
+    QMutexLocker locker(&d->mutex);
+    d->remove(d->keysByObject.value(collectionName).value(key));
+    d->invalidate(collectionName);
+}
+
+void ResponseCache::objectInserted(QObject *object)
+{
+    QString collectionName = QDataSuite::MetaObject::metaObject(object).collectionName();
+
+    QMutexLocker locker(&d->mutex);
+    d->invalidate(collectionName);
+}
+
+} // namespace QRestServer
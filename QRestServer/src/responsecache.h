@@ -0,0 +1,76 @@
+#ifndef QRESTSERVER_RESPONSECACHE_H
+#define QRESTSERVER_RESPONSECACHE_H
+
+#include <QtCore/QObject>
+
+#include <QtCore/QExplicitlySharedDataPointer>
+#include <QtCore/QVariant>
+
+namespace QDataSuite {
+class AbstractDataAccessObject;
+}
+
+namespace QRestServer {
+
+// Caches serialized responses by path and format, along with their compressed variants.
+// Responses of an object are dropped, when the object is updated or removed.
+// Responses of a collection (including its pages) are dropped with every change to the collection.
+// A change to a collection also drops all responses of the collections related to it,
+// because their objects link to the changed objects.
+class ResponseCachePrivate;
+class ResponseCache : public QObject
+{
+    Q_OBJECT
+public:
+    explicit ResponseCache(QObject *parent = 0);
+    ~ResponseCache();
+
+    void addCollection(QDataSuite::AbstractDataAccessObject *collection);
+
+    bool response(const QString &path, const QString &format, QByteArray *data, QByteArray *etag) const;
+    // Returns an empty array, if the response has not been cached in this content coding yet
+    QByteArray encodedResponse(const QString &path, const QString &format, const QString &encoding) const;
+    // Adds a compressed variant to the response with the given tag
+    void insertEncodedResponse(const QString &path,
+                               const QString &format,
+                               const QByteArray &etag,
+                               const QString &encoding,
+                               const QByteArray &data);
+
+    // Take the generation before reading from the collection. Responses, which have been
+    // built from objects changed in the meantime, are not inserted.
+    quint64 generation(const QDataSuite::AbstractDataAccessObject *collection) const;
+
+    // Pass an invalid key for responses of the collection itself
+    void insertResponse(quint64 generation,
+                        const QString &path,
+                        const QString &format,
+                        const QDataSuite::AbstractDataAccessObject *collection,
+                        const QVariant &key,
+                        const QByteArray &data,
+                        const QByteArray &etag);
+
+    // In bytes. 0 disables the cache.
+    int maximumSize() const;
+    void setMaximumSize(int bytes);
+    int size() const;
+    int count() const;
+    void clear();
+
+    int hits() const;
+    int misses() const;
+    double hitRate() const;
+    void resetStatistics();
+
+private Q_SLOTS:
+    void objectChanged(QObject *object);
+    void objectInserted(QObject *object);
+
+private:
+    QExplicitlySharedDataPointer<ResponseCachePrivate> d;
+    Q_DISABLE_COPY(ResponseCache)
+};
+
+} // namespace QRestServer
+
+#endif // QRESTSERVER_RESPONSECACHE_H
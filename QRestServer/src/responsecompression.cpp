@@ -0,0 +1,182 @@
+#include "responsecompression.h"
+
+#include "deflatestream.h"
+
+#include <QMutex>
+#include <QStringList>
+
+#include <zlib.h>
+
+namespace QRestServer {
+
+class ResponseCompressionPrivate : public QSharedData
+{
+public:
+    ResponseCompressionPrivate() :
+        QSharedData(),
+        threshold(1024),
+        level(Z_DEFAULT_COMPRESSION),
+        compressedResponses(0),
+        uncompressedBytes(0),
+        compressedBytes(0),
+        compressionTime(0)
+    {}
+
+    int threshold;
+    int level;
+
+    // Responses are compressed by all workers
+    mutable QMutex mutex;
+    int compressedResponses;
+    qint64 uncompressedBytes;
+    qint64 compressedBytes;
+    qint64 compressionTime;
+};
+
+ResponseCompression::ResponseCompression(QObject *parent) :
+    QObject(parent),
+    d(new ResponseCompressionPrivate)
+{
+}
+
+ResponseCompression::~ResponseCompression()
+{
+}
+
+int ResponseCompression::threshold() const
+{
+    return d->threshold;
+}
+
+void ResponseCompression::setThreshold(int bytes)
+{
+    d->threshold = bytes;
+}
+
+int ResponseCompression::level() const
+{
+    return d->level;
+}
+
+void ResponseCompression::setLevel(int level)
+{
+    d->level = qBound(1, level, 9);
+}
+
+ResponseCompression::Encoding ResponseCompression::encodingForRequest(const QString &acceptEncoding) const
+{
+    if(d->threshold < 0)
+        return Identity;
+
+    // e.g. "gzip, deflate;q=0.5" or "*". Codings, which are not listed, get the quality of "*".
+    double gzipQuality = -1;
+    double deflateQuality = -1;
+    double wildcardQuality = 0;
+    foreach(const QString &part, acceptEncoding.split(',', QString::SkipEmptyParts)) {
+        QStringList parameters = part.split(';');
+        QString coding = parameters.takeFirst().trimmed().toLower();
+
+        double quality = 1.0;
+        foreach(const QString &parameter, parameters) {
+            QString trimmedParameter = parameter.trimmed();
+            if(trimmedParameter.startsWith(QLatin1String("q=")))
+                quality = trimmedParameter.mid(2).toDouble();
+        }
+
+        if(coding == QLatin1String("gzip") || coding == QLatin1String("x-gzip"))
+            gzipQuality = quality;
+        else if(coding == QLatin1String("deflate"))
+            deflateQuality = quality;
+        else if(coding == QLatin1String("*"))
+            wildcardQuality = quality;
+    }
+
+    if(gzipQuality < 0)
+        gzipQuality = wildcardQuality;
+    if(deflateQuality < 0)
+        deflateQuality = wildcardQuality;
+
+    if(gzipQuality <= 0 && deflateQuality <= 0)
+        return Identity;
+
+    // gzip wins ties, because some clients expect raw deflate data for "deflate"
+    return gzipQuality >= deflateQuality ? Gzip : Deflate;
+}
+
+QString ResponseCompression::encodingName(ResponseCompression::Encoding encoding)
+{
+    switch(encoding) {
+    case Gzip:
+        return QLatin1String("gzip");
+    case Deflate:
+        return QLatin1String("deflate");
+    default:
+        return QLatin1String("identity");
+    }
+}
+
+QByteArray ResponseCompression::compress(const QByteArray &data, ResponseCompression::Encoding encoding)
+{
+    DeflateStream stream(encoding, d->level);
+    if(!stream.isValid())
+        return data;
+
+    QByteArray result = stream.compress(data.constData(), data.size());
+    result.append(stream.finish());
+
+    recordResponse(stream.bytesIn(), stream.bytesOut(), stream.elapsed());
+    return result;
+}
+
+void ResponseCompression::recordResponse(qint64 uncompressedBytes, qint64 compressedBytes, qint64 nsecs)
+{
+    QMutexLocker locker(&d->mutex);
+    ++d->compressedResponses;
+    d->uncompressedBytes += uncompressedBytes;
+    d->compressedBytes += compressedBytes;
+    d->compressionTime += nsecs;
+}
+
+int ResponseCompression::compressedResponses() const
+{
+    QMutexLocker locker(&d->mutex);
+    return d->compressedResponses;
+}
+
+qint64 ResponseCompression::uncompressedBytes() const
+{
+    QMutexLocker locker(&d->mutex);
+    return d->uncompressedBytes;
+}
+
+qint64 ResponseCompression::compressedBytes() const
+{
+    QMutexLocker locker(&d->mutex);
+    return d->compressedBytes;
+}
+
+double ResponseCompression::compressionRatio() const
+{
+    QMutexLocker locker(&d->mutex);
+    if(d->uncompressedBytes == 0)
+        return 1.0;
+
+    return double(d->compressedBytes) / d->uncompressedBytes;
+}
+
+qint64 ResponseCompression::compressionTime() const
+{
+    QMutexLocker locker(&d->mutex);
+    return d->compressionTime;
+}
+
+void ResponseCompression::resetStatistics()
+{
+    QMutexLocker locker(&d->mutex);
+    d->compressedResponses = 0;
+    d->uncompressedBytes = 0;
+    d->compressedBytes = 0;
+    d->compressionTime = 0;
+}
+
+} // namespace QRestServer
@@ -0,0 +1,59 @@
+#ifndef QRESTSERVER_RESPONSECOMPRESSION_H
+#define QRESTSERVER_RESPONSECOMPRESSION_H
+
+#include <QtCore/QObject>
+
+#include <QtCore/QExplicitlySharedDataPointer>
+
+namespace QRestServer {
+
+// Negotiates the Content-Encoding of responses and keeps statistics about compressed responses.
+// Responses smaller than the threshold are always sent uncompressed.
+class ResponseCompressionPrivate;
+class ResponseCompression : public QObject
+{
+    Q_OBJECT
+public:
+    enum Encoding {
+        Identity,
+        Gzip,
+        Deflate
+    };
+
+    explicit ResponseCompression(QObject *parent = 0);
+    ~ResponseCompression();
+
+    // In bytes. A negative threshold disables compression.
+    int threshold() const;
+    void setThreshold(int bytes);
+
+    // The zlib level from 1 (fastest) to 9 (smallest)
+    int level() const;
+    void setLevel(int level);
+
+    // Picks an encoding for the value of an Accept-Encoding header
+    Encoding encodingForRequest(const QString &acceptEncoding) const;
+    static QString encodingName(Encoding encoding);
+
+    // Compresses a complete response
+    QByteArray compress(const QByteArray &data, Encoding encoding);
+
+    void recordResponse(qint64 uncompressedBytes, qint64 compressedBytes, qint64 nsecs);
+
+    int compressedResponses() const;
+    qint64 uncompressedBytes() const;
+    qint64 compressedBytes() const;
+    // Compressed size relative to the uncompressed size
+    double compressionRatio() const;
+    // In nanoseconds
+    qint64 compressionTime() const;
+    void resetStatistics();
+
+private:
+    QExplicitlySharedDataPointer<ResponseCompressionPrivate> d;
+    Q_DISABLE_COPY(ResponseCompression)
+};
+
+} // namespace QRestServer
+
+#endif // QRESTSERVER_RESPONSECOMPRESSION_H
@@ -0,0 +1,270 @@
+#include "responsewriter.h"
+
+#include <qhttpresponse.h>
+
+#include <QMutex>
+#include <QPair>
+#include <QPointer>
+#include <QThread>
+#include <QWaitCondition>
+
+namespace QRestServer {
+
+class ResponseWriterPrivate : public QSharedData
+{
+public:
+    ResponseWriterPrivate() :
+        QSharedData(),
+        held(false),
+        ended(false),
+        statusCode(0),
+        maximumQueuedBytes(DefaultMaximumQueuedBytes),
+        inFlightBytes(0),
+        unsentBytes(0),
+        drainSignal(false),
+        gone(false)
+    {}
+
+    static const qint64 DefaultMaximumQueuedBytes = 256 * 1024;
+
+    qint64 queuedBytes() const { return inFlightBytes + data.size() + unsentBytes; }
+    void written(qint64 bytes);
+
+    QPointer<QHttpResponse> response;
+    bool held;
+    bool ended;
+
+    // Buffered while held
+    QList<QPair<QString, QString> > headers;
+    int statusCode;
+    QByteArray data;
+
+    // Guards the accounting of the queued bytes, which producers in other threads wait on
+    mutable QMutex mutex;
+    QWaitCondition drained;
+    qint64 maximumQueuedBytes;
+    // Queued from other threads, but not yet handled by the thread of the writer
+    qint64 inFlightBytes;
+    // Written into the response, but not yet sent to the client
+    qint64 unsentBytes;
+    // Whether the response tells, when its socket has sent everything
+    bool drainSignal;
+    bool gone;
+};
+
+// Called with the mutex locked
+void ResponseWriterPrivate::written(qint64 bytes)
+{
+    // Without the signal of the response, the bytes count as sent, once the response has them
+    if(drainSignal)
+        unsentBytes += bytes;
+    else
+        drained.wakeAll();
+}
+
+ResponseWriter::ResponseWriter(QHttpResponse *response, QObject *parent) :
+    QObject(parent),
+    d(new ResponseWriterPrivate)
+{
+    d->response = response;
+
+    if(response) {
+        d->drainSignal = connect(response, SIGNAL(allBytesWritten()), this, SLOT(responseDrained()));
+        connect(response, SIGNAL(destroyed()), this, SLOT(responseDestroyed()));
+    }
+}
+
+ResponseWriter::~ResponseWriter()
+{
+    responseDestroyed();
+}
+
+bool ResponseWriter::isHeld() const
+{
+    return d->held;
+}
+
+void ResponseWriter::hold()
+{
+    QMutexLocker locker(&d->mutex);
+    d->held = true;
+}
+
+void ResponseWriter::release()
+{
+    if(!d->held)
+        return;
+
+    QMutexLocker locker(&d->mutex);
+    d->held = false;
+    QByteArray data = d->data;
+    d->data.clear();
+    locker.unlock();
+
+    if(d->response) {
+        typedef QPair<QString, QString> Header;
+        foreach(const Header &header, d->headers) {
+            d->response->setHeader(header.first, header.second);
+        }
+
+        if(d->statusCode != 0)
+            d->response->writeHead(d->statusCode);
+
+        if(!data.isEmpty()) {
+            d->response->write(data);
+            locker.relock();
+            d->written(data.size());
+            locker.unlock();
+        }
+    }
+
+    d->headers.clear();
+    d->statusCode = 0;
+
+    if(d->ended) {
+        d->ended = false;
+        end();
+    }
+}
+
+bool ResponseWriter::isEnded() const
+{
+    return d->ended;
+}
+
+qint64 ResponseWriter::maximumQueuedBytes() const
+{
+    QMutexLocker locker(&d->mutex);
+    return d->maximumQueuedBytes;
+}
+
+void ResponseWriter::setMaximumQueuedBytes(qint64 bytes)
+{
+    QMutexLocker locker(&d->mutex);
+    d->maximumQueuedBytes = bytes;
+    d->drained.wakeAll();
+}
+
+qint64 ResponseWriter::queuedBytes() const
+{
+    QMutexLocker locker(&d->mutex);
+    return d->queuedBytes();
+}
+
+void ResponseWriter::waitForCapacity()
+{
+    if(QThread::currentThread() == thread())
+        return;
+
+    QMutexLocker locker(&d->mutex);
+    while(!d->gone && d->queuedBytes() > d->maximumQueuedBytes) {
+        d->drained.wait(&d->mutex);
+    }
+}
+
+void ResponseWriter::setHeader(const QString &field, const QString &value)
+{
+    if(QThread::currentThread() != thread()) {
+        QMetaObject::invokeMethod(this, "setHeader", Qt::QueuedConnection,
+                                  Q_ARG(QString, field),
+                                  Q_ARG(QString, value));
+        return;
+    }
+
+    if(d->held)
+        d->headers.append(qMakePair(field, value));
+    else if(d->response)
+        d->response->setHeader(field, value);
+}
+
+void ResponseWriter::writeHead(int statusCode)
+{
+    if(QThread::currentThread() != thread()) {
+        QMetaObject::invokeMethod(this, "writeHead", Qt::QueuedConnection,
+                                  Q_ARG(int, statusCode));
+        return;
+    }
+
+    if(d->held)
+        d->statusCode = statusCode;
+    else if(d->response)
+        d->response->writeHead(statusCode);
+}
+
+void ResponseWriter::write(const QByteArray &data)
+{
+    if(QThread::currentThread() != thread()) {
+        QMutexLocker locker(&d->mutex);
+        if(d->gone)
+            return;
+
+        d->inFlightBytes += data.size();
+        QMetaObject::invokeMethod(this, "writeQueued", Qt::QueuedConnection,
+                                  Q_ARG(QByteArray, data));
+        return;
+    }
+
+    QMutexLocker locker(&d->mutex);
+    if(d->held) {
+        d->data.append(data);
+        return;
+    }
+    locker.unlock();
+
+    // Not locked, because the response may report its progress right away
+    if(d->response) {
+        d->response->write(data);
+        locker.relock();
+        d->written(data.size());
+    }
+}
+
+void ResponseWriter::writeQueued(const QByteArray &data)
+{
+    {
+        QMutexLocker locker(&d->mutex);
+        d->inFlightBytes -= data.size();
+    }
+
+    write(data);
+
+    QMutexLocker locker(&d->mutex);
+    d->drained.wakeAll();
+}
+
+void ResponseWriter::responseDrained()
+{
+    QMutexLocker locker(&d->mutex);
+    d->unsentBytes = 0;
+    d->drained.wakeAll();
+}
+
+void ResponseWriter::responseDestroyed()
+{
+    // Nobody is going to send anything anymore. Producers must not wait for that.
+    QMutexLocker locker(&d->mutex);
+    d->gone = true;
+    d->data.clear();
+    d->inFlightBytes = 0;
+    d->unsentBytes = 0;
+    d->drained.wakeAll();
+}
+
+void ResponseWriter::end()
+{
+    if(QThread::currentThread() != thread()) {
+        QMetaObject::invokeMethod(this, "end", Qt::QueuedConnection);
+        return;
+    }
+
+    d->ended = true;
+    if(d->held)
+        return;
+
+    if(d->response)
+        d->response->end();
+
+    emit ended();
+}
+
+} // namespace QRestServer
@@ -0,0 +1,64 @@
+#ifndef QRESTSERVER_RESPONSEWRITER_H
+#define QRESTSERVER_RESPONSEWRITER_H
+
+#include <QtCore/QObject>
+
+#include <QtCore/QExplicitlySharedDataPointer>
+
+class QHttpResponse;
+
+namespace QRestServer {
+
+// Writes into a QHttpResponse from any thread.
+// Calls from other threads are queued to the thread of the writer,
+// which has to be the thread of the response. Calls after the response
+// has been destroyed (e.g. because the client went away) are ignored.
+//
+// A held writer buffers everything until it is released. This keeps the
+// responses to pipelined requests in the order of the requests.
+//
+// Producers in other threads call waitForCapacity() between writes. It blocks, while more than
+// maximumQueuedBytes() are queued, buffered or not yet sent to the client, so that a slow client
+// or a held writer does not make the producer keep the whole response in memory.
+class ResponseWriterPrivate;
+class ResponseWriter : public QObject
+{
+    Q_OBJECT
+public:
+    explicit ResponseWriter(QHttpResponse *response, QObject *parent = 0);
+    ~ResponseWriter();
+
+    bool isHeld() const;
+    void hold();
+    void release();
+
+    bool isEnded() const;
+
+    qint64 maximumQueuedBytes() const;
+    void setMaximumQueuedBytes(qint64 bytes);
+    qint64 queuedBytes() const;
+    // Does nothing in the thread of the writer, which would never drain the queue while waiting
+    void waitForCapacity();
+
+public Q_SLOTS:
+    void setHeader(const QString &field, const QString &value);
+    void writeHead(int statusCode);
+    void write(const QByteArray &data);
+    void end();
+
+Q_SIGNALS:
+    void ended();
+
+private Q_SLOTS:
+    void writeQueued(const QByteArray &data);
+    void responseDrained();
+    void responseDestroyed();
+
+private:
+    QExplicitlySharedDataPointer<ResponseWriterPrivate> d;
+    Q_DISABLE_COPY(ResponseWriter)
+};
+
+} // namespace QRestServer
+
+#endif // QRESTSERVER_RESPONSEWRITER_H
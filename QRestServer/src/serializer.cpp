@@ -1,10 +1,18 @@
 #include "serializer.h"
 
+#include <QDataSuite/abstractdataaccessobject.h>
 #include <QDataSuite/error.h>
 #include <QDataSuite/metaproperty.h>
 #include <QDataSuite/metaobject.h>
 
 #include <QHash>
+#include <QPair>
+#include <QStringList>
+#include <QThreadStorage>
+#include <QIODevice>
+#include <QUrl>
+
+#include <algorithm>
 
 namespace QRestServer {
 
@@ -15,7 +23,8 @@ public:
         QSharedData()
     {}
 
-    mutable QDataSuite::Error lastError;
+    // Each instance is shared by all threads serving requests
+    mutable QThreadStorage<QDataSuite::Error> lastError;
     QString format;
     QString contentType;
 
@@ -47,12 +56,12 @@ QString Serializer::format() const
 
 QDataSuite::Error Serializer::lastError() const
 {
-    return d->lastError;
+    return d->lastError.localData();
 }
 
 void Serializer::setLastError(const QDataSuite::Error &error) const
 {
-    d->lastError = error;
+    d->lastError.setLocalData(error);
 }
 
 void Serializer::resetLastError() const
@@ -60,20 +69,64 @@ void Serializer::resetLastError() const
     setLastError(QDataSuite::Error());
 }
 
+QList<QObject *> Serializer::readNextPage(const QDataSuite::AbstractDataAccessObject *collection,
+                                         const QList<QObject *> &previousPage) const
+{
+    QList<QObject *> page;
+    if(previousPage.isEmpty()) {
+        page = collection->readObjects(0, StreamPageSize);
+    }
+    else {
+        QDataSuite::MetaProperty keyMetaProperty = collection->dataSuiteMetaObject().primaryKeyProperty();
+        page = collection->readObjectsAfter(keyMetaProperty.read(previousPage.last()), StreamPageSize);
+    }
+
+    if(collection->lastError().isValid()) {
+        setLastError(collection->lastError());
+        return QList<QObject *>();
+    }
+
+    return page;
+}
+
+bool Serializer::serialize(const QDataSuite::AbstractDataAccessObject *collection,
+                           Server *server,
+                           QIODevice *device) const
+{
+    QByteArray data = serialize(collection, server);
+    if(lastError().isValid())
+        return false;
+
+    device->write(data);
+    return true;
+}
+
+bool Serializer::serialize(const QDataSuite::AbstractDataAccessObject *collection,
+                           const QList<QObject *> &objects,
+                           const QMap<QString, QUrl> &links,
+                           Server *server,
+                           QIODevice *device) const
+{
+    Q_UNUSED(collection);
+    Q_UNUSED(objects);
+    Q_UNUSED(links);
+    Q_UNUSED(server);
+    Q_UNUSED(device);
+
+    setLastError(QDataSuite::Error(QString("The format '%1' does not support pages.").arg(format()),
+                                   QDataSuite::Error::SerializerError));
+    return false;
+}
+
 QVariantMap Serializer::objectToVariant(const QObject *object)
 {
     QVariantMap result;
     const QDataSuite::MetaObject metaObject = QDataSuite::MetaObject::metaObject(object);
-    int count = metaObject.propertyCount();
-    for (int i = 1; i < count; ++i) {
-        QDataSuite::MetaProperty metaProperty(metaObject.property(i), metaObject);
-
-        if (!metaProperty.isReadable()
-                || !metaProperty.isStored()
-                || metaProperty.isRelationProperty())
+    foreach(const QDataSuite::MetaProperty metaProperty, metaObject.simpleProperties()) {
+        if (!metaProperty.isReadable())
             continue;
 
-        result[QLatin1String(metaProperty.name())] = object->property(metaProperty.name());
+        result[QLatin1String(metaProperty.name())] = metaProperty.read(object);
     }
 
     QList<QByteArray> dynamicPropertyNames = object->dynamicPropertyNames();
@@ -89,6 +142,61 @@ Serializer *Serializer::forFormat(const QString &format)
     return SerializerPrivate::serializers.value(format);
 }
 
+static bool qualityGreaterThan(const QPair<double, QString> &left, const QPair<double, QString> &right)
+{
+    return left.first > right.first;
+}
+
+Serializer *Serializer::forContentType(const QString &accept)
+{
+    // e.g. "application/cbor, application/hal+json;q=0.5, */*;q=0.1"
+    QList<QPair<double, QString> > mediaRanges;
+    foreach(const QString &part, accept.split(',', QString::SkipEmptyParts)) {
+        QStringList parameters = part.split(';');
+        QString mediaRange = parameters.takeFirst().trimmed().toLower();
+
+        double quality = 1.0;
+        foreach(const QString &parameter, parameters) {
+            QString trimmedParameter = parameter.trimmed();
+            if(trimmedParameter.startsWith(QLatin1String("q=")))
+                quality = trimmedParameter.mid(2).toDouble();
+        }
+
+        if(quality > 0)
+            mediaRanges.append(qMakePair(quality, mediaRange));
+    }
+
+    Serializer *defaultSerializer = forFormat(QString());
+    if(mediaRanges.isEmpty())
+        return defaultSerializer;
+
+    std::stable_sort(mediaRanges.begin(), mediaRanges.end(), qualityGreaterThan);
+
+    typedef QPair<double, QString> MediaRange;
+    foreach(const MediaRange &mediaRange, mediaRanges) {
+        if(mediaRange.second == QLatin1String("*/*"))
+            return defaultSerializer;
+
+        foreach(Serializer *serializer, SerializerPrivate::serializers) {
+            if(serializer->contentType() == mediaRange.second)
+                return serializer;
+        }
+
+        if(mediaRange.second.endsWith(QLatin1String("/*"))) {
+            QString type = mediaRange.second.left(mediaRange.second.size() - 1);
+            if(defaultSerializer && defaultSerializer->contentType().startsWith(type))
+                return defaultSerializer;
+
+            foreach(Serializer *serializer, SerializerPrivate::serializers) {
+                if(serializer->contentType().startsWith(type))
+                    return serializer;
+            }
+        }
+    }
+
+    return 0;
+}
+
 void Serializer::registerSerializer(Serializer *serializer)
 {
     if(!SerializerPrivate::serializers.contains(QString()))
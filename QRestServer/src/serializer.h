@@ -1,12 +1,14 @@
 #ifndef QRESTSERVER_SERIALIZER_H
 #define QRESTSERVER_SERIALIZER_H
 
-#include <QtCore/QSharedDataPointer>
+#include <QtCore/QExplicitlySharedDataPointer>
 #include <QtCore/QVariantMap>
 
 class QByteArray;
+class QIODevice;
 class QObject;
 class QString;
+class QUrl;
 
 namespace QDataSuite {
 class Error;
@@ -28,6 +30,18 @@ public:
                                  Server *server) const = 0;
     virtual QByteArray serialize(const QDataSuite::Error &error) const = 0;
 
+    // Writes the collection into the device. Serializers, which can produce their
+    // output piece by piece, should override this to avoid building the whole document.
+    virtual bool serialize(const QDataSuite::AbstractDataAccessObject *collection,
+                           Server *server,
+                           QIODevice *device) const;
+    // Writes a page of the collection with additional links (e.g. "next" and "prev")
+    virtual bool serialize(const QDataSuite::AbstractDataAccessObject *collection,
+                           const QList<QObject *> &objects,
+                           const QMap<QString, QUrl> &links,
+                           Server *server,
+                           QIODevice *device) const;
+
     QString contentType() const;
     QString format() const;
     QDataSuite::Error lastError() const;
@@ -35,6 +49,8 @@ public:
     static QVariantMap objectToVariant(const QObject *object);
 
     static Serializer *forFormat(const QString &format);
+    // Picks the most acceptable serializer for the value of an Accept header, or 0
+    static Serializer *forContentType(const QString &accept);
     static void registerSerializer(Serializer *serializer);
     static void setDefaultSerializer(Serializer *serializer);
 
@@ -44,8 +60,15 @@ protected:
     void setLastError(const QDataSuite::Error &error) const;
     void resetLastError() const;
 
+    // Streamed collections are read page by page in primary key order, so that only
+    // one page of objects is read at a time. Returns the page after previousPage,
+    // or the first page, if previousPage is empty.
+    QList<QObject *> readNextPage(const QDataSuite::AbstractDataAccessObject *collection,
+                                  const QList<QObject *> &previousPage) const;
+    static const int StreamPageSize = 100;
+
 private:
-    QSharedDataPointer<SerializerPrivate> d;
+    QExplicitlySharedDataPointer<SerializerPrivate> d;
 };
 
 } // namespace QRestServer
@@ -1,18 +1,29 @@
 #include "server.h"
 
 #include "linkhelper.h"
+#include "connectionmanager.h"
+#include "etagcache.h"
+#include "responsecache.h"
+#include "responsecompression.h"
 #include "responder.h"
 #include "serializer.h"
 #include "haljsonserializer.h"
 #include "haljsonparser.h"
+#include "cborserializer.h"
+#include "cborparser.h"
+#include "messagepackserializer.h"
+#include "messagepackparser.h"
 
 #include <QDataSuite/abstractdataaccessobject.h>
 #include <QDataSuite/metaobject.h>
+#include <QDataSuite/taskscope.h>
 
 #include <qhttpserver.h>
 #include <qhttprequest.h>
 #include <qhttpresponse.h>
 
+#include <QAtomicInt>
+#include <QThreadPool>
 #include <QRegExp>
 #include <QStringList>
 #include <QDebug>
@@ -24,7 +35,14 @@ class ServerPrivate : public QSharedData
 public:
     ServerPrivate() :
         QSharedData(),
-        httpServer(0)
+        httpServer(0),
+        connectionManager(0),
+        etagCache(0),
+        responseCache(0),
+        responseCompression(0),
+        workerPool(0),
+        workerThreadCount(0),
+        maximumQueueDepth(128)
     {
     }
 
@@ -34,6 +52,20 @@ public:
     LinkHelper *linkHelper;
     HalJsonSerializer *serializer;
     HalJsonParser *parser;
+    CborSerializer *cborSerializer;
+    CborParser *cborParser;
+    MessagePackSerializer *messagePackSerializer;
+    MessagePackParser *messagePackParser;
+
+    ConnectionManager *connectionManager;
+    ETagCache *etagCache;
+    ResponseCache *responseCache;
+    ResponseCompression *responseCompression;
+
+    QThreadPool *workerPool;
+    int workerThreadCount;
+    int maximumQueueDepth;
+    QAtomicInt queueDepth;
 
     Server *q;
 };
@@ -54,11 +86,32 @@ Server::Server(QObject *parent) :
     d->parser = new HalJsonParser;
     Parser::registerParser(d->parser);
 
+    // Compact binary formats for clients, which send a matching Accept or Content-Type header
+    d->cborSerializer = new CborSerializer;
+    Serializer::registerSerializer(d->cborSerializer);
+    d->cborParser = new CborParser;
+    Parser::registerParser(d->cborParser);
+
+    d->messagePackSerializer = new MessagePackSerializer;
+    Serializer::registerSerializer(d->messagePackSerializer);
+    d->messagePackParser = new MessagePackParser;
+    Parser::registerParser(d->messagePackParser);
+
     d->linkHelper = new LinkHelper(this);
+    d->connectionManager = new ConnectionManager(d->httpServer, this);
+    d->etagCache = new ETagCache(this);
+    d->responseCache = new ResponseCache(this);
+    d->responseCompression = new ResponseCompression(this);
+
+    // Worker threads are never expired, so that each one keeps its own database connection
+    d->workerPool = new QThreadPool(this);
+    d->workerPool->setExpiryTimeout(-1);
+    d->workerPool->setMaxThreadCount(1);
 }
 
 Server::~Server()
 {
+    QDataSuite::TaskScope::reserveThreads(-d->workerThreadCount);
 }
 
 void Server::listen(uint port)
@@ -66,6 +119,7 @@ void Server::listen(uint port)
     Q_ASSERT(port > 0);
     d->baseUrl.setPort(port);
     d->httpServer->listen(QHostAddress::Any, port);
+    d->connectionManager->startTracking();
 }
 
 void Server::setBaseUrl(const QUrl &baseUrl)
@@ -91,6 +145,8 @@ void Server::addCollection(QDataSuite::AbstractDataAccessObject *collection)
     Q_ASSERT(collection);
 
     d->collections.insert(collection->dataSuiteMetaObject().collectionName(), collection);
+    d->etagCache->addCollection(collection);
+    d->responseCache->addCollection(collection);
 }
 
 QList<QDataSuite::AbstractDataAccessObject *> Server::collections() const
@@ -108,46 +164,107 @@ LinkHelper *Server::linkHelper() const
     return d->linkHelper;
 }
 
-void Server::dispatchRequest(QHttpRequest *req, QHttpResponse *resp)
+ResponseCache *Server::responseCache() const
 {
-    QDataSuite::AbstractDataAccessObject *collection = d->linkHelper->resolveCollectionPath(req->path());
+    return d->responseCache;
+}
 
-    if (!collection) {
-        // No such collection
-        Responder::serveError(resp,
-                              QString("Collection not found: %1").arg(req->path()).toLatin1(),
-                              QHttpResponse::STATUS_NOT_FOUND,
-                              formatFromRequest(req));
-        return;
-    }
+ResponseCompression *Server::responseCompression() const
+{
+    return d->responseCompression;
+}
 
-    QVariant objectKey = d->linkHelper->objectKey(req->path());
+void Server::setWorkerThreadCount(int count)
+{
+    Q_ASSERT(count >= 0);
+    d->workerPool->setMaxThreadCount(qMax(1, count));
 
-    if (objectKey.isNull()) {
-        // Collection requested
-        new Responder(req, resp, this, collection);
-        return;
-    }
+    // Each worker needs its own database connection
+    QDataSuite::TaskScope::reserveThreads(count - d->workerThreadCount);
+    d->workerThreadCount = count;
+}
 
-    QObject *object = collection->readObject(objectKey);
+int Server::workerThreadCount() const
+{
+    return d->workerThreadCount;
+}
 
-    if (!object) {
-        // No such object
-        Responder::serveError(resp,
-                              QString("Object not found: %1").arg(req->path()).toLatin1(),
-                              QHttpResponse::STATUS_NOT_FOUND,
-                              formatFromRequest(req));
-        return;
-    }
+void Server::setMaximumQueueDepth(int depth)
+{
+    Q_ASSERT(depth > 0);
+    d->maximumQueueDepth = depth;
+}
+
+int Server::maximumQueueDepth() const
+{
+    return d->maximumQueueDepth;
+}
+
+int Server::queueDepth() const
+{
+    return d->queueDepth.load();
+}
+
+void Server::setIdleTimeout(int msecs)
+{
+    d->connectionManager->setIdleTimeout(msecs);
+}
+
+int Server::idleTimeout() const
+{
+    return d->connectionManager->idleTimeout();
+}
+
+QThreadPool *Server::workerPool() const
+{
+    return d->workerPool;
+}
+
+ConnectionManager *Server::connectionManager() const
+{
+    return d->connectionManager;
+}
+
+ETagCache *Server::etagCache() const
+{
+    return d->etagCache;
+}
 
-    // Object requested
-    new Responder(req, resp, this, collection, object);
+bool Server::acquireQueueSlot()
+{
+    if (d->queueDepth.fetchAndAddOrdered(1) < d->maximumQueueDepth)
+        return true;
+
+    d->queueDepth.fetchAndAddOrdered(-1);
+    return false;
+}
+
+void Server::releaseQueueSlot()
+{
+    d->queueDepth.fetchAndAddOrdered(-1);
+}
+
+void Server::dispatchRequest(QHttpRequest *req, QHttpResponse *resp)
+{
+    QDataSuite::AbstractDataAccessObject *collection = d->linkHelper->resolveCollectionPath(req->path());
+
+    // Even errors are served by a responder, so that responses to pipelined requests stay in order.
+    // The object is read by the responder, which might run on a worker thread.
+    QVariant objectKey;
+    if (collection)
+        objectKey = d->linkHelper->objectKey(req->path());
+
+    new Responder(req, resp, this, collection, objectKey);
 }
 
 QString Server::formatFromRequest(QHttpRequest *req)
 {
-    Q_UNUSED(req)
-    return QString();
+    // Clients, which accept nothing we know, still get the default format
+    Serializer *serializer = Serializer::forContentType(req->header(HttpHeaderAccept));
+    if (!serializer)
+        return QString();
+
+    return serializer->format();
 }
 
 } // namespace QRestServer
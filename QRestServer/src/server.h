@@ -6,10 +6,21 @@
 #include <QtCore/QSharedDataPointer>
 
 #define HttpHeaderContentLength "Content-Length"
+#define HttpHeaderTransferEncoding "Transfer-Encoding"
+#define HttpHeaderKeepAlive "Keep-Alive"
+#define HttpHeaderContentType "Content-Type"
+#define HttpHeaderAccept "Accept"
+#define HttpHeaderVary "Vary"
+#define HttpHeaderAcceptEncoding "Accept-Encoding"
+#define HttpHeaderContentEncoding "Content-Encoding"
+#define HttpHeaderETag "ETag"
+#define HttpHeaderIfMatch "If-Match"
+#define HttpHeaderIfNoneMatch "If-None-Match"
 #define HttpStatusCode "httpStatusCode"
 
 class QHttpRequest;
 class QHttpResponse;
+class QThreadPool;
 
 namespace QDataSuite {
 class Error;
@@ -19,6 +30,10 @@ class AbstractDataAccessObject;
 namespace QRestServer {
 
 class LinkHelper;
+class ConnectionManager;
+class ETagCache;
+class ResponseCache;
+class ResponseCompression;
 
 class ServerPrivate;
 class Server : public QObject
@@ -38,6 +53,26 @@ public:
     QDataSuite::AbstractDataAccessObject *collection(const QString &name);
 
     LinkHelper *linkHelper() const;
+    ResponseCache *responseCache() const;
+    ResponseCompression *responseCompression() const;
+
+    // With worker threads, requests are resolved, read and serialized on a thread pool,
+    // while the connections are still handled by the thread of the server.
+    // The collections have to be usable from several threads then.
+    // A count of 0 (the default) serves all requests on the thread of the server.
+    // The workers are reserved with QDataSuite::TaskScope, so that connection pools grow accordingly.
+    void setWorkerThreadCount(int count);
+    int workerThreadCount() const;
+
+    // Requests, which do not fit into the queue of the workers, are answered with 503
+    void setMaximumQueueDepth(int depth);
+    int maximumQueueDepth() const;
+    int queueDepth() const;
+
+    // Persistent connections without pending responses are closed after this many milliseconds.
+    // 0 keeps them open until the client closes them.
+    void setIdleTimeout(int msecs);
+    int idleTimeout() const;
 
     static QString formatFromRequest(QHttpRequest *req);
 
@@ -45,7 +80,14 @@ private Q_SLOTS:
     void dispatchRequest(QHttpRequest *req, QHttpResponse *resp);
 
 private:
+    friend class Responder;
     QSharedDataPointer<ServerPrivate> d;
+
+    QThreadPool *workerPool() const;
+    ConnectionManager *connectionManager() const;
+    ETagCache *etagCache() const;
+    bool acquireQueueSlot();
+    void releaseQueueSlot();
     Q_DISABLE_COPY(Server)
 };
 
@@ -12,7 +12,7 @@ include($$QHAL_PATH/QHal.pri)
 TARGET          = $$QRESTSERVER_TARGET
 VERSION         = $$QRESTSERVER_VERSION
 TEMPLATE        = lib
-QT              += network
+QT              += network concurrent
 QT              -= gui
 CONFIG          += static c++11
 QMAKE_CXXFLAGS  += $$QDATASUITE_COMMON_QMAKE_CXXFLAGS
@@ -35,6 +35,10 @@ LIBS            += $$QHTTPSERVER_LIBS
 INCLUDEPATH     += $$QHAL_INCLUDEPATH
 LIBS            += $$QHAL_LIBS
 
+### zlib ###
+
+LIBS            += -lz
+
 ### Files ###
 
 HEADERS += \
@@ -44,7 +48,20 @@ HEADERS += \
     serializer.h \
     parser.h \
     haljsonserializer.h \
-    haljsonparser.h
+    haljsonparser.h \
+    chunkedresponsedevice.h \
+    responsewriter.h \
+    connectionmanager.h \
+    etagcache.h \
+    responsecache.h \
+    variantserializer.h \
+    variantparser.h \
+    cborserializer.h \
+    cborparser.h \
+    messagepackserializer.h \
+    messagepackparser.h \
+    responsecompression.h \
+    deflatestream.h
 
 SOURCES += \
     server.cpp \
@@ -53,4 +70,17 @@ SOURCES += \
     serializer.cpp \
     parser.cpp \
     haljsonserializer.cpp \
-    haljsonparser.cpp
+    haljsonparser.cpp \
+    chunkedresponsedevice.cpp \
+    responsewriter.cpp \
+    connectionmanager.cpp \
+    etagcache.cpp \
+    responsecache.cpp \
+    variantserializer.cpp \
+    variantparser.cpp \
+    cborserializer.cpp \
+    cborparser.cpp \
+    messagepackserializer.cpp \
+    messagepackparser.cpp \
+    responsecompression.cpp \
+    deflatestream.cpp
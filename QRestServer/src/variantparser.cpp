@@ -0,0 +1,91 @@
+#include "variantparser.h"
+
+#include "server.h"
+#include "linkhelper.h"
+
+#include <QDataSuite/metaobject.h>
+#include <QDataSuite/metaproperty.h>
+#include <QDataSuite/error.h>
+
+#include <QUrl>
+
+namespace QRestServer {
+
+static QUrl linkHref(const QVariant &link)
+{
+    return QUrl(link.toMap().value(QLatin1String("href")).toString());
+}
+
+VariantParser::VariantParser(const QString &format, const QString &contentType) :
+    Parser(format, contentType)
+{
+}
+
+VariantParser::~VariantParser()
+{
+}
+
+void VariantParser::parse(const QByteArray &data, QObject *object, Server *server, Parser::Mode mode) const
+{
+    resetLastError();
+
+    QString errorMessage;
+    QVariant document = decode(data, &errorMessage);
+
+    if(!errorMessage.isEmpty()) {
+        setLastError(QDataSuite::Error(QString("Parser error: %1").arg(errorMessage), QDataSuite::Error::ParserError));
+        return;
+    }
+
+    if(document.type() != QVariant::Map) {
+        setLastError(QDataSuite::Error(QString("Parser error: The document has to be a map."), QDataSuite::Error::ParserError));
+        return;
+    }
+
+    QVariantMap resource = document.toMap();
+    QDataSuite::MetaObject metaObject = QDataSuite::MetaObject::metaObject(object);
+
+    foreach(QDataSuite::MetaProperty property, metaObject.simpleProperties()) {
+        if(property.isPrimaryKey()
+                && mode != Create)
+            continue;
+
+        property.write(object, resource.value(property.name()));
+    }
+
+    QVariantMap links = resource.value(QLatin1String("_links")).toMap();
+    QMapIterator<QString, QVariant> it(links);
+    while(it.hasNext()) {
+        it.next();
+
+        if(!metaObject.hasMetaProperty(it.key()))
+            continue;
+
+        QDataSuite::MetaProperty property = metaObject.metaProperty(it.key());
+
+        if(!property.isValid())
+            continue;
+
+        if(it.value().type() == QVariant::List) {
+            if(!property.isToManyRelationProperty())
+                continue;
+
+            QList<QObject *> relatedObjects;
+            foreach(const QVariant &link, it.value().toList()) {
+                QObject *relatedObject = server->linkHelper()->resolveObjectLink(linkHref(link));
+                if(relatedObject)
+                    relatedObjects.append(relatedObject);
+            }
+            property.writeObjects(object, relatedObjects);
+        }
+        else {
+            if(!property.isToOneRelationProperty())
+                continue;
+
+            QObject *relatedObject = server->linkHelper()->resolveObjectLink(linkHref(it.value()));
+            property.writeObject(object, relatedObject);
+        }
+    }
+}
+
+} // namespace QRestServer
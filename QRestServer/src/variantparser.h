@@ -0,0 +1,31 @@
+#ifndef QRESTSERVER_VARIANTPARSER_H
+#define QRESTSERVER_VARIANTPARSER_H
+
+#include <QRestServer/parser.h>
+
+#include <QtCore/QVariant>
+
+namespace QRestServer {
+
+// Base class for formats, which decode to the same document structure as HAL.
+// Subclasses only have to implement the decoding of values.
+class VariantParser : public Parser
+{
+public:
+    ~VariantParser();
+
+    void parse(const QByteArray &data, QObject *object, Server *server, Mode mode) const Q_DECL_OVERRIDE;
+
+protected:
+    VariantParser(const QString &format, const QString &contentType);
+
+    // Returns an invalid variant and sets the error message, if the data can not be decoded
+    virtual QVariant decode(const QByteArray &data, QString *errorMessage) const = 0;
+
+private:
+    Q_DISABLE_COPY(VariantParser)
+};
+
+} // namespace QRestServer
+
+#endif // QRESTSERVER_VARIANTPARSER_H
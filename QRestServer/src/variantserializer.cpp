@@ -0,0 +1,214 @@
+#include "variantserializer.h"
+
+#include "server.h"
+#include "linkhelper.h"
+
+#include <QDataSuite/metaobject.h>
+#include <QDataSuite/metaproperty.h>
+#include <QDataSuite/error.h>
+#include <QDataSuite/abstractdataaccessobject.h>
+
+#include <QBuffer>
+#include <QUrl>
+
+namespace QRestServer {
+
+static QVariantMap link(const QUrl &href)
+{
+    QVariantMap result;
+    result.insert(QLatin1String("href"), href.toString());
+    return result;
+}
+
+VariantSerializer::VariantSerializer(const QString &format, const QString &contentType) :
+    Serializer(format, contentType)
+{
+}
+
+VariantSerializer::~VariantSerializer()
+{
+}
+
+QVariantMap VariantSerializer::objectToResource(const QObject *object, Server *server)
+{
+    QDataSuite::MetaObject metaObject = QDataSuite::MetaObject::metaObject(object);
+
+    QVariantMap resource;
+    QVariantMap links;
+    links.insert(QLatin1String("self"), link(server->linkHelper()->objectLink(object)));
+
+    // Properties
+    foreach(QDataSuite::MetaProperty property, metaObject.simpleProperties()) {
+        resource.insert(property.columnName(), property.read(object));
+    }
+
+    // Links
+    foreach(QDataSuite::MetaProperty property, metaObject.relationProperties()) {
+        if(property.isToOneRelationProperty()) {
+            QObject *relatedObject = property.readObject(object);
+
+            QUrl relatedUrl;
+            if(relatedObject)
+                relatedUrl = server->linkHelper()->objectLink(relatedObject);
+
+            links.insert(QLatin1String(property.name()), link(relatedUrl));
+        }
+        else if(property.isToManyRelationProperty()) {
+            QVariantList relatedLinks;
+            foreach(QObject *relatedObject, property.readObjects(object)) {
+                if(relatedObject)
+                    relatedLinks.append(link(server->linkHelper()->objectLink(relatedObject)));
+            }
+
+            links.insert(QLatin1String(property.name()), relatedLinks);
+        }
+    }
+
+    resource.insert(QLatin1String("_links"), links);
+    return resource;
+}
+
+QByteArray VariantSerializer::serialize(const QObject *object, Server *server) const
+{
+    resetLastError();
+
+    QVariantMap resource = objectToResource(object, server);
+
+    QDataSuite::MetaObject metaObject = QDataSuite::MetaObject::metaObject(object);
+    QDataSuite::AbstractDataAccessObject *collection = server->collection(metaObject.collectionName());
+
+    QVariantMap links = resource.value(QLatin1String("_links")).toMap();
+    links.insert(QLatin1String("collection"), link(server->linkHelper()->collectionLink(collection)));
+    resource.insert(QLatin1String("_links"), links);
+
+    QBuffer buffer;
+    buffer.open(QIODevice::WriteOnly);
+    writeVariant(&buffer, resource);
+    return buffer.data();
+}
+
+QByteArray VariantSerializer::serialize(const QDataSuite::Error &error) const
+{
+    QVariantMap result;
+    result.insert(QLatin1String("text"), error.text());
+    result.insert(QLatin1String("type"), error.type());
+
+    QMapIterator<QString, QVariant> it(error.additionalInformation());
+    while(it.hasNext()) {
+        it.next();
+        result.insert(it.key(), it.value());
+    }
+
+    QBuffer buffer;
+    buffer.open(QIODevice::WriteOnly);
+    writeVariant(&buffer, result);
+    return buffer.data();
+}
+
+QByteArray VariantSerializer::serialize(const QDataSuite::AbstractDataAccessObject *collection, Server *server) const
+{
+    QBuffer buffer;
+    buffer.open(QIODevice::WriteOnly);
+
+    if(!serialize(collection, server, &buffer))
+        return QByteArray();
+
+    return buffer.data();
+}
+
+bool VariantSerializer::serialize(const QDataSuite::AbstractDataAccessObject *collection,
+                                  Server *server,
+                                  QIODevice *device) const
+{
+    resetLastError();
+
+    // Arrays are prefixed with their size, so the size is taken before the first page is read.
+    // Objects inserted meanwhile are left out and removed ones are written as null.
+    int count = collection->count();
+    if(collection->lastError().isValid()) {
+        setLastError(collection->lastError());
+        return false;
+    }
+
+    QList<QObject *> page = readNextPage(collection, QList<QObject *>());
+    if(lastError().isValid())
+        return false;
+
+    writeMapHeader(device, 3);
+
+    writeVariant(device, QLatin1String("_embedded"));
+    writeMapHeader(device, 1);
+    writeVariant(device, collection->dataSuiteMetaObject().collectionName());
+    writeArrayHeader(device, count);
+
+    int written = 0;
+    forever {
+        foreach(QObject *object, page) {
+            if(written == count)
+                break;
+
+            writeVariant(device, objectToResource(object, server));
+            ++written;
+        }
+
+        if(written == count || page.size() < StreamPageSize)
+            break;
+
+        page = readNextPage(collection, page);
+        if(lastError().isValid())
+            return false;
+    }
+
+    for(; written < count; ++written)
+        writeVariant(device, QVariant());
+
+    QVariantMap linksMap;
+    linksMap.insert(QLatin1String("self"), link(server->linkHelper()->collectionLink(collection)));
+
+    writeVariant(device, QLatin1String("_links"));
+    writeVariant(device, linksMap);
+
+    writeVariant(device, QLatin1String("count"));
+    writeVariant(device, count);
+
+    return true;
+}
+
+bool VariantSerializer::serialize(const QDataSuite::AbstractDataAccessObject *collection,
+                                  const QList<QObject *> &objects,
+                                  const QMap<QString, QUrl> &links,
+                                  Server *server,
+                                  QIODevice *device) const
+{
+    resetLastError();
+
+    QVariantMap linksMap;
+    linksMap.insert(QLatin1String("self"), link(server->linkHelper()->collectionLink(collection)));
+
+    QMapIterator<QString, QUrl> it(links);
+    while(it.hasNext()) {
+        it.next();
+        linksMap.insert(it.key(), link(it.value()));
+    }
+
+    // Like the HAL serializer, only one object at a time is converted
+    writeMapHeader(device, 3);
+
+    writeVariant(device, QLatin1String("_embedded"));
+    writeMapHeader(device, 1);
+    writeVariant(device, collection->dataSuiteMetaObject().collectionName());
+    writeArrayHeader(device, objects.size());
+    foreach(QObject *object, objects) {
+        writeVariant(device, objectToResource(object, server));
+    }
+
+    writeVariant(device, QLatin1String("_links"));
+    writeVariant(device, linksMap);
+
+    writeVariant(device, QLatin1String("count"));
+    writeVariant(device, objects.size());
+
+    return true;
+}
+
+} // namespace QRestServer
@@ -0,0 +1,46 @@
+#ifndef QRESTSERVER_VARIANTSERIALIZER_H
+#define QRESTSERVER_VARIANTSERIALIZER_H
+
+#include <QRestServer/serializer.h>
+
+#include <QtCore/QVariant>
+
+namespace QRestServer {
+
+// Base class for formats, which encode the same document structure as HAL
+// ("_links", "_embedded" and the properties) in a generic map/array/value model.
+// Subclasses only have to implement the encoding of values.
+class VariantSerializer : public Serializer
+{
+public:
+    ~VariantSerializer();
+
+    QByteArray serialize(const QObject *object, Server *server) const Q_DECL_OVERRIDE;
+    QByteArray serialize(const QDataSuite::Error &error) const Q_DECL_OVERRIDE;
+    QByteArray serialize(const QDataSuite::AbstractDataAccessObject *collection,
+                         Server *server) const Q_DECL_OVERRIDE;
+    bool serialize(const QDataSuite::AbstractDataAccessObject *collection,
+                   Server *server,
+                   QIODevice *device) const Q_DECL_OVERRIDE;
+    bool serialize(const QDataSuite::AbstractDataAccessObject *collection,
+                   const QList<QObject *> &objects,
+                   const QMap<QString, QUrl> &links,
+                   Server *server,
+                   QIODevice *device) const Q_DECL_OVERRIDE;
+
+    static QVariantMap objectToResource(const QObject *object, Server *server);
+
+protected:
+    VariantSerializer(const QString &format, const QString &contentType);
+
+    virtual void writeVariant(QIODevice *device, const QVariant &value) const = 0;
+    virtual void writeArrayHeader(QIODevice *device, int size) const = 0;
+    virtual void writeMapHeader(QIODevice *device, int size) const = 0;
+
+private:
+    Q_DISABLE_COPY(VariantSerializer)
+};
+
+} // namespace QRestServer
+
+#endif // QRESTSERVER_VARIANTSERIALIZER_H
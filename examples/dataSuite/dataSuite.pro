@@ -12,7 +12,7 @@ include(../seriesModel/seriesModel.pri)
 TARGET          = datasuite_example
 VERSION         = 0.0.0
 TEMPLATE        = app
-QT              += sql widgets
+QT              += sql widgets concurrent
 CONFIG          += c++11
 QMAKE_CXXFLAGS  += $$QDATASUITE_COMMON_QMAKE_CXXFLAGS
 
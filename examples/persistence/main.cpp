@@ -20,9 +20,24 @@ int main(int argc, char *argv[])
         qCritical() << db.lastError();
     }
 
-    // Register types
-    QDataSuite::registerMetaObject<Series>();
-    QDataSuite::registerMetaObject<Season>();
+    // Register types. The accessors spare the meta object system when reading and writing.
+    QDataSuite::registerMetaObject<Series>()
+            .property("tvdbId", &Series::tvdbId, &Series::setTvdbId)
+            .property("title", &Series::title, &Series::setTitle)
+            .property("absolutePath", &Series::absolutePath, &Series::setAbsolutePath)
+            .property("imdbId", &Series::imdbId, &Series::setImdbId)
+            .property("overview", &Series::overview, &Series::setOverview)
+            .property("firstAired", &Series::firstAired, &Series::setFirstAired)
+            .property("genres", &Series::genres, &Series::setGenres)
+            .property("actors", &Series::actors, &Series::setActors)
+            .property("bannerUrls", &Series::bannerUrls, &Series::setBannerUrls)
+            .property("posterUrls", &Series::posterUrls, &Series::setPosterUrls)
+            .property("seasons", &Series::seasons, &Series::setSeasons);
+    QDataSuite::registerMetaObject<Season>()
+            .property("tvdbId", &Season::tvdbId, &Season::setTvdbId)
+            .property("number", &Season::number, &Season::setNumber)
+            .property("absolutePath", &Season::absolutePath, &Season::setAbsolutePath)
+            .property("series", &Season::series, &Season::setSeries);
     QPersistence::PersistentDataAccessObject<Series> seriesDao(db);
     QPersistence::PersistentDataAccessObject<Season> seasonDao(db);
     QDataSuite::registerDataAccessObject<Series>(&seriesDao, db.connectionName());
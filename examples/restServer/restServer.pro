@@ -15,7 +15,7 @@ include(../seriesModel/seriesModel.pri)
 TARGET          = restserver_example
 VERSION         = 0.0.0
 TEMPLATE        = app
-QT              += sql widgets network
+QT              += sql widgets network concurrent
 CONFIG          += static c++11
 QMAKE_CXXFLAGS  += $$QDATASUITE_COMMON_QMAKE_CXXFLAGS
 
@@ -28,6 +28,8 @@ class Series : public QObject
     Q_CLASSINFO(QDATASUITE_PRIMARYKEY, "tvdbId")
     Q_CLASSINFO("QDATASUITE_PROPERTYMETADATA:seasons",
                 "reverserelation=series;")
+    Q_CLASSINFO("QDATASUITE_SQL_INDEX:title",
+                "columns=title,firstAired;")
 
 public:
     explicit Series(QObject *parent = 0);
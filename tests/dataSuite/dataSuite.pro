@@ -0,0 +1,26 @@
+QDATASUITE_PATH = ../../QDataSuite
+include($$QDATASUITE_PATH/QDataSuite.pri)
+
+
+### General config ###
+
+TARGET          = tst_datasuite
+TEMPLATE        = app
+QT              += testlib concurrent
+QT              -= gui
+CONFIG          += c++11 testcase
+QMAKE_CXXFLAGS  += $$QDATASUITE_COMMON_QMAKE_CXXFLAGS
+
+
+### QDataSuite ###
+
+INCLUDEPATH     += $$QDATASUITE_INCLUDEPATH
+LIBS            += $$QDATASUITE_LIBS
+
+
+### Files ###
+
+HEADERS +=
+
+SOURCES += \
+    tst_cacheddataaccessobject.cpp
@@ -0,0 +1,216 @@
+#include <QDataSuite/cacheddataaccessobject.h>
+#include <QDataSuite/error.h>
+#include <QDataSuite/metaobject.h>
+
+#include <QPointer>
+#include <QtTest>
+
+class Item : public QObject
+{
+    Q_OBJECT
+    Q_PROPERTY(int id READ id WRITE setId)
+
+    Q_CLASSINFO(QDATASUITE_PRIMARYKEY, "id")
+
+public:
+    explicit Item(QObject *parent = 0) : QObject(parent), m_id(0) {}
+
+    int id() const { return m_id; }
+    void setId(int id) { m_id = id; }
+
+private:
+    int m_id;
+};
+
+// Creates a new item with the keys 1 to count for every read, like a database would
+class ItemSource : public QDataSuite::AbstractDataAccessObject
+{
+public:
+    explicit ItemSource(int count) : m_count(count) {}
+
+    QDataSuite::MetaObject dataSuiteMetaObject() const Q_DECL_OVERRIDE
+    {
+        return QDataSuite::MetaObject::metaObject(Item::staticMetaObject);
+    }
+
+    int count() const Q_DECL_OVERRIDE { return m_count; }
+
+    QList<QVariant> allKeys() const Q_DECL_OVERRIDE
+    {
+        QList<QVariant> result;
+        for(int i = 1; i <= m_count; ++i) {
+            result.append(i);
+        }
+        return result;
+    }
+
+    QList<QObject *> readAllObjects() const Q_DECL_OVERRIDE
+    {
+        QList<QObject *> result;
+        for(int i = 1; i <= m_count; ++i) {
+            result.append(readObject(i));
+        }
+        return result;
+    }
+
+    QObject *createObject() const Q_DECL_OVERRIDE { return new Item; }
+
+    QObject *readObject(const QVariant &key) const Q_DECL_OVERRIDE
+    {
+        resetLastError();
+
+        int id = key.toInt();
+        if(id < 1 || id > m_count) {
+            setLastError(QDataSuite::Error("No such item", QDataSuite::Error::StorageError));
+            return 0;
+        }
+
+        ++reads[id];
+        Item *item = new Item;
+        item->setId(id);
+        return item;
+    }
+
+    bool insertObject(QObject *const) Q_DECL_OVERRIDE { return true; }
+    bool updateObject(QObject *const) Q_DECL_OVERRIDE { return true; }
+    bool removeObject(QObject *const) Q_DECL_OVERRIDE { return true; }
+
+    // How often each key has been read
+    mutable QHash<int, int> reads;
+
+private:
+    int m_count;
+};
+
+class CachedDataAccessObjectTest : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void initTestCase();
+    void init();
+    void cleanup();
+
+    void evictsLeastRecentlyUsedObjects();
+    void keepsPinnedObjects();
+    void keepsSharedObjects();
+    void readsPagesFromTheSource();
+
+private:
+    ItemSource *m_source;
+    QDataSuite::CachedDataAccessObject<Item> *m_cache;
+};
+
+void CachedDataAccessObjectTest::initTestCase()
+{
+    QDataSuite::registerMetaObject<Item>();
+}
+
+void CachedDataAccessObjectTest::init()
+{
+    m_source = new ItemSource(10);
+    m_cache = new QDataSuite::CachedDataAccessObject<Item>(m_source);
+}
+
+void CachedDataAccessObjectTest::cleanup()
+{
+    delete m_cache;
+    delete m_source;
+}
+
+void CachedDataAccessObjectTest::evictsLeastRecentlyUsedObjects()
+{
+    m_cache->setMaximumCount(2);
+
+    QPointer<Item> first = m_cache->read(1);
+    QVERIFY(first);
+    QVERIFY(m_cache->read(2));
+    QCOMPARE(m_cache->read(1), first.data());
+    QVERIFY(m_cache->read(3));
+
+    // Objects are evicted at the beginning of the next call, so that the last result stays valid
+    QCOMPARE(m_cache->read(3)->id(), 3);
+    QCOMPARE(m_cache->evictions(), 1);
+    QCOMPARE(m_cache->cachedCount(), 2);
+
+    // 2 has been used least recently
+    QVERIFY(first);
+    QCOMPARE(m_cache->read(1), first.data());
+    QCOMPARE(m_source->reads.value(1), 1);
+
+    QVERIFY(m_cache->read(2));
+    QCOMPARE(m_source->reads.value(2), 2);
+}
+
+void CachedDataAccessObjectTest::keepsPinnedObjects()
+{
+    m_cache->setMaximumCount(1);
+    m_cache->pin(1);
+
+    QPointer<Item> pinned = m_cache->read(1);
+    for(int i = 2; i <= 5; ++i) {
+        QVERIFY(m_cache->read(i));
+    }
+    QVERIFY(m_cache->read(5));
+
+    QVERIFY(pinned);
+    QCOMPARE(m_cache->read(1), pinned.data());
+    QCOMPARE(m_source->reads.value(1), 1);
+    QVERIFY(m_cache->evictions() >= 3);
+
+    // Unpinned objects are evicted like any other
+    m_cache->unpin(1);
+    QVERIFY(m_cache->read(2));
+    QVERIFY(m_cache->read(2));
+    QVERIFY(!pinned);
+}
+
+void CachedDataAccessObjectTest::keepsSharedObjects()
+{
+    m_cache->setMaximumCount(1);
+
+    QSharedPointer<Item> shared = m_cache->readShared(1);
+    QVERIFY(shared);
+    QPointer<Item> item = shared.data();
+
+    QVERIFY(m_cache->read(2));
+    QVERIFY(m_cache->read(2));
+    QVERIFY(item);
+    QCOMPARE(m_cache->read(1), shared.data());
+    QCOMPARE(m_source->reads.value(1), 1);
+
+    shared.clear();
+    QVERIFY(item);
+    QVERIFY(m_cache->read(2));
+    QVERIFY(m_cache->read(2));
+    QVERIFY(!item);
+}
+
+void CachedDataAccessObjectTest::readsPagesFromTheSource()
+{
+    m_cache->setMaximumCount(5);
+
+    QPointer<Item> cached = m_cache->read(2);
+    QList<QObject *> page = m_cache->readObjects(0, 3);
+    QCOMPARE(page.size(), 3);
+
+    // Objects, which are already cached, are returned instead of the ones read by the source
+    QCOMPARE(page.at(1), static_cast<QObject *>(cached.data()));
+    QCOMPARE(qobject_cast<Item *>(page.at(0))->id(), 1);
+    QCOMPARE(qobject_cast<Item *>(page.at(2))->id(), 3);
+
+    page = m_cache->readObjectsAfter(3, 3);
+    QCOMPARE(page.size(), 3);
+    QCOMPARE(qobject_cast<Item *>(page.at(0))->id(), 4);
+    QCOMPARE(qobject_cast<Item *>(page.at(2))->id(), 6);
+    QVERIFY(!m_cache->lastError().isValid());
+
+    // The pages count against the maximum like everything else
+    QVERIFY(m_cache->read(6));
+    QVERIFY(m_cache->cachedCount() <= 5);
+    QVERIFY(m_cache->evictions() > 0);
+}
+
+QTEST_GUILESS_MAIN(CachedDataAccessObjectTest)
+
+#include "tst_cacheddataaccessobject.moc"
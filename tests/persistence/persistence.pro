@@ -0,0 +1,42 @@
+QDATASUITE_PATH = ../../QDataSuite
+include($$QDATASUITE_PATH/QDataSuite.pri)
+
+QPERSISTENCE_PATH = ../../QPersistence
+include($$QPERSISTENCE_PATH/QPersistence.pri)
+
+include(../../examples/seriesModel/seriesModel.pri)
+
+
+### General config ###
+
+TARGET          = tst_persistence
+TEMPLATE        = app
+QT              += sql testlib concurrent
+QT              -= gui
+CONFIG          += c++11 testcase
+QMAKE_CXXFLAGS  += $$QDATASUITE_COMMON_QMAKE_CXXFLAGS
+
+
+### QDataSuite ###
+
+INCLUDEPATH     += $$QDATASUITE_INCLUDEPATH
+LIBS            += $$QDATASUITE_LIBS
+
+
+### QPersistence ###
+
+INCLUDEPATH     += $$QPERSISTENCE_INCLUDEPATH
+LIBS            += $$QPERSISTENCE_LIBS
+
+
+### seriesModel ###
+
+INCLUDEPATH     += $$SERIESMODEL_INCLUDEPATH
+
+
+### Files ###
+
+HEADERS +=
+
+SOURCES += \
+    tst_persistence.cpp
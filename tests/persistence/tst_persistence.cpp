@@ -0,0 +1,198 @@
+#include <seriesModel/seriesmodel.h>
+
+#include <QPersistence/databaseschema.h>
+#include <QPersistence/persistentdataaccessobject.h>
+#include <QPersistence/sqlquerylog.h>
+#include <QDataSuite/error.h>
+
+#include <QSqlDatabase>
+#include <QtTest>
+
+// Counts the SELECTs, which are logged by QPersistence::SqlQueryLog
+static int selectCount = 0;
+static QtMessageHandler previousMessageHandler = 0;
+
+static void countSelects(QtMsgType type, const QMessageLogContext &context, const QString &message)
+{
+    if(qstrcmp(context.category, "qpersistence.sql") == 0) {
+        if(message.startsWith(QLatin1String("Query (")) && message.contains(QLatin1String("SELECT")))
+            ++selectCount;
+        return;
+    }
+
+    previousMessageHandler(type, context, message);
+}
+
+class PersistenceTest : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void initTestCase();
+    void cleanupTestCase();
+
+    void readAllLoadsRelationsInBatches();
+    void readObjectsPagesByOffset();
+    void readObjectsAfterKey();
+    void readObjectsAfterRemovedKey();
+
+private:
+    QSqlDatabase m_database;
+    QPersistence::PersistentDataAccessObject<Series> *m_seriesDao;
+    QPersistence::PersistentDataAccessObject<Season> *m_seasonDao;
+
+    // Creates series with the keys 1 to count, each with two seasons
+    void populate(int count);
+    // Reads all series and checks their seasons
+    void readAll(int expectedCount, int *selects);
+};
+
+// Returns the keys of the series of a page and deletes them
+static QList<int> takeKeys(const QList<QObject *> &page)
+{
+    QList<int> result;
+    foreach(QObject *object, page) {
+        Series *series = qobject_cast<Series *>(object);
+        result.append(series->tvdbId());
+        qDeleteAll(series->seasons());
+    }
+    qDeleteAll(page);
+    return result;
+}
+
+void PersistenceTest::initTestCase()
+{
+    m_database = QSqlDatabase::addDatabase("QSQLITE", "tst_persistence");
+    m_database.setDatabaseName(":memory:");
+    QVERIFY(m_database.open());
+
+    QDataSuite::registerMetaObject<Series>();
+    QDataSuite::registerMetaObject<Season>();
+    m_seriesDao = new QPersistence::PersistentDataAccessObject<Series>(m_database);
+    m_seasonDao = new QPersistence::PersistentDataAccessObject<Season>(m_database);
+    QDataSuite::registerDataAccessObject<Series>(m_seriesDao, m_database.connectionName());
+    QDataSuite::registerDataAccessObject<Season>(m_seasonDao, m_database.connectionName());
+
+    QPersistence::SqlQueryLog::setSlowQueryThreshold(60000);
+    QPersistence::SqlQueryLog::setSamplingRate(1);
+    previousMessageHandler = qInstallMessageHandler(countSelects);
+}
+
+void PersistenceTest::cleanupTestCase()
+{
+    qInstallMessageHandler(previousMessageHandler);
+    QPersistence::SqlQueryLog::setLevel(QPersistence::SqlQueryLog::Off);
+}
+
+void PersistenceTest::populate(int count)
+{
+    QPersistence::DatabaseSchema schema(m_database);
+    schema.createCleanSchema();
+    QVERIFY(!schema.lastError().isValid());
+
+    for(int i = 1; i <= count; ++i) {
+        QScopedPointer<Series> series(m_seriesDao->create());
+        series->setTvdbId(i);
+        series->setTitle(QString("Series %1").arg(i));
+        QVERIFY2(m_seriesDao->insert(series.data()), qPrintable(m_seriesDao->lastError().text()));
+
+        for(int j = 1; j <= 2; ++j) {
+            QScopedPointer<Season> season(m_seasonDao->create());
+            season->setTvdbId(i * 10 + j);
+            season->setNumber(j);
+            season->setSeries(series.data());
+            QVERIFY2(m_seasonDao->insert(season.data()), qPrintable(m_seasonDao->lastError().text()));
+        }
+    }
+}
+
+void PersistenceTest::readAll(int expectedCount, int *selects)
+{
+    QPersistence::SqlQueryLog::setLevel(QPersistence::SqlQueryLog::AllQueries);
+    selectCount = 0;
+    QList<Series *> allSeries = m_seriesDao->readAll();
+    *selects = selectCount;
+    QPersistence::SqlQueryLog::setLevel(QPersistence::SqlQueryLog::Off);
+
+    QVERIFY(!m_seriesDao->lastError().isValid());
+    QCOMPARE(allSeries.size(), expectedCount);
+
+    foreach(Series *series, allSeries) {
+        QList<Season *> seasons = series->seasons();
+        QCOMPARE(seasons.size(), 2);
+
+        foreach(Season *season, seasons) {
+            QCOMPARE(season->tvdbId() / 10, series->tvdbId());
+            QCOMPARE(season->series(), series);
+        }
+
+        qDeleteAll(seasons);
+    }
+    qDeleteAll(allSeries);
+}
+
+void PersistenceTest::readAllLoadsRelationsInBatches()
+{
+    int selectsOfThree = 0;
+    populate(3);
+    QVERIFY(!QTest::currentTestFailed());
+    readAll(3, &selectsOfThree);
+    QVERIFY(!QTest::currentTestFailed());
+    QVERIFY(selectsOfThree > 0);
+
+    // Related objects are read by one query per relation, not one per object
+    int selectsOfTwenty = 0;
+    populate(20);
+    QVERIFY(!QTest::currentTestFailed());
+    readAll(20, &selectsOfTwenty);
+    QVERIFY(!QTest::currentTestFailed());
+    QCOMPARE(selectsOfTwenty, selectsOfThree);
+    QVERIFY(selectsOfTwenty < 20);
+}
+
+void PersistenceTest::readObjectsPagesByOffset()
+{
+    populate(7);
+    QVERIFY(!QTest::currentTestFailed());
+
+    QCOMPARE(takeKeys(m_seriesDao->readObjects(0, 3)), QList<int>() << 1 << 2 << 3);
+    QCOMPARE(takeKeys(m_seriesDao->readObjects(3, 3)), QList<int>() << 4 << 5 << 6);
+    QCOMPARE(takeKeys(m_seriesDao->readObjects(6, 3)), QList<int>() << 7);
+    QCOMPARE(takeKeys(m_seriesDao->readObjects(9, 3)), QList<int>());
+    QVERIFY(!m_seriesDao->lastError().isValid());
+}
+
+void PersistenceTest::readObjectsAfterKey()
+{
+    populate(7);
+    QVERIFY(!QTest::currentTestFailed());
+
+    QCOMPARE(takeKeys(m_seriesDao->readObjectsAfter(0, 3)), QList<int>() << 1 << 2 << 3);
+    QCOMPARE(takeKeys(m_seriesDao->readObjectsAfter(3, 3)), QList<int>() << 4 << 5 << 6);
+    QCOMPARE(takeKeys(m_seriesDao->readObjectsAfter(6, 3)), QList<int>() << 7);
+    QCOMPARE(takeKeys(m_seriesDao->readObjectsAfter(7, 3)), QList<int>());
+
+    // Keys arrive as strings from URLs
+    QCOMPARE(takeKeys(m_seriesDao->readObjectsAfter(QString("5"), 3)), QList<int>() << 6 << 7);
+    QVERIFY(!m_seriesDao->lastError().isValid());
+}
+
+void PersistenceTest::readObjectsAfterRemovedKey()
+{
+    populate(7);
+    QVERIFY(!QTest::currentTestFailed());
+
+    QScopedPointer<Series> series(m_seriesDao->read(4));
+    QVERIFY(series);
+    QVERIFY(m_seriesDao->remove(series.data()));
+    qDeleteAll(series->seasons());
+
+    // A page continues after a key, which has been removed since the last page
+    QCOMPARE(takeKeys(m_seriesDao->readObjectsAfter(4, 2)), QList<int>() << 5 << 6);
+    QCOMPARE(takeKeys(m_seriesDao->readObjectsAfter(3, 2)), QList<int>() << 5 << 6);
+    QVERIFY(!m_seriesDao->lastError().isValid());
+}
+
+QTEST_GUILESS_MAIN(PersistenceTest)
+
+#include "tst_persistence.moc"
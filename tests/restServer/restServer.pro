@@ -0,0 +1,51 @@
+QDATASUITE_PATH = ../../QDataSuite
+include($$QDATASUITE_PATH/QDataSuite.pri)
+
+QRESTSERVER_PATH = ../../QRestServer
+include($$QRESTSERVER_PATH/QRestServer.pri)
+
+QHAL_PATH = ../../QRestServer/lib/QHal
+include($$QHAL_PATH/QHal.pri)
+
+
+### General config ###
+
+TARGET          = tst_restserver
+TEMPLATE        = app
+QT              += network testlib concurrent
+QT              -= gui
+CONFIG          += static c++11 testcase
+QMAKE_CXXFLAGS  += $$QDATASUITE_COMMON_QMAKE_CXXFLAGS
+
+
+### QDataSuite ###
+
+INCLUDEPATH     += $$QDATASUITE_INCLUDEPATH
+LIBS            += $$QDATASUITE_LIBS
+
+
+### QRestServer ###
+
+# The serializers are not part of the public headers
+INCLUDEPATH     += $$QRESTSERVER_INCLUDEPATH $$QRESTSERVER_PATH/src
+LIBS            += $$QRESTSERVER_LIBS
+
+
+### QHttpServer ###
+
+INCLUDEPATH     += $$QHTTPSERVER_INCLUDEPATH
+LIBS            += $$QHTTPSERVER_LIBS
+
+
+### QHAL ###
+
+LIBS            += $$QHAL_LIBS
+INCLUDEPATH     += $$QHAL_INCLUDEPATH
+
+
+### Files ###
+
+HEADERS +=
+
+SOURCES += \
+    tst_contentnegotiation.cpp
@@ -0,0 +1,112 @@
+#include <QRestServer/responsecompression.h>
+#include <QRestServer/serializer.h>
+
+#include <cborserializer.h>
+#include <messagepackserializer.h>
+
+#include <QtTest>
+
+Q_DECLARE_METATYPE(QRestServer::ResponseCompression::Encoding)
+
+class ContentNegotiationTest : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void initTestCase();
+    void cleanupTestCase();
+
+    void serializerForAccept_data();
+    void serializerForAccept();
+    void encodingForAcceptEncoding_data();
+    void encodingForAcceptEncoding();
+    void encodingWithoutCompression();
+
+private:
+    QRestServer::Serializer *m_cborSerializer;
+    QRestServer::Serializer *m_messagePackSerializer;
+};
+
+void ContentNegotiationTest::initTestCase()
+{
+    m_cborSerializer = new QRestServer::CborSerializer;
+    m_messagePackSerializer = new QRestServer::MessagePackSerializer;
+    QRestServer::Serializer::registerSerializer(m_cborSerializer);
+    QRestServer::Serializer::registerSerializer(m_messagePackSerializer);
+    QRestServer::Serializer::setDefaultSerializer(m_cborSerializer);
+}
+
+void ContentNegotiationTest::cleanupTestCase()
+{
+    delete m_messagePackSerializer;
+    delete m_cborSerializer;
+}
+
+void ContentNegotiationTest::serializerForAccept_data()
+{
+    QTest::addColumn<QString>("accept");
+    // The format of the expected serializer, or an empty string, if there is none
+    QTest::addColumn<QString>("format");
+    QTest::addColumn<bool>("acceptable");
+
+    QTest::newRow("empty") << "" << "cbor" << true;
+    QTest::newRow("cbor") << "application/cbor" << "cbor" << true;
+    QTest::newRow("msgpack") << "application/msgpack" << "msgpack" << true;
+    QTest::newRow("case") << "Application/MsgPack" << "msgpack" << true;
+    QTest::newRow("quality") << "application/cbor;q=0.5, application/msgpack" << "msgpack" << true;
+    QTest::newRow("quality with spaces") << "application/msgpack; q=0.2, application/cbor; q=0.8" << "cbor" << true;
+    QTest::newRow("excluded") << "application/msgpack;q=0, application/cbor;q=0.1" << "cbor" << true;
+    QTest::newRow("wildcard") << "*/*" << "cbor" << true;
+    QTest::newRow("type wildcard") << "text/html, application/*;q=0.5" << "cbor" << true;
+    QTest::newRow("fallback") << "text/html, application/msgpack;q=0.1" << "msgpack" << true;
+    QTest::newRow("unacceptable") << "text/html, image/*" << "" << false;
+}
+
+void ContentNegotiationTest::serializerForAccept()
+{
+    QFETCH(QString, accept);
+    QFETCH(QString, format);
+    QFETCH(bool, acceptable);
+
+    QRestServer::Serializer *serializer = QRestServer::Serializer::forContentType(accept);
+    QCOMPARE(serializer != 0, acceptable);
+    if(serializer)
+        QCOMPARE(serializer->format(), format);
+}
+
+void ContentNegotiationTest::encodingForAcceptEncoding_data()
+{
+    QTest::addColumn<QString>("acceptEncoding");
+    QTest::addColumn<QRestServer::ResponseCompression::Encoding>("encoding");
+
+    QTest::newRow("empty") << "" << QRestServer::ResponseCompression::Identity;
+    QTest::newRow("identity") << "identity" << QRestServer::ResponseCompression::Identity;
+    QTest::newRow("gzip") << "gzip" << QRestServer::ResponseCompression::Gzip;
+    QTest::newRow("x-gzip") << "x-gzip" << QRestServer::ResponseCompression::Gzip;
+    QTest::newRow("deflate") << "deflate" << QRestServer::ResponseCompression::Deflate;
+    QTest::newRow("tie") << "deflate, gzip" << QRestServer::ResponseCompression::Gzip;
+    QTest::newRow("quality") << "gzip;q=0.5, deflate" << QRestServer::ResponseCompression::Deflate;
+    QTest::newRow("excluded") << "gzip;q=0" << QRestServer::ResponseCompression::Identity;
+    QTest::newRow("wildcard") << "*" << QRestServer::ResponseCompression::Gzip;
+    QTest::newRow("wildcard exclusion") << "deflate;q=0.5, *;q=0" << QRestServer::ResponseCompression::Deflate;
+}
+
+void ContentNegotiationTest::encodingForAcceptEncoding()
+{
+    QFETCH(QString, acceptEncoding);
+    QFETCH(QRestServer::ResponseCompression::Encoding, encoding);
+
+    QRestServer::ResponseCompression compression;
+    QCOMPARE(compression.encodingForRequest(acceptEncoding), encoding);
+}
+
+void ContentNegotiationTest::encodingWithoutCompression()
+{
+    QRestServer::ResponseCompression compression;
+    compression.setThreshold(-1);
+    QCOMPARE(compression.encodingForRequest("gzip, deflate"), QRestServer::ResponseCompression::Identity);
+}
+
+QTEST_GUILESS_MAIN(ContentNegotiationTest)
+
+#include "tst_contentnegotiation.moc"
@@ -0,0 +1,4 @@
+TEMPLATE = subdirs
+
+CONFIG += ordered
+SUBDIRS = dataSuite persistence restServer